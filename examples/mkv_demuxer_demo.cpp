@@ -18,9 +18,10 @@
 #include <set>
 #include <string>
 
-#include "lmcore/mapped_file.h"
 #include "lmmkv/lmmkv_logger.h"
 #include "lmmkv/mkv_demuxer.h"
+#include "lmmkv/mkv_file_source.h"
+#include "lmmkv/mkv_read_ahead.h"
 
 using namespace lmshao::lmmkv;
 
@@ -50,7 +51,10 @@ static std::set<uint64_t> ParseTrackList(const std::string &arg)
 int main(int argc, char **argv)
 {
     if (argc < 2) {
-        std::fprintf(stderr, "Usage: %s <input.mkv> [--tracks=N1,N2,...] [--outdir=DIR]\n", argv[0]);
+        std::fprintf(stderr,
+                     "Usage: %s <input.mkv> [--tracks=N1,N2,...] [--outdir=DIR] [--io=mmap|pread|uring] "
+                     "[--readahead=DEPTH]\n",
+                     argv[0]);
         return 1;
     }
 
@@ -59,12 +63,18 @@ int main(int argc, char **argv)
     std::string input_path = argv[1];
     std::set<uint64_t> track_filter_set;
     std::string outdir = ".";
+    std::string io = "mmap";
+    size_t readahead = 0;
     for (int i = 2; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg.rfind("--tracks=", 0) == 0) {
             track_filter_set = ParseTrackList(arg.substr(9));
         } else if (arg.rfind("--outdir=", 0) == 0) {
             outdir = arg.substr(9);
+        } else if (arg.rfind("--io=", 0) == 0) {
+            io = arg.substr(5);
+        } else if (arg.rfind("--readahead=", 0) == 0) {
+            readahead = std::stoul(arg.substr(12));
         }
     }
 
@@ -72,13 +82,25 @@ int main(int argc, char **argv)
     if (mkdir(outdir.c_str(), 0755) != 0) {
         // ignore EEXIST
     }
-    auto mf = lmshao::lmcore::MappedFile::Open(input_path);
-    if (!mf || !mf->IsValid()) {
+    // mmap: the whole mapping is pushed through Consume(); pread/uring: frames are pulled with ReadPacket(),
+    // or with --readahead pushed through Consume() while a background thread reads ahead
+    std::shared_ptr<MmapByteSource> mapped;
+    std::shared_ptr<IByteSource> source;
+    if (io == "pread") {
+        source = PreadByteSource::Open(input_path);
+    } else if (io == "uring") {
+        source = IoUringByteSource::Open(input_path);
+        if (!source) {
+            std::fprintf(stderr, "io_uring unavailable, using pread\n");
+            source = PreadByteSource::Open(input_path);
+        }
+    } else {
+        source = mapped = MmapByteSource::Open(input_path);
+    }
+    if (!source) {
         std::fprintf(stderr, "Failed to open: %s\n", input_path.c_str());
         return 1;
     }
-    const uint8_t *data = mf->Data();
-    size_t size = mf->Size();
 
     // Per-track output files
     std::map<uint64_t, std::ofstream> outputs;
@@ -158,7 +180,29 @@ int main(int argc, char **argv)
     }
 
     demuxer.SetListener(listener);
-    (void)demuxer.Consume(data, size);
+    if (mapped) {
+        (void)demuxer.Consume(mapped->Data(), mapped->Size());
+    } else if (readahead > 0) {
+        MkvReadAheadOptions options;
+        options.depth = readahead;
+        MkvReadAhead reader(source, options);
+        reader.Start(0);
+        const uint8_t *chunk = nullptr;
+        size_t chunk_size = 0;
+        while (reader.Next(chunk, chunk_size)) {
+            (void)demuxer.Consume(chunk, chunk_size);
+        }
+        MkvReadAheadStats stats = reader.Stats();
+        printf("Read-ahead: %llu bytes in %llu buffers, %llu stalls (%.3f ms waiting for I/O)\n",
+               (unsigned long long)stats.bytes_read, (unsigned long long)stats.buffers,
+               (unsigned long long)stats.stalls, stats.stall_ns / 1e6);
+    } else if (demuxer.Open(source) >= 0) {
+        MkvPacket packet;
+        while (demuxer.ReadPacket(packet) == 1) {
+            listener->OnFrame(packet);
+        }
+        listener->OnEndOfStream();
+    }
     demuxer.Stop();
 
     for (auto &kv : outputs) {
@@ -9,8 +9,8 @@
 #include <cstdio>
 #include <cstring>
 
-#include "lmcore/mapped_file.h"
 #include "lmmkv/matroska_parser.h"
+#include "lmmkv/mkv_file_source.h"
 
 int main(int argc, char **argv)
 {
@@ -20,17 +20,16 @@ int main(int argc, char **argv)
     }
 
     const std::string path = argv[1];
-    auto mf = lmshao::lmcore::MappedFile::Open(path);
-    if (!mf || !mf->IsValid()) {
+    // Reads only the EBML header, SeekHead and Info blocks of the file
+    auto source = lmshao::lmmkv::PreadByteSource::Open(path);
+    if (!source) {
         printf("Cannot open input file: %s", path.c_str());
         return 2;
     }
 
     lmshao::lmmkv::MatroskaParser parser;
     lmshao::lmmkv::MatroskaInfo info;
-    const uint8_t *data = mf->Data();
-    size_t size = mf->Size();
-    if (!parser.ParseBuffer(data, size, info)) {
+    if (!parser.ParseSource(*source, info)) {
         printf("Parse failed for: %s", path.c_str());
         return 3;
     }
@@ -0,0 +1,68 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "lmmkv/mkv_file_source.h"
+#include "lmmkv/mkv_remuxer.h"
+#include "lmmkv/mkv_writer.h"
+
+using namespace lmshao::lmmkv;
+
+static int64_t SecondsToNs(const char *s)
+{
+    return static_cast<int64_t>(std::strtod(s, nullptr) * 1e9);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 4) {
+        std::fprintf(stderr, "Usage: %s [-ss <sec>] [-to <sec>] <input.mkv> [...] -o <output.mkv>\n", argv[0]);
+        std::fprintf(stderr, "Trims each input to [-ss, -to) and joins them without re-encoding\n");
+        return 1;
+    }
+
+    MkvMuxerOptions opts;
+    opts.write_cues = true;
+    opts.write_seek_head = true;
+    MkvRemuxer remuxer(opts);
+    std::string output;
+    int64_t start_ns = 0;
+    int64_t end_ns = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-ss") == 0 && i + 1 < argc) {
+            start_ns = SecondsToNs(argv[++i]);
+        } else if (std::strcmp(argv[i], "-to") == 0 && i + 1 < argc) {
+            end_ns = SecondsToNs(argv[++i]);
+        } else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+        } else {
+            auto source = PreadByteSource::Open(argv[i]);
+            if (!source || !remuxer.AddInput(source, start_ns, end_ns)) {
+                printf("Cannot open input file: %s\n", argv[i]);
+                return 2;
+            }
+            start_ns = 0;
+            end_ns = -1;
+        }
+    }
+
+    auto writer = output.empty() ? nullptr : MkvFileWriter::Open(output);
+    if (!writer) {
+        printf("Cannot create output file: %s\n", output.c_str());
+        return 2;
+    }
+    if (!remuxer.Run(writer.get())) {
+        printf("Remux failed\n");
+        return 3;
+    }
+    return 0;
+}
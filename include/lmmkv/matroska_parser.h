@@ -12,6 +12,8 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "lmmkv/mkv_byte_source.h"
+
 namespace lmshao::lmmkv {
 
 struct MatroskaInfo {
@@ -25,6 +27,9 @@ public:
     MatroskaParser() = default;
     // Parse from memory buffer without IO
     bool ParseBuffer(const uint8_t *data, size_t size, MatroskaInfo &info);
+    // Parse over a random-access source, reading only the EBML header, the
+    // SeekHead and Info regardless of file size
+    bool ParseSource(IByteSource &source, MatroskaInfo &info);
 };
 
 } // namespace lmshao::lmmkv
@@ -0,0 +1,66 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_MKV_BYTE_SOURCE_H
+#define LMSHAO_LMMKV_MKV_BYTE_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace lmshao::lmmkv {
+
+// Random-access view of an MKV input, used where the demuxer needs to read
+// outside the streamed data (Cues, cluster bisection).
+class IByteSource {
+public:
+    virtual ~IByteSource() = default;
+
+    // Copy up to size bytes at offset into dst; returns bytes read (0 at end or on error)
+    virtual size_t ReadAt(uint64_t offset, uint8_t *dst, size_t size) = 0;
+
+    // Total input length in bytes
+    virtual uint64_t Size() const = 0;
+
+    // Hint that [offset, offset + size) will be read soon (upcoming Clusters after a
+    // Seek or in ReadPacket()). Must not block; the default ignores it.
+    virtual void Prefetch(uint64_t offset, size_t size)
+    {
+        (void)offset;
+        (void)size;
+    }
+
+    // File descriptor the bytes are read from, or -1. Lets IMkvWriter::WriteFrom() copy
+    // ranges inside the kernel; the descriptor stays owned by the source.
+    virtual int FileDescriptor() const { return -1; }
+};
+
+// Byte source over a caller-owned memory buffer
+class MemoryByteSource final : public IByteSource {
+public:
+    MemoryByteSource(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    size_t ReadAt(uint64_t offset, uint8_t *dst, size_t size) override
+    {
+        if (offset >= size_)
+            return 0;
+        size_t n = size < size_ - offset ? size : static_cast<size_t>(size_ - offset);
+        std::memcpy(dst, data_ + offset, n);
+        return n;
+    }
+
+    uint64_t Size() const override { return size_; }
+
+private:
+    const uint8_t *data_;
+    size_t size_;
+};
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_MKV_BYTE_SOURCE_H
@@ -12,15 +12,34 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
 #include "lmcore/noncopyable.h"
+#include "lmmkv/mkv_byte_source.h"
 #include "lmmkv/mkv_listeners.h"
+#include "lmmkv/mkv_packetizer.h"
 
 namespace lmshao::lmmkv {
 
+// How frame payloads are delivered to the listener.
+enum class MkvOutputMode {
+    // Annex B (H.264/HEVC) / ADTS (AAC) copied into a contiguous buffer; one frame per lace
+    kConverted,
+    // Raw block payload, no conversion or copy. MkvFrame::data points into the
+    // buffer passed to Consume() (or an internal carry buffer for blocks split
+    // across calls) and is valid only during OnFrame. Laced blocks are emitted
+    // as one frame covering all laces, with MkvFrame::slices holding each lace.
+    kPassthrough,
+    // Annex B / ADTS as an iovec-style list in MkvFrame::slices (data is null,
+    // size is the total length). Start codes are static, parameter sets are owned
+    // by the track and NAL units point into the input; nothing is copied. Slices
+    // are valid only during OnFrame.
+    kSliced,
+};
+
 /**
  * @brief Matroska (MKV) Demuxer
  *
@@ -30,12 +49,34 @@ namespace lmshao::lmmkv {
 class MkvDemuxer final : public lmcore::NonCopyable {
 public:
     MkvDemuxer();
+    // Internal scratch (carry, de-lacing and conversion buffers) is drawn from
+    // resource and reused across frames; steady-state demuxing does not allocate.
+    explicit MkvDemuxer(std::pmr::memory_resource *resource);
     ~MkvDemuxer();
 
     // Class-based listener
     void SetListener(const std::shared_ptr<IMkvDemuxListener> &listener);
 
-    // Track filtering: only emit frames for selected tracks (empty = all)
+    // Output mode for subsequent frames (default kConverted)
+    void SetOutputMode(MkvOutputMode mode);
+
+    // Deliver frames through OnFrames() in batches of up to frames entries (0 = one
+    // OnFrame call per frame, the default). A batch is flushed when full, at each
+    // Cluster start, before other listener callbacks and before Consume() returns.
+    void SetFrameBatchSize(size_t frames);
+
+    // Keyframe-only output for thumbnails and trick play. Non-key SimpleBlocks are
+    // skipped after their first bytes (ReadPacket() does not read their payload);
+    // BlockGroups with a ReferenceBlock are dropped before de-lacing.
+    void SetKeyframesOnly(bool enable);
+
+    // Packetizer for tracks whose codec ID starts with codec_id_prefix, resolved when
+    // the track is discovered (register before Tracks are parsed). Later
+    // registrations take precedence; unmatched tracks use CreateDefaultPacketizer().
+    void RegisterPacketizer(const std::string &codec_id_prefix, MkvPacketizerFactory factory);
+
+    // Track filtering: only emit frames for selected tracks (empty = all). Blocks of
+    // other tracks are dropped after their header, before the payload is read.
     void SetTrackFilter(const std::vector<uint64_t> &tracks);
 
     // Lifecycle
@@ -43,11 +84,53 @@ public:
     void Stop();
     bool IsRunning() const;
 
-    // Parse data buffer (streaming)
+    // Parse data buffer (streaming). Input may be split at any byte; elements
+    // spanning calls are carried over internally. Corrupt data inside the Segment
+    // is dropped up to the next valid Cluster and reported via OnError with
+    // kMkvErrorResync. Returns bytes consumed, which is less than size only when
+    // parsing stopped on invalid data before the Segment.
     size_t Consume(const uint8_t *data, size_t size);
 
     void Reset();
 
+    // Random-access open: reads the EBML header and SeekHead, then jumps directly to
+    // Info, Tags, Tracks and Cues (emitting OnInfo/OnTrack) without walking the
+    // Segment. Returns the offset of the first Cluster, from which Consume() is fed
+    // next, or -1 on failure. Requires Start().
+    int64_t Open(const std::shared_ptr<IByteSource> &source);
+
+    // Optional random-access view of the same input. Seek() uses it to load Cues
+    // announced by the SeekHead and to bisect Clusters when there are no Cues.
+    void SetByteSource(const std::shared_ptr<IByteSource> &source);
+
+    // Position at the Cluster holding the nearest keyframe at or before target_ns.
+    // Returns the absolute byte offset from which Consume() must be fed next, or -1
+    // if no position is known (no Cues, byte source or streamed Clusters).
+    int64_t Seek(int64_t target_ns);
+
+    // Position at a known Cluster offset (absolute, inside the Segment), e.g. one found
+    // by a Cluster walk; Consume() is fed from offset next. Returns false if the
+    // Segment is not located yet or offset lies outside it.
+    bool SeekToOffset(uint64_t offset);
+
+    // Offline demux of a whole random-access input on worker threads (0 = one per
+    // core). Opens the source as Open() does, splits the Segment at Cluster
+    // boundaries (Cues when present, otherwise a header walk) and demuxes runs of
+    // Clusters in parallel. Frames reach the listener in file order on the calling
+    // thread; in kSliced mode each frame arrives as a single slice. Workers call
+    // source->ReadAt() concurrently, so it must be thread-safe. Returns false
+    // if the Segment cannot be opened. Requires Start().
+    bool DemuxParallel(const std::shared_ptr<IByteSource> &source, size_t threads = 0);
+
+    // Pull mode: parse the byte source set by Open()/SetByteSource() from the current
+    // position (first Cluster after Open(), target after Seek()) until the next frame.
+    // Returns 1 with packet filled, 0 at end of input, -1 on error. Payload pointers
+    // follow the output mode and stay valid until the next ReadPacket() call; reuse
+    // the same packet to keep its slice storage. No listener call or lock is taken
+    // per frame, so drive it from a single thread and do not mix it with Consume().
+    // Metadata and errors are still reported through the listener. Requires Start().
+    int ReadPacket(MkvPacket &packet);
+
 private:
     class Impl;
     std::unique_ptr<Impl> impl_;
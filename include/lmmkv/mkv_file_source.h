@@ -0,0 +1,123 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_MKV_FILE_SOURCE_H
+#define LMSHAO_LMMKV_MKV_FILE_SOURCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "lmmkv/mkv_byte_source.h"
+
+namespace lmshao::lmmkv {
+
+// Access hints for MmapByteSource
+struct MmapOptions {
+    bool sequential = true;  // MADV_SEQUENTIAL: aggressive readahead, pages behind the reader are dropped early
+    bool will_need = false;  // MADV_WILLNEED on the whole file at open (small files, or ones read repeatedly)
+    bool huge_pages = false; // MADV_HUGEPAGE where supported; fewer TLB misses on large mappings
+};
+
+/**
+ * @brief Byte source over a read-only memory mapping of a file
+ *
+ * Data() exposes the mapping for MkvDemuxer::Consume(); Prefetch() turns into
+ * MADV_WILLNEED on the covered pages. Safe to read from several threads.
+ */
+class MmapByteSource final : public IByteSource {
+public:
+    // nullptr when the file cannot be opened or mapped
+    static std::shared_ptr<MmapByteSource> Open(const std::string &path, const MmapOptions &options = {});
+    ~MmapByteSource() override;
+
+    size_t ReadAt(uint64_t offset, uint8_t *dst, size_t size) override;
+    uint64_t Size() const override { return size_; }
+    void Prefetch(uint64_t offset, size_t size) override;
+
+    const uint8_t *Data() const { return data_; }
+
+private:
+    MmapByteSource(const uint8_t *data, size_t size) : data_(data), size_(size) {}
+
+    const uint8_t *data_;
+    size_t size_;
+};
+
+/**
+ * @brief Byte source reading a file with pread() through one cached block
+ *
+ * Small reads (element headers, SeekHead, Cues probes) are served from an aligned
+ * block of block_size bytes; reads of a block or more go straight to the caller's
+ * buffer. Prefetch() maps to posix_fadvise(WILLNEED). Safe to read from several threads.
+ */
+class PreadByteSource final : public IByteSource {
+public:
+    static constexpr size_t kDefaultBlockSize = 64 * 1024;
+
+    // nullptr when the file cannot be opened
+    static std::shared_ptr<PreadByteSource> Open(const std::string &path, size_t block_size = kDefaultBlockSize);
+    ~PreadByteSource() override;
+
+    size_t ReadAt(uint64_t offset, uint8_t *dst, size_t size) override;
+    uint64_t Size() const override { return size_; }
+    void Prefetch(uint64_t offset, size_t size) override;
+    int FileDescriptor() const override { return fd_; }
+
+private:
+    PreadByteSource(int fd, uint64_t size, size_t block_size);
+
+    int fd_;
+    uint64_t size_;
+    std::mutex mutex_; // guards the cached block
+    std::vector<uint8_t> block_;
+    uint64_t blockOffset_ = 0;
+    size_t blockLen_ = 0;
+};
+
+/**
+ * @brief Byte source issuing reads through Linux io_uring
+ *
+ * A read is split into block_size requests with up to queue_depth of them in
+ * flight, so large reads (ReadPacket() windows, DemuxParallel() jobs) keep an NVMe
+ * queue busy. Prefetch() queues IORING_OP_FADVISE and returns without waiting.
+ * Only built on Linux with io_uring headers (LMMKV_WITH_IO_URING); Open() returns
+ * nullptr otherwise or when the kernel refuses the ring, so callers can fall back
+ * to PreadByteSource. Reads are serialized on the ring.
+ */
+class IoUringByteSource final : public IByteSource {
+public:
+    static constexpr unsigned kDefaultQueueDepth = 32;
+    static constexpr size_t kDefaultBlockSize = 128 * 1024;
+
+    static std::shared_ptr<IoUringByteSource> Open(const std::string &path, unsigned queue_depth = kDefaultQueueDepth,
+                                                   size_t block_size = kDefaultBlockSize);
+    ~IoUringByteSource() override;
+
+    size_t ReadAt(uint64_t offset, uint8_t *dst, size_t size) override;
+    uint64_t Size() const override { return size_; }
+    void Prefetch(uint64_t offset, size_t size) override;
+    int FileDescriptor() const override { return fd_; }
+
+private:
+    struct Ring;
+    IoUringByteSource(int fd, uint64_t size, size_t block_size, std::unique_ptr<Ring> ring);
+
+    int fd_;
+    uint64_t size_;
+    size_t blockSize_;
+    std::mutex mutex_;
+    std::unique_ptr<Ring> ring_;
+};
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_MKV_FILE_SOURCE_H
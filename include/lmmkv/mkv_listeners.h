@@ -26,6 +26,16 @@ public:
     // Called for each decoded (de-laced) frame
     virtual void OnFrame(const MkvFrame &frame) = 0;
 
+    // Batched frames, used instead of OnFrame when MkvDemuxer::SetFrameBatchSize() is
+    // non-zero. frames is a contiguous array valid only during the call; by default
+    // each entry is forwarded to OnFrame.
+    virtual void OnFrames(const MkvFrame *frames, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i) {
+            OnFrame(frames[i]);
+        }
+    }
+
     // End of stream or segment
     virtual void OnEndOfStream() = 0;
 
@@ -43,6 +53,23 @@ public:
     virtual void OnClusterStart(int64_t cluster_timecode_ns) = 0;
     virtual void OnClusterEnd(int64_t last_timecode_ns) = 0;
     virtual void OnError(int code, const std::string &msg) = 0;
+
+    // Live mode (MkvMuxerOptions::live): a unit of output has reached the writer and
+    // will not be patched, so a relay can forward [offset, offset + size) at once
+    virtual void OnChunk(const MkvChunk &chunk)
+    {
+        (void)chunk;
+    }
+
+    // Interleaving (MkvMuxerOptions::max_interleave_delta_ms): frames up to timecode_ns
+    // were written while stalled_track had none queued. Reported once per stall; frames
+    // of that track arriving later may follow newer frames of other tracks.
+    virtual void OnInterleaveFlush(MkvFlushReason reason, uint64_t stalled_track, int64_t timecode_ns)
+    {
+        (void)reason;
+        (void)stalled_track;
+        (void)timecode_ns;
+    }
 };
 
 } // namespace lmshao::lmmkv
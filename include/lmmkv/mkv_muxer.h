@@ -9,22 +9,66 @@
 #ifndef LMSHAO_LMMKV_MKV_MUXER_H
 #define LMSHAO_LMMKV_MKV_MUXER_H
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "lmcore/noncopyable.h"
 #include "lmmkv/mkv_listeners.h"
 #include "lmmkv/mkv_types.h"
+#include "lmmkv/mkv_writer.h"
 
 namespace lmshao::lmmkv {
 
 struct MkvMuxerOptions {
     uint64_t timecode_scale_ns = 1000000;
+    std::string doc_type = "matroska"; // "webm" for WebM players and MSE
+    // Live output (MSE, relays): the Segment and Clusters keep unknown sizes and nothing
+    // is patched, so no SeekHead, Cues or Duration are written and lacing is off. Each
+    // block reaches the writer from WriteFrame() and is reported by
+    // IMkvMuxListener::OnChunk(). With a video track, every video keyframe starts a
+    // Cluster and Clusters are cut nowhere else (int16 timecode overflow aside).
+    bool live = false;
+    // SeekHead (Info, Tracks, Cues) filled in by EndSegment() into space reserved
+    // after the Segment header; needs a seekable writer
     bool write_seek_head = false;
+    // Cues for video keyframes (first block of each Cluster without video), written
+    // by EndSegment()
     bool write_cues = false;
+    // Void reserved after Tracks for the Cues (0 = none). Cues that fit are written
+    // there, near the front of the file; otherwise they are appended.
+    uint32_t cues_reserve_bytes = 0;
     uint32_t cluster_duration_ms = 1000;
     uint32_t cluster_size_bytes = 2 * 1024 * 1024;
+    // Lace consecutive audio frames into one SimpleBlock, choosing fixed, Xiph or EBML
+    // lacing per block by size. Applies to audio tracks with a DefaultDuration
+    // (metadata "default_duration_ns"), as laced frames share one timecode. Frames
+    // are copied while held back, and a laced block may follow blocks of other tracks
+    // by up to max_lace_duration_ms.
     bool enable_lacing = false;
+    uint32_t max_lace_frames = 8;       // frames per lace, at most 256
+    uint32_t max_lace_duration_ms = 100; // media time per lace, bounds the added latency
+    // Interleaving for inputs whose tracks arrive with different jitter (0 = off, frames
+    // are written as they arrive). Frames are copied into per-track queues and written
+    // in timestamp order once every track has one queued. When a track stalls, frames
+    // are written anyway as soon as the queued ones span more than
+    // max_interleave_delta_ms or their payloads exceed interleave_buffer_bytes, which
+    // IMkvMuxListener::OnInterleaveFlush() reports.
+    uint32_t max_interleave_delta_ms = 0;
+    size_t interleave_buffer_bytes = 16 * 1024 * 1024;
+};
+
+// Cluster whose blocks are copied as stored (stream copy), see MkvMuxer::WriteRawCluster()
+struct MkvRawCluster {
+    int64_t timecode_ns = 0; // Cluster Timecode written in place of the original one
+    int64_t end_ns = 0;      // end of its last frame, for Duration
+    uint64_t offset = 0;     // Cluster children from the first block on, in the source
+    uint64_t size = 0;
+    // First block when it is a keyframe (0 = not known to be one), indexed with write_cues
+    uint64_t keyframe_track = 0;
+    int64_t keyframe_ns = 0;
 };
 
 class MkvMuxer final : public lmcore::NonCopyable {
@@ -33,15 +77,33 @@ public:
     ~MkvMuxer();
 
     void SetListener(IMkvMuxListener *listener);
-    // Writer interface will be provided by examples/utilities as needed
-    void SetWriter(void *writer);
+    // Output for the Segment; not owned, must outlive EndSegment(). Element sizes are
+    // back-patched through IMkvWriter::WriteAt() and stay unknown when it fails.
+    void SetWriter(IMkvWriter *writer);
 
+    // Tracks are added before BeginSegment(). AVC/HEVC tracks with metadata
+    // "stream_format" = "annexb" take Annex B frames, stored length-prefixed; with no
+    // codec_private, avcC/hvcC is built from the first SPS/PPS/VPS in the stream and
+    // the Segment header is written then (earlier frames of any track are dropped).
+    // FlagLacing is written as 0 for tracks the muxer does not lace, unless metadata
+    // "flag_lacing" = "1" says laced blocks may be copied in with WriteRawCluster().
     bool AddTrack(const MkvTrackInfo &track);
     bool BeginSegment(const MkvInfo &info);
+    // Frame payload in Matroska storage format (e.g. length-prefixed AVC): data/size,
+    // or the slices gathered in order when data is null. Written without copying.
     bool WriteFrame(const MkvFrame &frame);
+    // Close the current Cluster and append one whose blocks are cluster.size bytes of
+    // source, e.g. a Cluster of another Segment with the same tracks and timecode scale
+    // (block timecodes stay relative to the new Cluster Timecode). The bytes are passed
+    // to IMkvWriter::WriteFrom() and never parsed.
+    bool WriteRawCluster(const MkvRawCluster &cluster, IByteSource &source);
     bool EndSegment();
     void Reset();
 
+    // EBML header, Segment header, Info and Tracks as written (the MSE initialization
+    // segment); empty until the Segment header has been written
+    const std::vector<uint8_t> &InitSection() const;
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
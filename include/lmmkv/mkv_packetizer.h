@@ -0,0 +1,82 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_MKV_PACKETIZER_H
+#define LMSHAO_LMMKV_MKV_PACKETIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "lmmkv/mkv_types.h"
+
+namespace lmshao::lmmkv {
+
+using MkvSliceList = std::pmr::vector<MkvSlice>;
+
+// One frame payload as stored in its block. With header stripping (ContentEncoding)
+// the removed bytes come first as prefix, shared by every frame of the track.
+struct MkvPayload {
+    MkvSlice prefix{nullptr, 0};
+    MkvSlice data{nullptr, 0};
+
+    size_t Size() const { return prefix.second + data.second; }
+
+    uint8_t At(size_t i) const { return i < prefix.second ? prefix.first[i] : data.first[i - prefix.second]; }
+
+    // Append bytes [offset, offset + n) as one slice, or two when they span the prefix
+    void AppendRange(size_t offset, size_t n, MkvSliceList &out) const
+    {
+        if (offset < prefix.second) {
+            size_t head = n < prefix.second - offset ? n : prefix.second - offset;
+            out.emplace_back(prefix.first + offset, head);
+            offset += head;
+            n -= head;
+        }
+        if (n > 0) {
+            out.emplace_back(data.first + (offset - prefix.second), n);
+        }
+    }
+};
+
+/**
+ * @brief Converts the block payloads of one track to its output format
+ *
+ * Resolved once per track when Tracks are parsed and used for every frame in
+ * kConverted and kSliced modes. Built-in: Annex B for H.264/HEVC, ADTS for AAC
+ * and raw payloads for everything else (Opus, ...).
+ */
+class IMkvPacketizer {
+public:
+    // Bytes of per-frame header space passed to Packetize()
+    static constexpr size_t kMaxHeaderSize = 16;
+
+    virtual ~IMkvPacketizer() = default;
+
+    // Append the slices of one frame to out. Slices may point into payload (already
+    // decompressed), into storage owned by the packetizer (parameter sets, start
+    // codes) or into header, kMaxHeaderSize bytes that live as long as the frame.
+    // DemuxParallel() calls this from several threads at once, so it must not
+    // modify the packetizer.
+    virtual void Packetize(const MkvPayload &payload, bool keyframe, uint8_t *header, MkvSliceList &out) const = 0;
+};
+
+// Creates the packetizer for a newly discovered track; nullptr drops the track's
+// frames in kConverted and kSliced modes.
+using MkvPacketizerFactory = std::function<std::shared_ptr<IMkvPacketizer>(const MkvTrackInfo &track)>;
+
+// Built-in packetizer for a track: Annex B, ADTS or raw by codec ID.
+std::shared_ptr<IMkvPacketizer> CreateDefaultPacketizer(const MkvTrackInfo &track);
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_MKV_PACKETIZER_H
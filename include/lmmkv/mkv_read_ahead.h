@@ -0,0 +1,82 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_MKV_READ_AHEAD_H
+#define LMSHAO_LMMKV_MKV_READ_AHEAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "lmcore/noncopyable.h"
+#include "lmmkv/mkv_byte_source.h"
+
+namespace lmshao::lmmkv {
+
+struct MkvReadAheadOptions {
+    size_t buffer_size = 1024 * 1024; // bytes per read; rounded up to alignment
+    size_t depth = 2;                 // buffers in the ring (at least 2)
+    size_t alignment = 4096;          // buffer address and size alignment (O_DIRECT friendly)
+};
+
+struct MkvReadAheadStats {
+    uint64_t bytes_read = 0;
+    uint64_t buffers = 0;        // buffers filled
+    uint64_t stalls = 0;         // Next() calls that had to wait for the reader
+    uint64_t stall_ns = 0;       // time Next() spent waiting: I/O not hidden behind parsing
+    uint64_t read_ns = 0;        // time the reader spent in IByteSource::ReadAt()
+    uint64_t reader_idle_ns = 0; // time the reader waited for a free buffer: parsing is the bottleneck
+};
+
+/**
+ * @brief Reads a byte range on a background thread into a ring of aligned buffers
+ *
+ * While the caller parses one buffer (typically MkvDemuxer::Consume()), the
+ * reader fills the next depth - 1. Buffers are handed out in file order and
+ * returned to the reader on the following Next() call.
+ *
+ * @code
+ * MkvReadAhead reader(source);
+ * reader.Start(0);
+ * const uint8_t *data;
+ * size_t size;
+ * while (reader.Next(data, size)) {
+ *     demuxer.Consume(data, size);
+ * }
+ * @endcode
+ */
+class MkvReadAhead final : public lmcore::NonCopyable {
+public:
+    explicit MkvReadAhead(std::shared_ptr<IByteSource> source, const MkvReadAheadOptions &options = {});
+    ~MkvReadAhead();
+
+    // Start reading [offset, end) (end clamped to the source size), e.g. from the
+    // offset returned by MkvDemuxer::Seek(). Stops a previous run first.
+    bool Start(uint64_t offset = 0, uint64_t end = UINT64_MAX);
+
+    // Stop the reader thread and drop buffered data
+    void Stop();
+
+    // Next buffer in file order, valid until the following Next() or Stop().
+    // Returns false at the end of the range or on a read error.
+    bool Next(const uint8_t *&data, size_t &size);
+
+    // Absolute offset of the buffer returned by the last Next()
+    uint64_t Offset() const;
+
+    // Counters since Start()
+    MkvReadAheadStats Stats() const;
+
+private:
+    class Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_MKV_READ_AHEAD_H
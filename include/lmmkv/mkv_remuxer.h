@@ -0,0 +1,59 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_MKV_REMUXER_H
+#define LMSHAO_LMMKV_MKV_REMUXER_H
+
+#include <cstdint>
+#include <memory>
+
+#include "lmcore/noncopyable.h"
+#include "lmmkv/mkv_byte_source.h"
+#include "lmmkv/mkv_listeners.h"
+#include "lmmkv/mkv_muxer.h"
+#include "lmmkv/mkv_writer.h"
+
+namespace lmshao::lmmkv {
+
+/**
+ * @brief Stream-copy trim and concatenation of MKV files
+ *
+ * Inputs are written back to back as one Segment without touching the codec data.
+ * Clusters that lie wholly inside the kept time range are copied as stored
+ * (MkvMuxer::WriteRawCluster(), which hands them to IMkvWriter::WriteFrom()); only
+ * their Timecode and size are rewritten. The Clusters at the cut points are demuxed
+ * and their blocks re-serialised through MkvMuxer. Cuts start at the nearest video
+ * keyframe at or before the requested time.
+ */
+class MkvRemuxer final : public lmcore::NonCopyable {
+public:
+    // Muxer options for the output; timecode_scale_ns is taken from the first input
+    explicit MkvRemuxer(const MkvMuxerOptions &opts);
+    ~MkvRemuxer();
+
+    void SetListener(IMkvMuxListener *listener);
+
+    // Append [start_ns, end_ns) of source (end_ns < 0: to the end). Inputs are joined in
+    // the order added and must have the same Tracks; each starts where the previous one
+    // ended. Clusters of inputs with another timecode scale are re-serialised.
+    bool AddInput(const std::shared_ptr<IByteSource> &source, int64_t start_ns = 0, int64_t end_ns = -1);
+
+    // Write every input to writer, which must outlive the call. Returns false if an
+    // input cannot be opened, its Tracks differ from the first input's, or a write fails.
+    bool Run(IMkvWriter *writer);
+
+    void Reset();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_MKV_REMUXER_H
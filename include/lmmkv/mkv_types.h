@@ -17,10 +17,22 @@
 
 namespace lmshao::lmmkv {
 
+// Error codes reported through listener OnError callbacks.
+enum MkvErrorCode : int {
+    kMkvErrorInvalidData = 1,     // malformed EBML header or element overflowing its parent
+    kMkvErrorElementTooLarge = 2, // element too large to buffer across Consume() calls
+    kMkvErrorResync = 3,          // corrupt bytes skipped up to the next valid Cluster; message holds the range
+    kMkvErrorWriteFailed = 4,     // muxer output (IMkvWriter) rejected a write
+};
+
+// One contiguous piece of a payload; lists of slices describe gathered (iovec-style) data.
+using MkvSlice = std::pair<const uint8_t *, size_t>;
+
 // General MKV info parsed or to be written.
 struct MkvInfo {
-    uint64_t timecode_scale_ns = 1000000; // default 1ms
-    double duration_seconds = 0.0;        // optional in streaming
+    uint64_t timecode_scale_ns = 1000000;    // default 1ms
+    double duration_seconds = 0.0;           // optional in streaming
+    std::map<std::string, std::string> tags; // global SimpleTag name -> value
 };
 
 // Track description for demux/mux.
@@ -46,10 +58,40 @@ struct MkvTrackInfo {
 struct MkvFrame {
     uint64_t track_number = 0;
     int64_t timecode_ns = 0;
+    int64_t duration_ns = 0; // BlockDuration, else the track's DefaultDuration; 0 if unknown
     bool keyframe = false;
+    std::vector<int64_t> references_ns; // ReferenceBlock offsets from timecode_ns (BlockGroup only)
     const uint8_t *data = nullptr;
     size_t size = 0;
-    std::vector<std::pair<const uint8_t *, size_t>> slices;
+    std::vector<MkvSlice> slices;
+};
+
+// Frame returned by MkvDemuxer::ReadPacket(); same layout as the listener frame.
+using MkvPacket = MkvFrame;
+
+// Why the muxer's interleaver wrote frames before every track caught up, see
+// IMkvMuxListener::OnInterleaveFlush().
+enum class MkvFlushReason {
+    kMaxDelta,   // queued frames spanned more than max_interleave_delta_ms
+    kBufferFull, // queued payloads exceeded interleave_buffer_bytes
+};
+
+// Unit of live muxer output, see IMkvMuxListener::OnChunk().
+enum class MkvChunkType {
+    kInitSection,  // EBML header, Segment header, Info and Tracks
+    kClusterStart, // Cluster header and Timecode
+    kBlock,        // one SimpleBlock
+};
+
+struct MkvChunk {
+    MkvChunkType type = MkvChunkType::kBlock;
+    uint64_t offset = 0; // writer position of the first byte
+    uint64_t size = 0;
+    int64_t timecode_ns = 0;
+    uint64_t track_number = 0; // kBlock only
+    // kBlock: a keyframe. kClusterStart: the Cluster opens with a keyframe, so a new
+    // subscriber can start there after the init section.
+    bool keyframe = false;
 };
 
 } // namespace lmshao::lmmkv
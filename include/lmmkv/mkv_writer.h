@@ -0,0 +1,86 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_MKV_WRITER_H
+#define LMSHAO_LMMKV_MKV_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "lmmkv/mkv_byte_source.h"
+#include "lmmkv/mkv_types.h"
+
+namespace lmshao::lmmkv {
+
+// Output of MkvMuxer. Writes are gathered: a SimpleBlock arrives as its header
+// slice followed by the caller's payload slices, so nothing is copied on the way.
+class IMkvWriter {
+public:
+    virtual ~IMkvWriter() = default;
+
+    // Append the slices in order; slices are valid only during the call
+    virtual bool Write(const MkvSlice *slices, size_t count) = 0;
+
+    // Bytes written so far
+    virtual uint64_t Position() const = 0;
+
+    // Overwrite size bytes at an earlier offset (element sizes, Duration). Outputs
+    // that cannot seek return false and keep unknown sizes.
+    virtual bool WriteAt(uint64_t offset, const uint8_t *data, size_t size)
+    {
+        (void)offset;
+        (void)data;
+        (void)size;
+        return false;
+    }
+
+    // Append size bytes of source at offset (stream-copied Clusters). The default reads
+    // through a bounded buffer and calls Write().
+    virtual bool WriteFrom(IByteSource &source, uint64_t offset, uint64_t size);
+};
+
+// File output through writev() and pwrite(); stream copies stay in the kernel
+class MkvFileWriter final : public IMkvWriter {
+public:
+    // Create or truncate path; nullptr on failure
+    static std::shared_ptr<MkvFileWriter> Open(const std::string &path);
+    ~MkvFileWriter() override;
+
+    bool Write(const MkvSlice *slices, size_t count) override;
+    uint64_t Position() const override { return pos_; }
+    bool WriteAt(uint64_t offset, const uint8_t *data, size_t size) override;
+    // copy_file_range(), then sendfile(), when the source has a file descriptor
+    bool WriteFrom(IByteSource &source, uint64_t offset, uint64_t size) override;
+
+private:
+    explicit MkvFileWriter(int fd) : fd_(fd) {}
+
+    int fd_;
+    uint64_t pos_ = 0;
+};
+
+// Output collected in memory
+class MkvMemoryWriter final : public IMkvWriter {
+public:
+    bool Write(const MkvSlice *slices, size_t count) override;
+    uint64_t Position() const override { return data_.size(); }
+    bool WriteAt(uint64_t offset, const uint8_t *data, size_t size) override;
+
+    const std::vector<uint8_t> &Data() const { return data_; }
+    void Clear() { data_.clear(); }
+
+private:
+    std::vector<uint8_t> data_;
+};
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_MKV_WRITER_H
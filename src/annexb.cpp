@@ -0,0 +1,377 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "annexb.h"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LMMKV_SCAN_SSE2 1
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LMMKV_SCAN_AVX2 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LMMKV_SCAN_AVX2 1
+#define LMMKV_SCAN_AVX2_DISPATCH 1
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LMMKV_SCAN_NEON 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace lmshao::lmmkv {
+
+static inline unsigned CountTrailingZeros(uint64_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, v);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+}
+
+// Lanes of a NEON compare result as one nibble each
+#if defined(LMMKV_SCAN_NEON)
+static inline uint64_t NeonMask(uint8x16_t eq)
+{
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+}
+#endif
+
+// Remaining bytes (fewer than a vector, or no SIMD) one zero byte at a time
+static const uint8_t *FindStartCodeScalar(const uint8_t *p, const uint8_t *end)
+{
+    while (end - p >= 3) {
+        p = static_cast<const uint8_t *>(std::memchr(p, 0, static_cast<size_t>(end - p - 2)));
+        if (p == nullptr) {
+            return end;
+        }
+        if (p[1] == 0 && p[2] == 1) {
+            return p;
+        }
+        ++p;
+    }
+    return end;
+}
+
+#if defined(LMMKV_SCAN_AVX2)
+#if defined(LMMKV_SCAN_AVX2_DISPATCH)
+__attribute__((target("avx2")))
+#endif
+static const uint8_t *FindStartCodeAvx2(const uint8_t *p, const uint8_t *end)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i one = _mm256_set1_epi8(1);
+    while (end - p >= 32 + 2) {
+        __m256i z0 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), zero);
+        if (_mm256_movemask_epi8(z0) == 0) {
+            // No zero byte, so no start code begins in this block
+            p += 32;
+            continue;
+        }
+        __m256i eq = _mm256_and_si256(
+            z0, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1)), zero));
+        eq = _mm256_and_si256(eq, _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 2)), one));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(eq));
+        if (mask != 0) {
+            return p + CountTrailingZeros(mask);
+        }
+        p += 32;
+    }
+    return FindStartCodeScalar(p, end);
+}
+#endif
+
+#if defined(LMMKV_SCAN_SSE2)
+static const uint8_t *FindStartCodeSse2(const uint8_t *p, const uint8_t *end)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+    while (end - p >= 16 + 2) {
+        __m128i z0 = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), zero);
+        if (_mm_movemask_epi8(z0) == 0) {
+            // No zero byte, so no start code begins in this block
+            p += 16;
+            continue;
+        }
+        __m128i eq = _mm_and_si128(z0, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1)), zero));
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2)), one));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if (mask != 0) {
+            return p + CountTrailingZeros(mask);
+        }
+        p += 16;
+    }
+    return FindStartCodeScalar(p, end);
+}
+#endif
+
+#if defined(LMMKV_SCAN_NEON)
+static const uint8_t *FindStartCodeNeon(const uint8_t *p, const uint8_t *end)
+{
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const uint8x16_t one = vdupq_n_u8(1);
+    while (end - p >= 16 + 2) {
+        uint8x16_t z0 = vceqq_u8(vld1q_u8(p), zero);
+        if (NeonMask(z0) == 0) {
+            p += 16;
+            continue;
+        }
+        uint8x16_t eq = vandq_u8(z0, vceqq_u8(vld1q_u8(p + 1), zero));
+        eq = vandq_u8(eq, vceqq_u8(vld1q_u8(p + 2), one));
+        uint64_t mask = NeonMask(eq);
+        if (mask != 0) {
+            return p + CountTrailingZeros(mask) / 4;
+        }
+        p += 16;
+    }
+    return FindStartCodeScalar(p, end);
+}
+#endif
+
+const uint8_t *FindStartCode(const uint8_t *begin, const uint8_t *end)
+{
+#if defined(LMMKV_SCAN_AVX2_DISPATCH)
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2 ? FindStartCodeAvx2(begin, end) : FindStartCodeSse2(begin, end);
+#elif defined(LMMKV_SCAN_AVX2)
+    return FindStartCodeAvx2(begin, end);
+#elif defined(LMMKV_SCAN_SSE2)
+    return FindStartCodeSse2(begin, end);
+#elif defined(LMMKV_SCAN_NEON)
+    return FindStartCodeNeon(begin, end);
+#else
+    return FindStartCodeScalar(begin, end);
+#endif
+}
+
+void SplitAnnexB(const uint8_t *data, size_t size, std::vector<MkvSlice> &nals)
+{
+    nals.clear();
+    const uint8_t *end = data + size;
+    const uint8_t *p = FindStartCode(data, end);
+    while (p != end) {
+        const uint8_t *nal = p + 3;
+        const uint8_t *next = FindStartCode(nal, end);
+        // Drop trailing_zero_8bits and the leading zero of a 4-byte start code; a NAL
+        // unit never ends in a zero byte
+        const uint8_t *nal_end = next;
+        while (nal_end > nal && nal_end[-1] == 0) {
+            --nal_end;
+        }
+        if (nal_end > nal) {
+            nals.emplace_back(nal, static_cast<size_t>(nal_end - nal));
+        }
+        p = next;
+    }
+}
+
+namespace {
+
+// RBSP of a NAL unit: emulation prevention bytes (00 00 03) removed
+std::vector<uint8_t> ToRbsp(const std::vector<uint8_t> &nal)
+{
+    std::vector<uint8_t> rbsp;
+    rbsp.reserve(nal.size());
+    size_t zeros = 0;
+    for (uint8_t b : nal) {
+        if (zeros >= 2 && b == 0x03) {
+            zeros = 0;
+            continue;
+        }
+        zeros = b == 0 ? zeros + 1 : 0;
+        rbsp.push_back(b);
+    }
+    return rbsp;
+}
+
+// MSB-first bit reader with Exp-Golomb codes; reads past the end set a sticky error
+class BitReader {
+public:
+    BitReader(const std::vector<uint8_t> &data, size_t byte_offset) : data_(data), pos_(byte_offset * 8) {}
+
+    uint32_t Read(unsigned n)
+    {
+        uint32_t v = 0;
+        for (unsigned i = 0; i < n; ++i) {
+            if (pos_ >= data_.size() * 8) {
+                ok_ = false;
+                return 0;
+            }
+            v = (v << 1) | ((data_[pos_ / 8] >> (7 - pos_ % 8)) & 1);
+            ++pos_;
+        }
+        return v;
+    }
+
+    void Skip(size_t n) { pos_ += n; }
+
+    uint32_t ReadUe()
+    {
+        unsigned leading = 0;
+        while (Read(1) == 0 && ok_) {
+            if (++leading > 31) {
+                ok_ = false;
+                return 0;
+            }
+        }
+        return (uint32_t{1} << leading) - 1 + Read(leading);
+    }
+
+    bool Ok() const { return ok_ && pos_ <= data_.size() * 8; }
+
+private:
+    const std::vector<uint8_t> &data_;
+    size_t pos_;
+    bool ok_ = true;
+};
+
+void AppendU16(std::vector<uint8_t> &out, size_t v)
+{
+    out.push_back(static_cast<uint8_t>(v >> 8));
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+} // namespace
+
+bool BuildAvcC(const std::vector<std::vector<uint8_t>> &sps, const std::vector<std::vector<uint8_t>> &pps,
+               std::vector<uint8_t> &out)
+{
+    if (sps.empty() || sps[0].size() < 4) {
+        return false;
+    }
+    const std::vector<uint8_t> &first = sps[0];
+    size_t num_sps = sps.size() < 31 ? sps.size() : 31;
+    size_t num_pps = pps.size() < 255 ? pps.size() : 255;
+    out.clear();
+    out.push_back(1);        // configurationVersion
+    out.push_back(first[1]); // AVCProfileIndication
+    out.push_back(first[2]); // profile_compatibility
+    out.push_back(first[3]); // AVCLevelIndication
+    out.push_back(0xFF);     // lengthSizeMinusOne = 3
+    out.push_back(static_cast<uint8_t>(0xE0 | num_sps));
+    for (size_t i = 0; i < num_sps; ++i) {
+        AppendU16(out, sps[i].size());
+        out.insert(out.end(), sps[i].begin(), sps[i].end());
+    }
+    out.push_back(static_cast<uint8_t>(num_pps));
+    for (size_t i = 0; i < num_pps; ++i) {
+        AppendU16(out, pps[i].size());
+        out.insert(out.end(), pps[i].begin(), pps[i].end());
+    }
+
+    // High profiles carry chroma format and bit depths after the PPS array
+    uint8_t profile = first[1];
+    if (profile == 100 || profile == 110 || profile == 122 || profile == 144) {
+        std::vector<uint8_t> rbsp = ToRbsp(first);
+        BitReader br(rbsp, 4); // after NAL header, profile, constraints and level
+        br.ReadUe();           // seq_parameter_set_id
+        uint32_t chroma_format = br.ReadUe();
+        if (chroma_format == 3) {
+            br.Read(1); // separate_colour_plane_flag
+        }
+        uint32_t luma_depth = br.ReadUe();
+        uint32_t chroma_depth = br.ReadUe();
+        if (br.Ok() && chroma_format <= 3 && luma_depth <= 7 && chroma_depth <= 7) {
+            out.push_back(static_cast<uint8_t>(0xFC | chroma_format));
+            out.push_back(static_cast<uint8_t>(0xF8 | luma_depth));
+            out.push_back(static_cast<uint8_t>(0xF8 | chroma_depth));
+            out.push_back(0); // numOfSequenceParameterSetExt
+        }
+    }
+    return true;
+}
+
+bool BuildHvcC(const std::vector<std::vector<uint8_t>> &vps, const std::vector<std::vector<uint8_t>> &sps,
+               const std::vector<std::vector<uint8_t>> &pps, std::vector<uint8_t> &out)
+{
+    if (sps.empty()) {
+        return false;
+    }
+    std::vector<uint8_t> rbsp = ToRbsp(sps[0]);
+    // NAL header (2), then vps id (4 bits), max_sub_layers_minus1 (3), temporal_id_nesting (1)
+    // and the general profile_tier_level: 12 byte-aligned bytes copied as is into hvcC
+    if (rbsp.size() < 15) {
+        return false;
+    }
+    uint32_t max_sub_layers_minus1 = (rbsp[2] >> 1) & 0x07;
+    uint32_t temporal_id_nested = rbsp[2] & 0x01;
+
+    BitReader br(rbsp, 15);
+    bool profile_present[8] = {};
+    bool level_present[8] = {};
+    for (uint32_t i = 0; i < max_sub_layers_minus1; ++i) {
+        profile_present[i] = br.Read(1) != 0;
+        level_present[i] = br.Read(1) != 0;
+    }
+    if (max_sub_layers_minus1 > 0) {
+        br.Skip(2 * (8 - max_sub_layers_minus1)); // reserved_zero_2bits
+    }
+    for (uint32_t i = 0; i < max_sub_layers_minus1; ++i) {
+        br.Skip((profile_present[i] ? 88 : 0) + (level_present[i] ? 8 : 0));
+    }
+    br.ReadUe(); // sps_seq_parameter_set_id
+    uint32_t chroma_format = br.ReadUe();
+    if (chroma_format == 3) {
+        br.Read(1); // separate_colour_plane_flag
+    }
+    br.ReadUe(); // pic_width_in_luma_samples
+    br.ReadUe(); // pic_height_in_luma_samples
+    if (br.Read(1) != 0) {
+        for (int i = 0; i < 4; ++i) {
+            br.ReadUe(); // conformance window offsets
+        }
+    }
+    uint32_t luma_depth = br.ReadUe();
+    uint32_t chroma_depth = br.ReadUe();
+    if (!br.Ok() || chroma_format > 3 || luma_depth > 7 || chroma_depth > 7) {
+        return false;
+    }
+
+    out.clear();
+    out.push_back(1); // configurationVersion
+    // general profile space, tier and idc, compatibility flags, constraint flags and level
+    out.insert(out.end(), rbsp.begin() + 3, rbsp.begin() + 15);
+    AppendU16(out, 0xF000); // min_spatial_segmentation_idc = 0
+    out.push_back(0xFC);    // parallelismType = 0
+    out.push_back(static_cast<uint8_t>(0xFC | chroma_format));
+    out.push_back(static_cast<uint8_t>(0xF8 | luma_depth));
+    out.push_back(static_cast<uint8_t>(0xF8 | chroma_depth));
+    AppendU16(out, 0); // avgFrameRate
+    // constantFrameRate = 0, numTemporalLayers, temporalIdNested, lengthSizeMinusOne = 3
+    out.push_back(static_cast<uint8_t>(((max_sub_layers_minus1 + 1) << 3) | (temporal_id_nested << 2) | 0x03));
+
+    const std::pair<uint8_t, const std::vector<std::vector<uint8_t>> *> arrays[] = {
+        {kHevcNalVps, &vps}, {kHevcNalSps, &sps}, {kHevcNalPps, &pps}};
+    uint8_t num_arrays = 0;
+    for (const auto &a : arrays) {
+        num_arrays += a.second->empty() ? 0 : 1;
+    }
+    out.push_back(num_arrays);
+    for (const auto &a : arrays) {
+        if (a.second->empty()) {
+            continue;
+        }
+        out.push_back(static_cast<uint8_t>(0x80 | a.first)); // array_completeness = 1
+        AppendU16(out, a.second->size());
+        for (const auto &nal : *a.second) {
+            AppendU16(out, nal.size());
+            out.insert(out.end(), nal.begin(), nal.end());
+        }
+    }
+    return true;
+}
+
+} // namespace lmshao::lmmkv
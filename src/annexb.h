@@ -0,0 +1,62 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_ANNEXB_H
+#define LMSHAO_LMMKV_ANNEXB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "lmmkv/mkv_types.h"
+
+namespace lmshao::lmmkv {
+
+// H.264 NAL unit types
+static constexpr uint8_t kAvcNalSps = 7;
+static constexpr uint8_t kAvcNalPps = 8;
+static constexpr uint8_t kAvcNalAud = 9;
+
+// HEVC NAL unit types
+static constexpr uint8_t kHevcNalVps = 32;
+static constexpr uint8_t kHevcNalSps = 33;
+static constexpr uint8_t kHevcNalPps = 34;
+static constexpr uint8_t kHevcNalAud = 35;
+
+inline uint8_t AvcNalType(const uint8_t *nal)
+{
+    return nal[0] & 0x1F;
+}
+
+inline uint8_t HevcNalType(const uint8_t *nal)
+{
+    return (nal[0] >> 1) & 0x3F;
+}
+
+// First 00 00 01 start code prefix in [begin, end), or end. Vectorised with SSE2,
+// AVX2 (picked at run time on x86 GCC/Clang builds) or NEON.
+const uint8_t *FindStartCode(const uint8_t *begin, const uint8_t *end);
+
+// NAL units of an Annex B access unit, without start codes or trailing zero bytes.
+// Slices point into data; bytes before the first start code are ignored.
+void SplitAnnexB(const uint8_t *data, size_t size, std::vector<MkvSlice> &nals);
+
+// AVCDecoderConfigurationRecord (avcC) with 4-byte NAL lengths from SPS and PPS
+// NAL units. False if there is no SPS or it is too short.
+bool BuildAvcC(const std::vector<std::vector<uint8_t>> &sps, const std::vector<std::vector<uint8_t>> &pps,
+               std::vector<uint8_t> &out);
+
+// HEVCDecoderConfigurationRecord (hvcC) with 4-byte NAL lengths from VPS, SPS and
+// PPS NAL units; profile, tier, level, chroma format and bit depths come from the
+// first SPS. False if there is no SPS or it cannot be parsed.
+bool BuildHvcC(const std::vector<std::vector<uint8_t>> &vps, const std::vector<std::vector<uint8_t>> &sps,
+               const std::vector<std::vector<uint8_t>> &pps, std::vector<uint8_t> &out);
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_ANNEXB_H
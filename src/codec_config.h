@@ -0,0 +1,54 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_CODEC_CONFIG_H
+#define LMSHAO_LMMKV_CODEC_CONFIG_H
+
+#include <cstdint>
+#include <vector>
+
+namespace lmshao::lmmkv {
+
+static constexpr uint32_t kAacSampleRates[16] = {96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
+                                                 16000, 12000, 11025, 8000,  7350,  0,     0,     0};
+
+// Fields of an AAC AudioSpecificConfig needed for ADTS
+struct AacConfig {
+    uint8_t object_type = 2; // AAC LC
+    uint8_t sample_rate_index = 4;
+    uint32_t sample_rate = 44100;
+    uint8_t channel_config = 2;
+};
+
+// Sampling frequency index for rate, or 0xFF when it has none
+inline uint8_t AacSampleRateIndex(uint32_t rate)
+{
+    for (uint8_t i = 0; i < 13; ++i) {
+        if (kAacSampleRates[i] == rate) {
+            return i;
+        }
+    }
+    return 0xFF;
+}
+
+// AudioSpecificConfig (basic): object type, frequency index and channel configuration
+inline bool ParseAacConfig(const std::vector<uint8_t> &asc, AacConfig &cfg)
+{
+    if (asc.size() < 2) {
+        return false;
+    }
+    cfg.object_type = static_cast<uint8_t>((asc[0] >> 3) & 0x1F);
+    cfg.sample_rate_index = static_cast<uint8_t>(((asc[0] & 0x07) << 1) | ((asc[1] >> 7) & 0x01));
+    cfg.channel_config = static_cast<uint8_t>((asc[1] >> 3) & 0x0F);
+    cfg.sample_rate = kAacSampleRates[cfg.sample_rate_index];
+    return true;
+}
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_CODEC_CONFIG_H
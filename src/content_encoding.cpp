@@ -0,0 +1,195 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "content_encoding.h"
+
+#include <algorithm>
+
+#ifdef LMMKV_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "internal_logger.h"
+#include "mkv_schema.h"
+
+namespace lmshao::lmmkv {
+
+// Inflated frames start at this multiple of the compressed size and grow from there
+static constexpr size_t kInflateGrowth = 4;
+
+static void SkipElement(BufferCursor &cur, uint64_t size)
+{
+    size_t pos = cur.Tell();
+    cur.Seek(pos + static_cast<size_t>(size));
+}
+
+// ContentCompression: CompAlgo (default 0, zlib) and CompSettings
+static void ParseContentCompression(BufferCursor &cur, size_t size, ContentEncodingInfo &info)
+{
+    size_t end = cur.Tell() + size;
+    uint64_t algo = 0;
+    EbmlElementHeader sub{};
+    while (cur.Tell() < end) {
+        if (!NextElement(cur, sub) || sub.size > end - cur.Tell())
+            break;
+        switch (ElementOf(sub.id)) {
+            case MkvElement::kContentCompAlgo:
+                algo = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                break;
+            case MkvElement::kContentCompSettings: {
+                const uint8_t *p = cur.Take(static_cast<size_t>(sub.size));
+                if (p != nullptr) {
+                    info.header.assign(p, p + sub.size);
+                }
+                break;
+            }
+            default:
+                SkipElement(cur, sub.size);
+                break;
+        }
+    }
+    if (algo == 0) {
+#ifdef LMMKV_HAVE_ZLIB
+        info.compression = ContentCompression::kZlib;
+#else
+        LMMKV_LOGW("zlib-compressed track, but lmmkv was built without zlib; frames are delivered as stored");
+        info.compression = ContentCompression::kUnsupported;
+#endif
+    } else if (algo == 3) {
+        info.compression = ContentCompression::kHeaderStrip;
+    } else {
+        LMMKV_LOGW("Unsupported ContentCompAlgo %llu; frames are delivered as stored", (unsigned long long)algo);
+        info.compression = ContentCompression::kUnsupported;
+    }
+}
+
+void ParseContentEncodings(BufferCursor &cur, size_t size, ContentEncodingInfo &info)
+{
+    size_t end = cur.Tell() + size;
+    size_t count = 0;
+    EbmlElementHeader enc{};
+    while (cur.Tell() < end) {
+        if (!NextElement(cur, enc) || enc.size > end - cur.Tell())
+            break;
+        if (ElementOf(enc.id) != MkvElement::kContentEncoding || count++ > 0) {
+            SkipElement(cur, enc.size);
+            continue;
+        }
+        size_t enc_end = cur.Tell() + static_cast<size_t>(enc.size);
+        uint64_t type = 0;
+        uint64_t scope = 1;
+        EbmlElementHeader sub{};
+        while (cur.Tell() < enc_end) {
+            if (!NextElement(cur, sub) || sub.size > enc_end - cur.Tell())
+                break;
+            switch (ElementOf(sub.id)) {
+                case MkvElement::kContentEncodingType:
+                    type = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                    break;
+                case MkvElement::kContentEncodingScope:
+                    scope = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                    break;
+                case MkvElement::kContentCompression:
+                    ParseContentCompression(cur, static_cast<size_t>(sub.size), info);
+                    break;
+                default:
+                    SkipElement(cur, sub.size);
+                    break;
+            }
+        }
+        cur.Seek(enc_end);
+        if (type != 0) {
+            LMMKV_LOGW("Encrypted track (ContentEncodingType %llu); frames are delivered as stored",
+                       (unsigned long long)type);
+            info.compression = ContentCompression::kUnsupported;
+        }
+        info.frames = (scope & 0x01) != 0;
+        info.codec_private = (scope & 0x02) != 0;
+    }
+    if (count > 1) {
+        LMMKV_LOGW("%zu chained ContentEncodings; frames are delivered as stored", count);
+        info.compression = ContentCompression::kUnsupported;
+    }
+}
+
+#ifdef LMMKV_HAVE_ZLIB
+
+struct ZlibInflater::Stream {
+    z_stream zs{};
+    bool ready = false;
+};
+
+ZlibInflater::ZlibInflater() : stream_(new Stream) {}
+
+ZlibInflater::~ZlibInflater()
+{
+    if (stream_->ready) {
+        inflateEnd(&stream_->zs);
+    }
+}
+
+bool ZlibInflater::Inflate(const uint8_t *data, size_t size, std::pmr::vector<uint8_t> &buf, size_t &out_size)
+{
+    z_stream &zs = stream_->zs;
+    if (!stream_->ready) {
+        if (inflateInit(&zs) != Z_OK) {
+            LMMKV_LOGE("inflateInit failed");
+            return false;
+        }
+        stream_->ready = true;
+    } else if (inflateReset(&zs) != Z_OK) {
+        return false;
+    }
+
+    if (buf.size() < size * kInflateGrowth) {
+        buf.resize(size * kInflateGrowth);
+    }
+    zs.next_in = const_cast<Bytef *>(data);
+    zs.avail_in = static_cast<uInt>(size);
+    out_size = 0;
+    while (true) {
+        if (out_size == buf.size()) {
+            buf.resize(std::max<size_t>(buf.size() * 2, 4096));
+        }
+        zs.next_out = buf.data() + out_size;
+        zs.avail_out = static_cast<uInt>(buf.size() - out_size);
+        int ret = inflate(&zs, Z_NO_FLUSH);
+        out_size = buf.size() - zs.avail_out;
+        if (ret == Z_STREAM_END) {
+            return true;
+        }
+        if (ret != Z_OK && !(ret == Z_BUF_ERROR && zs.avail_out == 0)) {
+            LMMKV_LOGW("inflate failed: %d", ret);
+            return false;
+        }
+        if (zs.avail_in == 0 && zs.avail_out != 0) {
+            LMMKV_LOGW("Truncated zlib frame");
+            return false;
+        }
+    }
+}
+
+#else
+
+struct ZlibInflater::Stream {};
+
+ZlibInflater::ZlibInflater() = default;
+ZlibInflater::~ZlibInflater() = default;
+
+bool ZlibInflater::Inflate(const uint8_t *data, size_t size, std::pmr::vector<uint8_t> &buf, size_t &out_size)
+{
+    (void)data;
+    (void)size;
+    (void)buf;
+    out_size = 0;
+    return false;
+}
+
+#endif // LMMKV_HAVE_ZLIB
+
+} // namespace lmshao::lmmkv
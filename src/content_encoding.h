@@ -0,0 +1,67 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_CONTENT_ENCODING_H
+#define LMSHAO_LMMKV_CONTENT_ENCODING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include "ebml_reader.h"
+
+namespace lmshao::lmmkv {
+
+// ContentCompAlgo values
+enum class ContentCompression : uint8_t {
+    kNone,
+    kZlib,        // CompAlgo 0
+    kHeaderStrip, // CompAlgo 3: CompSettings bytes removed from the start of every frame
+    kUnsupported, // bzlib, lzo1x or encryption; frames are delivered as stored
+};
+
+// Compression of one track, from its ContentEncodings
+struct ContentEncodingInfo {
+    ContentCompression compression = ContentCompression::kNone;
+    bool frames = true;          // Scope bit 0: frame contents
+    bool codec_private = false;  // Scope bit 1: CodecPrivate
+    std::vector<uint8_t> header; // stripped bytes (kHeaderStrip)
+};
+
+// Parse a ContentEncodings payload of size bytes. Only the first encoding is applied;
+// chains of several encodings are reported as kUnsupported.
+void ParseContentEncodings(BufferCursor &cur, size_t size, ContentEncodingInfo &info);
+
+/**
+ * @brief Reusable zlib inflate context
+ *
+ * The stream is set up on first use and reset per frame; the output buffer only
+ * grows, so steady-state decoding does not allocate. Without zlib (LMMKV_HAVE_ZLIB
+ * unset) Inflate() always fails.
+ */
+class ZlibInflater {
+public:
+    ZlibInflater();
+    ~ZlibInflater();
+
+    ZlibInflater(const ZlibInflater &) = delete;
+    ZlibInflater &operator=(const ZlibInflater &) = delete;
+
+    // Inflate one zlib stream into buf[0, out_size); buf is grown as needed
+    bool Inflate(const uint8_t *data, size_t size, std::pmr::vector<uint8_t> &buf, size_t &out_size);
+
+private:
+    struct Stream;
+    std::unique_ptr<Stream> stream_;
+};
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_CONTENT_ENCODING_H
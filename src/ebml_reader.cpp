@@ -10,93 +10,112 @@
 
 #include <cstring>
 
-#include "internal_logger.h"
-
 namespace lmshao::lmmkv {
 
-// EBML varint width detection: leading 1 bit mask across first byte
-static inline int DetectVintWidth(uint8_t first)
+// All value bits set marks an unknown-size element
+static inline uint64_t MapUnknownSize(uint64_t value, size_t width)
 {
-    for (int i = 0; i < 8; ++i) {
-        if (first & (0x80 >> i)) {
-            return i + 1; // width in bytes
-        }
-    }
-    return -1; // invalid
+    return value == (1ULL << (7 * width)) - 1 ? kEbmlUnknownSize : value;
 }
 
-// BufferCursor versions
-static inline size_t ReadBytes(BufferCursor &cur, uint8_t *dst, size_t n)
+// Skip size bytes, clamped to the end of the buffer
+static inline void SkipClamped(BufferCursor &cur, size_t size)
 {
-    size_t r = cur.Read(dst, n);
-    if (r != n) {
-        LMMKV_LOGE("Failed to read %zu bytes, got %zu", n, r);
-    }
-    return r;
+    cur.Seek(size < cur.Remaining() ? cur.Tell() + size : cur.size_);
 }
 
-size_t ReadVintId(BufferCursor &cur, uint64_t &value)
+uint64_t ReadUnsignedBE(BufferCursor &cur, size_t size)
 {
-    uint8_t b0 = 0;
-    if (ReadBytes(cur, &b0, 1) != 1) {
+    size_t avail = cur.Remaining();
+    if (size > sizeof(uint64_t) || size > avail) {
+        SkipClamped(cur, size);
         return 0;
     }
-    int width = DetectVintWidth(b0);
-    if (width <= 0) {
-        LMMKV_LOGE("Invalid EBML ID leading byte: 0x%02X", b0);
-        return 0;
-    }
-    uint64_t v = b0;
-    for (int i = 1; i < width; ++i) {
-        uint8_t bi = 0;
-        if (ReadBytes(cur, &bi, 1) != 1) {
-            return 0;
-        }
-        v = (v << 8) | bi;
-    }
-    value = v;
-    return static_cast<size_t>(width);
+    uint64_t v = LoadBE(cur.Current(), size, avail);
+    cur.pos_ += size;
+    return v;
 }
 
-size_t ReadVintSize(BufferCursor &cur, uint64_t &value)
+int64_t ReadSignedBE(BufferCursor &cur, size_t size)
 {
-    uint8_t b0 = 0;
-    if (ReadBytes(cur, &b0, 1) != 1) {
-        return 0;
+    uint64_t v = ReadUnsignedBE(cur, size);
+    if (size == 0 || size >= sizeof(uint64_t)) {
+        return static_cast<int64_t>(v);
     }
-    int width = DetectVintWidth(b0);
-    if (width <= 0) {
-        LMMKV_LOGE("Invalid EBML size leading byte: 0x%02X", b0);
-        return 0;
+    // Sign-extend from the top bit of the payload
+    uint64_t sign = 1ULL << (size * 8 - 1);
+    return static_cast<int64_t>((v ^ sign) - sign);
+}
+
+double ReadFloatBE(BufferCursor &cur, size_t size)
+{
+    if (size == 4 && cur.Remaining() >= 4) {
+        uint32_t bits = static_cast<uint32_t>(LoadBE(cur.Current(), 4, cur.Remaining()));
+        cur.pos_ += 4;
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return static_cast<double>(f);
     }
-    // strip leading 1-bit
-    uint64_t v = static_cast<uint64_t>(b0 & (0xFF >> width));
-    for (int i = 1; i < width; ++i) {
-        uint8_t bi = 0;
-        if (ReadBytes(cur, &bi, 1) != 1) {
-            return 0;
-        }
-        v = (v << 8) | bi;
+    if (size == 8 && cur.Remaining() >= 8) {
+        uint64_t bits = LoadBE64(cur.Current());
+        cur.pos_ += 8;
+        double d;
+        std::memcpy(&d, &bits, sizeof(d));
+        return d;
     }
-    value = v;
-    return static_cast<size_t>(width);
+    SkipClamped(cur, size);
+    return 0.0;
+}
+
+size_t ReadVintId(BufferCursor &cur, uint64_t &value)
+{
+    size_t width = DecodeVint(cur.Current(), cur.Remaining(), true, value);
+    cur.pos_ += width;
+    return width;
+}
+
+size_t ReadVintSize(BufferCursor &cur, uint64_t &value)
+{
+    size_t width = DecodeVint(cur.Current(), cur.Remaining(), false, value);
+    cur.pos_ += width;
+    return width;
 }
 
 bool NextElement(BufferCursor &cur, EbmlElementHeader &out)
 {
-    uint64_t id = 0;
-    size_t id_len = ReadVintId(cur, id);
-    if (id_len == 0) {
-        return false;
-    }
-    uint64_t size = 0;
-    size_t size_len = ReadVintSize(cur, size);
-    if (size_len == 0) {
+    size_t header_len = 0;
+    if (ProbeElementHeader(cur.Current(), cur.Remaining(), out, header_len) != EbmlProbeResult::kOk) {
         return false;
     }
-    out.id = id;
-    out.size = size;
+    cur.pos_ += header_len;
     return true;
 }
 
+EbmlProbeResult ProbeElementHeader(const uint8_t *data, size_t size, EbmlElementHeader &out, size_t &header_len)
+{
+    if (size == 0) {
+        return EbmlProbeResult::kNeedMore;
+    }
+    size_t id_width = VintWidth(data[0]);
+    if (id_width == 0 || id_width > kEbmlMaxIdLength) {
+        return EbmlProbeResult::kInvalid;
+    }
+    if (size <= id_width) {
+        return EbmlProbeResult::kNeedMore;
+    }
+    size_t size_width = VintWidth(data[id_width]);
+    if (size_width == 0) {
+        return EbmlProbeResult::kInvalid;
+    }
+    size_t total = id_width + size_width;
+    if (size < total) {
+        return EbmlProbeResult::kNeedMore;
+    }
+    out.id = LoadBE(data, id_width, size);
+    uint64_t value = LoadBE(data + id_width, size_width, size - id_width) & ((1ULL << (7 * size_width)) - 1);
+    out.size = MapUnknownSize(value, size_width);
+    header_len = total;
+    return EbmlProbeResult::kOk;
+}
+
 } // namespace lmshao::lmmkv
\ No newline at end of file
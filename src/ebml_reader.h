@@ -11,6 +11,12 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <stdlib.h>
+#endif
 
 namespace lmshao::lmmkv {
 
@@ -19,6 +25,79 @@ struct EbmlElementHeader {
     uint64_t size;
 };
 
+// Matroska limits IDs to 4 bytes and sizes to 8 bytes
+static constexpr size_t kEbmlMaxIdLength = 4;
+static constexpr size_t kEbmlMaxSizeLength = 8;
+static constexpr size_t kEbmlMaxHeaderLength = kEbmlMaxIdLength + kEbmlMaxSizeLength;
+
+// Element size reported for the reserved all-ones size vint (live streams)
+static constexpr uint64_t kEbmlUnknownSize = ~0ULL;
+
+// Outcome of decoding a header from a buffer that may end mid-element
+enum class EbmlProbeResult {
+    kOk,
+    kNeedMore, // buffer ends inside the header
+    kInvalid,  // bytes cannot start an element header
+};
+
+// Width in bytes (1..8) of the vint whose first byte is first, or 0 for 0x00
+inline size_t VintWidth(uint8_t first)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    return _BitScanReverse(&index, first) ? static_cast<size_t>(8 - index) : 0;
+#else
+    return first ? static_cast<size_t>(__builtin_clz(first)) - 23 : 0;
+#endif
+}
+
+// Eight bytes at p as a big-endian value: one unaligned load and a byte swap
+inline uint64_t LoadBE64(const uint8_t *p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return v;
+#elif defined(_MSC_VER)
+    return _byteswap_uint64(v);
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+// Big-endian value of the n (0..8) bytes at p, where avail bytes are readable.
+// Uses a single 8-byte load whenever the buffer allows it.
+inline uint64_t LoadBE(const uint8_t *p, size_t n, size_t avail)
+{
+    if (n == 0) {
+        return 0;
+    }
+    if (avail >= sizeof(uint64_t)) {
+        return LoadBE64(p) >> (64 - 8 * n);
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; ++i) {
+        v = (v << 8) | p[i];
+    }
+    return v;
+}
+
+// Decode the vint at p; keep_marker keeps the length marker bit (element IDs).
+// Returns the width, or 0 if the vint is invalid or extends past avail.
+inline size_t DecodeVint(const uint8_t *p, size_t avail, bool keep_marker, uint64_t &value)
+{
+    if (avail == 0) {
+        return 0;
+    }
+    size_t width = VintWidth(p[0]);
+    if (width == 0 || width > avail) {
+        return 0;
+    }
+    uint64_t v = LoadBE(p, width, avail);
+    value = keep_marker ? v : v & ((1ULL << (7 * width)) - 1);
+    return width;
+}
+
 // Buffer-only cursor for sequential reading over memory
 struct BufferCursor {
     const uint8_t *data_;
@@ -27,15 +106,24 @@ struct BufferCursor {
     BufferCursor(const uint8_t *d, size_t s) : data_(d), size_(s), pos_(0) {}
     size_t Read(uint8_t *dst, size_t n)
     {
-        size_t remain = (pos_ < size_) ? (size_ - pos_) : 0;
-        size_t to_read = n < remain ? n : remain;
+        size_t to_read = n < Remaining() ? n : Remaining();
         if (to_read > 0) {
-            for (size_t i = 0; i < to_read; ++i)
-                dst[i] = data_[pos_ + i];
+            std::memcpy(dst, data_ + pos_, to_read);
             pos_ += to_read;
         }
         return to_read;
     }
+    // Zero-copy view of the next n bytes; advances past them, or returns null and
+    // stays put when fewer remain
+    const uint8_t *Take(size_t n)
+    {
+        if (n > Remaining()) {
+            return nullptr;
+        }
+        const uint8_t *p = data_ + pos_;
+        pos_ += n;
+        return p;
+    }
     bool Seek(size_t offset)
     {
         if (offset > size_)
@@ -44,17 +132,35 @@ struct BufferCursor {
         return true;
     }
     size_t Tell() const { return pos_; }
+    size_t Remaining() const { return pos_ < size_ ? size_ - pos_ : 0; }
+    const uint8_t *Current() const { return data_ + pos_; }
 };
 
+// Read a big-endian unsigned integer payload of size bytes (0 and skipped if
+// size exceeds 8 or the buffer).
+uint64_t ReadUnsignedBE(BufferCursor &cur, size_t size);
+
+// Read a big-endian two's complement integer payload of size bytes (0 and skipped
+// if size exceeds 8 or the buffer).
+int64_t ReadSignedBE(BufferCursor &cur, size_t size);
+
+// Read a big-endian IEEE float payload of 4 or 8 bytes (0.0 and skipped otherwise).
+double ReadFloatBE(BufferCursor &cur, size_t size);
+
 // Read EBML varint for element ID; keeps leading 1-bit.
 size_t ReadVintId(BufferCursor &cur, uint64_t &value);
 
 // Read EBML varint for element size; strips leading 1-bit.
 size_t ReadVintSize(BufferCursor &cur, uint64_t &value);
 
-// Parse next element header from current position.
+// Parse next element header from current position; an all-ones size is
+// reported as kEbmlUnknownSize.
 bool NextElement(BufferCursor &cur, EbmlElementHeader &out);
 
+// Decode an element header at data without consuming it; never logs, so it is
+// safe to call repeatedly while waiting for more streaming input.
+EbmlProbeResult ProbeElementHeader(const uint8_t *data, size_t size, EbmlElementHeader &out, size_t &header_len);
+
 } // namespace lmshao::lmmkv
 
 #endif // LMSHAO_LMMKV_EBML_READER_H
\ No newline at end of file
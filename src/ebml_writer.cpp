@@ -0,0 +1,90 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "ebml_writer.h"
+
+#include <cstring>
+
+namespace lmshao::lmmkv {
+
+uint8_t *EbmlBuffer::Grow(size_t n)
+{
+    size_t old = bytes_.size();
+    bytes_.resize(old + n);
+    return bytes_.data() + old;
+}
+
+void EbmlBuffer::PutUInt(uint64_t id, uint64_t value)
+{
+    size_t len = 1;
+    while (len < 8 && (value >> (8 * len)) != 0) {
+        ++len;
+    }
+    uint8_t header[kEbmlMaxHeaderLength];
+    size_t header_len = PutElementHeader(header, id, len);
+    uint8_t *p = Grow(header_len + len);
+    std::memcpy(p, header, header_len);
+    StoreBE(p + header_len, value, len);
+}
+
+void EbmlBuffer::PutFloat(uint64_t id, double value)
+{
+    uint64_t bits = 0;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint8_t header[kEbmlMaxHeaderLength];
+    size_t header_len = PutElementHeader(header, id, sizeof(bits));
+    uint8_t *p = Grow(header_len + sizeof(bits));
+    std::memcpy(p, header, header_len);
+    StoreBE(p + header_len, bits, sizeof(bits));
+}
+
+void EbmlBuffer::PutString(uint64_t id, const std::string &value)
+{
+    PutBinary(id, reinterpret_cast<const uint8_t *>(value.data()), value.size());
+}
+
+void EbmlBuffer::PutBinary(uint64_t id, const uint8_t *data, size_t size)
+{
+    uint8_t header[kEbmlMaxHeaderLength];
+    size_t header_len = PutElementHeader(header, id, size);
+    uint8_t *p = Grow(header_len + size);
+    std::memcpy(p, header, header_len);
+    if (size > 0) {
+        std::memcpy(p + header_len, data, size);
+    }
+}
+
+void EbmlBuffer::PutVoid(size_t total)
+{
+    uint8_t *p = Grow(total);
+    size_t header_len = PutVoidHeader(p, total);
+    std::memset(p + header_len, 0, total - header_len);
+}
+
+size_t EbmlBuffer::OpenMaster(uint64_t id)
+{
+    size_t id_len = EbmlIdLength(id);
+    uint8_t *p = Grow(id_len + kEbmlPatchableSizeLength);
+    StoreBE(p, id, id_len);
+    return bytes_.size() - kEbmlPatchableSizeLength;
+}
+
+size_t EbmlBuffer::CloseMaster(size_t mark)
+{
+    size_t payload_begin = mark + kEbmlPatchableSizeLength;
+    size_t payload = bytes_.size() - payload_begin;
+    size_t width = EbmlSizeLength(payload);
+    PutEbmlSize(bytes_.data() + mark, payload, width);
+    if (width < kEbmlPatchableSizeLength) {
+        bytes_.erase(bytes_.begin() + static_cast<std::ptrdiff_t>(mark + width),
+                     bytes_.begin() + static_cast<std::ptrdiff_t>(payload_begin));
+    }
+    return mark + width;
+}
+
+} // namespace lmshao::lmmkv
@@ -0,0 +1,106 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_EBML_WRITER_H
+#define LMSHAO_LMMKV_EBML_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ebml_reader.h"
+#include "mkv_schema.h"
+
+namespace lmshao::lmmkv {
+
+// Element header with an 8-byte size field, as reserved for sizes patched later
+static constexpr size_t kEbmlPatchableSizeLength = 8;
+
+// Smallest vint width for size; the all-ones value of a width means unknown size
+inline size_t EbmlSizeLength(uint64_t size)
+{
+    size_t width = 1;
+    while (width < kEbmlMaxSizeLength && size >= (1ULL << (7 * width)) - 1) {
+        ++width;
+    }
+    return width;
+}
+
+// Store the low n bytes of v big-endian
+inline void StoreBE(uint8_t *p, uint64_t v, size_t n)
+{
+    for (size_t i = n; i > 0; --i) {
+        p[i - 1] = static_cast<uint8_t>(v);
+        v >>= 8;
+    }
+}
+
+// Size vint of exactly width bytes
+inline void PutEbmlSize(uint8_t *p, uint64_t size, size_t width)
+{
+    StoreBE(p, size | (1ULL << (7 * width)), width);
+}
+
+// 8-byte unknown size (live Segments and Clusters, or sizes a non-seekable output cannot patch)
+inline void PutEbmlUnknownSize(uint8_t *p)
+{
+    StoreBE(p, 0x01FFFFFFFFFFFFFFULL, kEbmlPatchableSizeLength);
+}
+
+// ID and minimal-width size at p (at most kEbmlMaxHeaderLength bytes); returns the length
+inline size_t PutElementHeader(uint8_t *p, uint64_t id, uint64_t size)
+{
+    size_t id_len = EbmlIdLength(id);
+    StoreBE(p, id, id_len);
+    size_t size_len = EbmlSizeLength(size);
+    PutEbmlSize(p + id_len, size, size_len);
+    return id_len + size_len;
+}
+
+// Header of a Void element spanning exactly total bytes (at least 2); returns the
+// header length. Short Voids widen the size field to fill total.
+inline size_t PutVoidHeader(uint8_t *p, size_t total)
+{
+    size_t size_len = total - 1 < kEbmlMaxSizeLength ? total - 1 : kEbmlMaxSizeLength;
+    p[0] = static_cast<uint8_t>(kVoidId);
+    PutEbmlSize(p + 1, total - 1 - size_len, size_len);
+    return 1 + size_len;
+}
+
+// Builds EBML elements in a growable buffer (EBML header, Info, Tracks, Cues)
+class EbmlBuffer {
+public:
+    void PutUInt(uint64_t id, uint64_t value);
+    void PutFloat(uint64_t id, double value);
+    void PutString(uint64_t id, const std::string &value);
+    void PutBinary(uint64_t id, const uint8_t *data, size_t size);
+
+    // Void element of exactly total bytes (at least 2)
+    void PutVoid(size_t total);
+
+    // Start a master element; its size is filled in by CloseMaster(), which also
+    // shrinks the size field to its minimal width and returns where the payload now
+    // starts. Close inner masters first.
+    size_t OpenMaster(uint64_t id);
+    size_t CloseMaster(size_t mark);
+
+    const std::vector<uint8_t> &Bytes() const { return bytes_; }
+    std::vector<uint8_t> &Bytes() { return bytes_; }
+    size_t Size() const { return bytes_.size(); }
+    void Clear() { bytes_.clear(); }
+
+private:
+    uint8_t *Grow(size_t n);
+
+    std::vector<uint8_t> bytes_;
+};
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_EBML_WRITER_H
@@ -8,20 +8,47 @@
 
 #include "lmmkv/matroska_parser.h"
 
-#include <cstring>
+#include <vector>
 
 #include "ebml_reader.h"
 #include "internal_logger.h"
-#include "lmcore/byte_order.h"
+#include "mkv_schema.h"
+#include "mkv_seek_index.h"
 
 namespace lmshao::lmmkv {
 
-// Common EBML/Matroska element IDs (partial)
-static constexpr uint64_t kEbmlHeaderId = 0x1A45DFA3ULL;  // EBML
-static constexpr uint64_t kSegmentId = 0x18538067ULL;     // Segment
-static constexpr uint64_t kInfoId = 0x1549A966ULL;        // Info
-static constexpr uint64_t kTimecodeScaleId = 0x2AD7B1ULL; // TimecodeScale
-static constexpr uint64_t kDurationId = 0x4489ULL;        // Duration
+// Parse the fields of an Info payload spanning [cur.Tell(), info_end)
+static void ParseInfoPayload(BufferCursor &cur, size_t info_end, MatroskaInfo &info)
+{
+    double duration_ticks = 0.0;
+    while (cur.Tell() < info_end) {
+        EbmlElementHeader kv{};
+        if (!NextElement(cur, kv)) {
+            break;
+        }
+        switch (ElementOf(kv.id)) {
+            case MkvElement::kTimecodeScale: {
+                // TimecodeScale is an integer (default 1_000_000)
+                uint64_t v = ReadUnsignedBE(cur, static_cast<size_t>(kv.size));
+                if (v != 0) {
+                    info.timecode_scale_ns = v;
+                }
+                break;
+            }
+            case MkvElement::kDuration:
+                // Duration is a float (size=4 or 8) in TimecodeScale units
+                duration_ticks = ReadFloatBE(cur, static_cast<size_t>(kv.size));
+                break;
+            default: {
+                // Skip unknown field
+                size_t pos = cur.Tell();
+                cur.Seek(pos + static_cast<size_t>(kv.size));
+                break;
+            }
+        }
+    }
+    info.duration_seconds = duration_ticks * static_cast<double>(info.timecode_scale_ns) / 1e9;
+}
 
 bool MatroskaParser::ParseBuffer(const uint8_t *data, size_t size, MatroskaInfo &info)
 {
@@ -54,80 +81,96 @@ bool MatroskaParser::ParseBuffer(const uint8_t *data, size_t size, MatroskaInfo
 
     // Inside Segment, scan for Info element (minimal)
     size_t segment_start = cur.Tell();
-    size_t segment_end = segment_start + static_cast<size_t>(hdr.size);
+    size_t segment_end = size;
+    if (hdr.size != kEbmlUnknownSize && hdr.size < size - segment_start) {
+        segment_end = segment_start + static_cast<size_t>(hdr.size);
+    }
     while (cur.Tell() < segment_end) {
         EbmlElementHeader child{};
         if (!NextElement(cur, child)) {
             LMMKV_LOGW("End of segment or failed to read child header");
             break;
         }
+        if (child.size == kEbmlUnknownSize) {
+            // Live stream: unknown-size Cluster runs to the end of the buffer
+            break;
+        }
         if (child.id == kInfoId) {
-            // Iterate fields within Info in a minimal way
-            size_t info_start = cur.Tell();
-            size_t info_end = info_start + static_cast<size_t>(child.size);
+            ParseInfoPayload(cur, cur.Tell() + static_cast<size_t>(child.size), info);
+            // Info is all we report; stop instead of touching the rest of the Segment
+            break;
+        }
+        // Skip element we do not parse yet
+        size_t pos = cur.Tell();
+        cur.Seek(pos + static_cast<size_t>(child.size));
+    }
 
-            // Use lmcore::ByteOrder to convert big-endian IEEE-754 floats
-            using lmshao::lmcore::ByteOrder;
-            auto ReadBEFloat32 = [](const uint8_t *p) -> float {
-                uint32_t bits = ByteOrder::ReadBE32(p);
-                float f;
-                std::memcpy(&f, &bits, sizeof(f));
-                return f;
-            };
-            auto ReadBEFloat64 = [](const uint8_t *p) -> double {
-                uint64_t bits = ByteOrder::ReadBE64(p);
-                double d;
-                std::memcpy(&d, &bits, sizeof(d));
-                return d;
-            };
+    LMMKV_LOGI("Parsed Matroska: timecode_scale=%llu ns, duration=%.3f s", (unsigned long long)info.timecode_scale_ns,
+               info.duration_seconds);
+    return true;
+}
 
-            while (cur.Tell() < info_end) {
-                EbmlElementHeader kv{};
-                if (!NextElement(cur, kv)) {
-                    break;
-                }
-                if (kv.id == kTimecodeScaleId) {
-                    // TimecodeScale is an integer (default 1_000_000)
-                    uint8_t buf[8] = {0};
-                    size_t to_read = static_cast<size_t>(kv.size);
-                    if (to_read > sizeof(buf))
-                        to_read = sizeof(buf);
-                    size_t r = cur.Read(buf, to_read);
-                    if (r == to_read && to_read > 0) {
-                        uint64_t v = 0;
-                        for (size_t i = 0; i < to_read; ++i) {
-                            v = (v << 8) | buf[i];
-                        }
-                        info.timecode_scale_ns = v;
-                    }
-                } else if (kv.id == kDurationId) {
-                    // Duration is a float (size=4 or 8)
-                    uint8_t buf[8] = {0};
-                    size_t to_read = static_cast<size_t>(kv.size);
-                    if (to_read > sizeof(buf))
-                        to_read = sizeof(buf);
-                    size_t r = cur.Read(buf, to_read);
-                    if (r == to_read && (to_read == 4 || to_read == 8)) {
-                        if (to_read == 4) {
-                            info.duration_seconds = static_cast<double>(ReadBEFloat32(buf));
-                        } else {
-                            info.duration_seconds = ReadBEFloat64(buf);
-                        }
+bool MatroskaParser::ParseSource(IByteSource &source, MatroskaInfo &info)
+{
+    EbmlElementHeader hdr{};
+    size_t header_len = 0;
+    if (!ReadHeaderAt(source, 0, hdr, header_len) || hdr.id != kEbmlHeaderId || hdr.size == kEbmlUnknownSize) {
+        LMMKV_LOGE("Missing EBML header");
+        return false;
+    }
+    uint64_t off = header_len + hdr.size;
+    if (!ReadHeaderAt(source, off, hdr, header_len) || hdr.id != kSegmentId) {
+        LMMKV_LOGE("Segment not found after EBML header");
+        return false;
+    }
+    uint64_t segment_start = off + header_len;
+    uint64_t segment_end = source.Size();
+    if (hdr.size != kEbmlUnknownSize && hdr.size < segment_end - segment_start) {
+        segment_end = segment_start + hdr.size;
+    }
+
+    // Info normally follows the SeekHead; when the walk reaches a Cluster first, use the SeekHead position
+    uint64_t info_pos = 0;
+    uint64_t seek_info_pos = 0;
+    std::vector<uint8_t> payload;
+    off = segment_start;
+    while (info_pos == 0 && off < segment_end && ReadHeaderAt(source, off, hdr, header_len)) {
+        if (hdr.id == kInfoId) {
+            info_pos = off;
+            break;
+        } else if (hdr.id == kSeekHeadId && hdr.size <= segment_end - off) {
+            payload.resize(static_cast<size_t>(hdr.size));
+            if (source.ReadAt(off + header_len, payload.data(), payload.size()) == payload.size()) {
+                std::vector<SeekEntry> entries;
+                BufferCursor cur(payload.data(), payload.size());
+                ParseSeekHead(cur, payload.size(), entries);
+                for (const auto &entry : entries) {
+                    if (entry.id == kInfoId && seek_info_pos == 0) {
+                        seek_info_pos = segment_start + entry.pos;
                     }
-                } else {
-                    // Skip unknown field
-                    size_t pos = cur.Tell();
-                    cur.Seek(pos + static_cast<size_t>(kv.size));
                 }
             }
-            // Move to end of Info
-            cur.Seek(info_end);
-        } else {
-            // Skip element we do not parse yet
-            size_t pos = cur.Tell();
-            cur.Seek(pos + static_cast<size_t>(child.size));
+        } else if (hdr.id == kClusterId || hdr.size == kEbmlUnknownSize) {
+            break;
         }
+        off += header_len + hdr.size;
+    }
+    if (info_pos == 0) {
+        info_pos = seek_info_pos;
+    }
+
+    if (info_pos == 0 || !ReadHeaderAt(source, info_pos, hdr, header_len) || hdr.id != kInfoId ||
+        hdr.size > segment_end - info_pos) {
+        LMMKV_LOGE("Info element not found");
+        return false;
+    }
+    payload.resize(static_cast<size_t>(hdr.size));
+    if (source.ReadAt(info_pos + header_len, payload.data(), payload.size()) != payload.size()) {
+        LMMKV_LOGE("Short read of Info at %llu", (unsigned long long)info_pos);
+        return false;
     }
+    BufferCursor cur(payload.data(), payload.size());
+    ParseInfoPayload(cur, payload.size(), info);
 
     LMMKV_LOGI("Parsed Matroska: timecode_scale=%llu ns, duration=%.3f s", (unsigned long long)info.timecode_scale_ns,
                info.duration_seconds);
@@ -11,101 +11,66 @@
 #include <algorithm>
 #include <cctype>
 #include <cstdint>
+#include <cstdio>
+#include <condition_variable>
 #include <cstring>
+#include <map>
 #include <memory>
+#include <memory_resource>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
 
+#include "codec_config.h"
+#include "content_encoding.h"
 #include "ebml_reader.h"
 #include "internal_logger.h"
+#include "lmmkv/mkv_byte_source.h"
 #include "lmmkv/mkv_listeners.h"
+#include "lmmkv/mkv_packetizer.h"
 #include "lmmkv/mkv_types.h"
+#include "mkv_schema.h"
+#include "mkv_seek_index.h"
 
 namespace lmshao::lmmkv {
 
-// Matroska/EBML element IDs
-static constexpr uint64_t kSegmentId = 0x18538067ULL;       // Segment
-static constexpr uint64_t kInfoId = 0x1549A966ULL;          // Info
-static constexpr uint64_t kTracksId = 0x1654AE6BULL;        // Tracks
-static constexpr uint64_t kTrackEntryId = 0xAEULL;          // TrackEntry
-static constexpr uint64_t kTrackNumberId = 0xD7ULL;         // TrackNumber
-static constexpr uint64_t kTrackTypeId = 0x83ULL;           // TrackType
-static constexpr uint64_t kCodecId = 0x86ULL;               // CodecID
-static constexpr uint64_t kCodecPrivate = 0x63A2ULL;        // CodecPrivate
-static constexpr uint64_t kAudioId = 0xE1ULL;               // Audio
-static constexpr uint64_t kChannelsId = 0x9FULL;            // Channels
-static constexpr uint64_t kSamplingFreqId = 0xB5ULL;        // SamplingFrequency
-static constexpr uint64_t kClusterId = 0x1F43B675ULL;       // Cluster
-static constexpr uint64_t kClusterTimecodeId = 0xE7ULL;     // Timecode
-static constexpr uint64_t kSimpleBlockId = 0xA3ULL;         // SimpleBlock
-static constexpr uint64_t kBlockGroupId = 0xA0ULL;          // BlockGroup
-static constexpr uint64_t kBlockId = 0xA1ULL;               // Block
-static constexpr uint64_t kDefaultDurationId = 0x23E383ULL; // DefaultDuration
-static constexpr uint64_t kVideoId = 0xE0ULL;               // Video
-static constexpr uint64_t kPixelWidthId = 0xB0ULL;          // PixelWidth
-static constexpr uint64_t kPixelHeightId = 0xBAULL;         // PixelHeight
+// Upper bound for a single element buffered across Consume() calls
+static constexpr uint64_t kMaxBufferedElementSize = 64ULL * 1024 * 1024;
+
+// Scratch buffers below this size are never trimmed between clusters
+static constexpr size_t kScratchTrimThreshold = 1024 * 1024;
+
+// Parallel demux hands out runs of Clusters of about this many bytes per job
+static constexpr uint64_t kParallelJobBytes = 8ULL * 1024 * 1024;
+// Jobs in flight per worker ahead of the in-order emitter; bounds buffered output
+static constexpr size_t kParallelJobsPerWorker = 2;
+
+// ReadPacket() pulls input from the byte source in reads of this size
+static constexpr size_t kPullReadSize = 256 * 1024;
+// Smaller reads between kept blocks in keyframe-only mode, so skipped frames are not read
+static constexpr size_t kPullPeekReadSize = 4 * 1024;
+
+// Prefetch hints cover at most this many bytes of upcoming Clusters
+static constexpr uint64_t kPrefetchBytes = 4ULL * 1024 * 1024;
+
+// SimpleBlock bytes needed to see the track number (up to 8) and flags
+static constexpr size_t kBlockPeekLength = 8 + 3;
 
 // Track types
 static constexpr uint8_t kTrackTypeVideo = 0x01;
 static constexpr uint8_t kTrackTypeAudio = 0x02;
 
 // Helpers (buffer-only)
-static inline size_t ReadBytes(BufferCursor &cur, uint8_t *dst, size_t n)
-{
-    size_t r = cur.Read(dst, n);
-    if (r != n) {
-        LMMKV_LOGE("Failed to read %zu bytes, got %zu", n, r);
-    }
-    return r;
-}
-
 static inline bool SkipBytes(BufferCursor &cur, size_t n)
 {
     size_t pos = cur.Tell();
     return cur.Seek(pos + n);
 }
 
-static inline uint64_t ReadUnsignedBE(BufferCursor &cur, size_t size)
-{
-    uint64_t v = 0;
-    for (size_t i = 0; i < size; ++i) {
-        uint8_t b = 0;
-        if (ReadBytes(cur, &b, 1) != 1) {
-            return 0;
-        }
-        v = (v << 8) | b;
-    }
-    return v;
-}
-
-static inline double ReadFloatBE(BufferCursor &cur, size_t size)
-{
-    if (size == 4) {
-        uint32_t be = static_cast<uint32_t>(ReadUnsignedBE(cur, 4));
-        uint32_t le = ((be & 0x000000FFu) << 24) | ((be & 0x0000FF00u) << 8) | ((be & 0x00FF0000u) >> 8) |
-                      ((be & 0xFF000000u) >> 24);
-        float f;
-        std::memcpy(&f, &le, sizeof(f));
-        return static_cast<double>(f);
-    } else if (size == 8) {
-        uint64_t be = ReadUnsignedBE(cur, 8);
-        uint64_t le = ((be & 0x00000000000000FFULL) << 56) | ((be & 0x000000000000FF00ULL) << 40) |
-                      ((be & 0x0000000000FF0000ULL) << 24) | ((be & 0x00000000FF000000ULL) << 8) |
-                      ((be & 0x000000FF00000000ULL) >> 8) | ((be & 0x0000FF0000000000ULL) >> 24) |
-                      ((be & 0x00FF000000000000ULL) >> 40) | ((be & 0xFF00000000000000ULL) >> 56);
-        double d;
-        std::memcpy(&d, &le, sizeof(d));
-        return d;
-    }
-    // Unsupported size
-    SkipBytes(cur, size);
-    return 0.0;
-}
-
 static inline std::vector<uint8_t> ReadPayload(BufferCursor &cur, size_t size)
 {
     std::vector<uint8_t> buf;
@@ -120,269 +85,154 @@ static inline std::vector<uint8_t> ReadPayload(BufferCursor &cur, size_t size)
     return buf;
 }
 
+static inline bool StartsWith(const std::string &s, const std::string &prefix)
+{
+    return s.compare(0, prefix.size(), prefix) == 0;
+}
+
 // Track info
 struct TrackInfo {
-    uint64_t track_number;
-    uint8_t track_type; // 1 video, 2 audio
+    uint64_t track_number = 0;
+    uint8_t track_type = 0; // 1 video, 2 audio
     std::string codec_id;
     std::vector<uint8_t> codec_private;
 
-    // H264 avcC
-    uint8_t nal_length_size; // 1/2/4
-    std::vector<std::vector<uint8_t>> sps_list;
-    std::vector<std::vector<uint8_t>> pps_list;
-
-    // HEVC hvcC
-    std::vector<std::vector<uint8_t>> vps_list;
-    std::vector<std::vector<uint8_t>> sps_hevc_list;
-    std::vector<std::vector<uint8_t>> pps_hevc_list;
-    uint8_t nal_length_size_hevc{4};
-
-    // AAC ASC
-    uint8_t aac_object_type; // raw
-    uint8_t aac_profile;     // profile-1
-    uint8_t aac_sample_rate_index;
-    uint32_t aac_sample_rate;
-    uint8_t aac_channel_config;
-
     // Matroska metadata
-    uint64_t default_duration_ns{0};
-    uint32_t pixel_width{0};
-    uint32_t pixel_height{0};
+    uint64_t default_duration_ns = 0;
+    uint32_t pixel_width = 0;
+    uint32_t pixel_height = 0;
+    uint32_t sample_rate = 44100;
+    uint32_t channels = 2;
 
-    TrackInfo()
-        : track_number(0), track_type(0), nal_length_size(4), aac_object_type(2), aac_profile(1),
-          aac_sample_rate_index(4), aac_sample_rate(44100), aac_channel_config(2)
-    {
-    }
+    ContentEncodingInfo encoding;
+
+    // Resolved once at discovery; shared read-only with parallel workers
+    std::shared_ptr<const IMkvPacketizer> packetizer;
 };
 
-static inline bool StartsWith(const std::string &s, const char *prefix)
-{
-    return s.size() >= std::strlen(prefix) && std::equal(prefix, prefix + std::strlen(prefix), s.begin());
-}
+using SliceList = MkvSliceList;
 
-static inline void ParseAvcC(TrackInfo &ti)
+static inline size_t SlicesSize(const SliceList &slices)
 {
-    const auto &cp = ti.codec_private;
-    if (cp.size() < 7) {
-        LMMKV_LOGW("avcC too short: %zu", cp.size());
-        return;
-    }
-    uint8_t configurationVersion = cp[0];
-    (void)configurationVersion;
-    uint8_t lengthSizeMinusOne = cp[4] & 0x03;
-    ti.nal_length_size = static_cast<uint8_t>(lengthSizeMinusOne + 1);
-    uint8_t numSps = cp[5] & 0x1F;
-    size_t offset = 6;
-    for (uint8_t i = 0; i < numSps; ++i) {
-        if (offset + 2 > cp.size())
-            return;
-        uint16_t spsLen = static_cast<uint16_t>((cp[offset] << 8) | cp[offset + 1]);
-        offset += 2;
-        if (offset + spsLen > cp.size())
-            return;
-        ti.sps_list.emplace_back(cp.begin() + offset, cp.begin() + offset + spsLen);
-        offset += spsLen;
-    }
-    if (offset + 1 > cp.size())
-        return;
-    uint8_t numPps = cp[offset];
-    offset += 1;
-    for (uint8_t i = 0; i < numPps; ++i) {
-        if (offset + 2 > cp.size())
-            return;
-        uint16_t ppsLen = static_cast<uint16_t>((cp[offset] << 8) | cp[offset + 1]);
-        offset += 2;
-        if (offset + ppsLen > cp.size())
-            return;
-        ti.pps_list.emplace_back(cp.begin() + offset, cp.begin() + offset + ppsLen);
-        offset += ppsLen;
+    size_t total = 0;
+    for (const auto &s : slices) {
+        total += s.second;
     }
+    return total;
 }
 
-// HEVC hvcC parsing (minimal)
-static inline void ParseHvcC(TrackInfo &ti)
+// Append the slices back to back to out
+static inline void AppendSlices(const SliceList &slices, std::pmr::vector<uint8_t> &out)
 {
-    const auto &cp = ti.codec_private;
-    if (cp.size() < 23) {
-        LMMKV_LOGW("hvcC too short: %zu", cp.size());
-        return;
-    }
-    // lengthSizeMinusOne is at byte 21 in ISO/IEC 14496-15 (HEVC)
-    ti.nal_length_size_hevc = static_cast<uint8_t>((cp[21] & 0x03) + 1);
-    size_t offset = 22;
-    uint8_t numArrays = cp[offset++];
-    for (uint8_t ai = 0; ai < numArrays; ++ai) {
-        if (offset + 3 > cp.size())
-            return;
-        uint8_t arrayCompleteness = (cp[offset] & 0x80) >> 7;
-        uint8_t nalUnitType = cp[offset] & 0x3F; // 32..34..
-        (void)arrayCompleteness;
-        offset += 1;
-        uint16_t numNalus = static_cast<uint16_t>((cp[offset] << 8) | cp[offset + 1]);
-        offset += 2;
-        for (uint16_t ni = 0; ni < numNalus; ++ni) {
-            if (offset + 2 > cp.size())
-                return;
-            uint16_t nalSize = static_cast<uint16_t>((cp[offset] << 8) | cp[offset + 1]);
-            offset += 2;
-            if (offset + nalSize > cp.size())
-                return;
-            std::vector<uint8_t> nal(cp.begin() + offset, cp.begin() + offset + nalSize);
-            offset += nalSize;
-            if (nalUnitType == 32) {
-                ti.vps_list.emplace_back(std::move(nal));
-            } else if (nalUnitType == 33) {
-                ti.sps_hevc_list.emplace_back(std::move(nal));
-            } else if (nalUnitType == 34) {
-                ti.pps_hevc_list.emplace_back(std::move(nal));
-            }
-        }
+    out.reserve(out.size() + SlicesSize(slices));
+    for (const auto &s : slices) {
+        out.insert(out.end(), s.first, s.first + s.second);
     }
 }
 
-static inline void AppendStartCode(std::vector<uint8_t> &out);
+// One run of Clusters demuxed by a parallel worker. Frame payloads are copied
+// back to back into bytes; frames and slices hold offsets until emitted in order.
+struct ParallelJob {
+    struct Frame {
+        MkvFrame meta; // track, timing and references; data/slices are rebuilt on emit
+        bool has_data;
+        size_t offset;
+        size_t slice_begin;
+        size_t slice_count;
+    };
 
-static inline std::vector<uint8_t> ConvertHvccFrameToAnnexB(const TrackInfo &ti, const uint8_t *data, size_t size,
-                                                            bool keyframe)
-{
-    std::vector<uint8_t> out;
-    if (keyframe) {
-        for (const auto &vps : ti.vps_list) {
-            AppendStartCode(out);
-            out.insert(out.end(), vps.begin(), vps.end());
-        }
-        for (const auto &sps : ti.sps_hevc_list) {
-            AppendStartCode(out);
-            out.insert(out.end(), sps.begin(), sps.end());
-        }
-        for (const auto &pps : ti.pps_hevc_list) {
-            AppendStartCode(out);
-            out.insert(out.end(), pps.begin(), pps.end());
-        }
-    }
-    size_t offset = 0;
-    while (offset + ti.nal_length_size_hevc <= size) {
-        uint32_t nalLen = 0;
-        if (ti.nal_length_size_hevc == 1) {
-            nalLen = data[offset];
-        } else if (ti.nal_length_size_hevc == 2) {
-            nalLen = static_cast<uint32_t>((data[offset] << 8) | data[offset + 1]);
-        } else if (ti.nal_length_size_hevc == 4) {
-            nalLen = (static_cast<uint32_t>(data[offset]) << 24) | (static_cast<uint32_t>(data[offset + 1]) << 16) |
-                     (static_cast<uint32_t>(data[offset + 2]) << 8) | static_cast<uint32_t>(data[offset + 3]);
-        } else {
-            break;
-        }
-        offset += ti.nal_length_size_hevc;
-        if (offset + nalLen > size)
-            break;
-        AppendStartCode(out);
-        out.insert(out.end(), data + offset, data + offset + nalLen);
-        offset += nalLen;
-    }
-    return out;
-}
-// AAC AudioSpecificConfig parsing (basic)
-static inline void ParseAacAsc(TrackInfo &ti)
-{
-    const auto &cp = ti.codec_private;
-    if (cp.empty())
-        return;
-    // Read first 2 bytes
-    uint16_t u = 0;
-    if (cp.size() >= 2) {
-        u = static_cast<uint16_t>((cp[0] << 8) | cp[1]);
-    } else {
-        u = static_cast<uint16_t>(cp[0] << 8);
-    }
-    uint8_t audioObjectType = static_cast<uint8_t>((cp[0] >> 3) & 0x1F);
-    uint8_t samplingFrequencyIndex = static_cast<uint8_t>(((cp[0] & 0x07) << 1) | ((cp[1] >> 7) & 0x01));
-    uint8_t channelConfig = static_cast<uint8_t>((cp[1] >> 3) & 0x0F);
-
-    ti.aac_object_type = audioObjectType;
-    ti.aac_profile = static_cast<uint8_t>(audioObjectType - 1);
-    ti.aac_sample_rate_index = samplingFrequencyIndex;
-    ti.aac_channel_config = channelConfig;
-
-    static const uint32_t kSampleRates[16] = {96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
-                                              16000, 12000, 11025, 8000,  7350,  0,     0,     0};
-    ti.aac_sample_rate = (samplingFrequencyIndex < 16) ? kSampleRates[samplingFrequencyIndex] : 0;
-}
+    uint64_t begin = 0;
+    uint64_t end = 0;
+    bool done = false;
+    std::vector<uint8_t> bytes;
+    std::vector<Frame> frames;
+    std::vector<std::pair<size_t, size_t>> slices; // offset into bytes, size
+    std::vector<std::pair<int, std::string>> errors;
+};
 
-static inline void AppendStartCode(std::vector<uint8_t> &out)
-{
-    static const uint8_t kStartCode[4] = {0x00, 0x00, 0x00, 0x01};
-    out.insert(out.end(), kStartCode, kStartCode + 4);
-}
+// Worker-side listener: copies each frame out of the worker's scratch into the current job
+class ParallelJobCollector final : public IMkvDemuxListener {
+public:
+    void SetJob(ParallelJob *job) { job_ = job; }
 
-static inline std::vector<uint8_t> ConvertAvccFrameToAnnexB(const TrackInfo &ti, const uint8_t *data, size_t size,
-                                                            bool keyframe)
-{
-    std::vector<uint8_t> out;
-    if (keyframe) {
-        for (const auto &sps : ti.sps_list) {
-            AppendStartCode(out);
-            out.insert(out.end(), sps.begin(), sps.end());
-        }
-        for (const auto &pps : ti.pps_list) {
-            AppendStartCode(out);
-            out.insert(out.end(), pps.begin(), pps.end());
-        }
-    }
-    size_t offset = 0;
-    while (offset + ti.nal_length_size <= size) {
-        uint32_t nalLen = 0;
-        if (ti.nal_length_size == 1) {
-            nalLen = data[offset];
-        } else if (ti.nal_length_size == 2) {
-            nalLen = static_cast<uint32_t>((data[offset] << 8) | data[offset + 1]);
-        } else if (ti.nal_length_size == 4) {
-            nalLen = (static_cast<uint32_t>(data[offset]) << 24) | (static_cast<uint32_t>(data[offset + 1]) << 16) |
-                     (static_cast<uint32_t>(data[offset + 2]) << 8) | static_cast<uint32_t>(data[offset + 3]);
+    void OnInfo(const MkvInfo &) override {}
+    void OnTrack(const MkvTrackInfo &) override {}
+    void OnEndOfStream() override {}
+
+    void OnFrame(const MkvFrame &frame) override
+    {
+        ParallelJob::Frame out{};
+        out.meta.track_number = frame.track_number;
+        out.meta.timecode_ns = frame.timecode_ns;
+        out.meta.keyframe = frame.keyframe;
+        out.meta.duration_ns = frame.duration_ns;
+        out.meta.references_ns = frame.references_ns;
+        out.has_data = frame.data != nullptr;
+        out.offset = job_->bytes.size();
+        out.slice_begin = job_->slices.size();
+        if (frame.data) {
+            // Passthrough laces lie inside [data, data + size)
+            job_->bytes.insert(job_->bytes.end(), frame.data, frame.data + frame.size);
+            for (const auto &s : frame.slices) {
+                job_->slices.emplace_back(out.offset + static_cast<size_t>(s.first - frame.data), s.second);
+            }
         } else {
-            break;
-        }
-        offset += ti.nal_length_size;
-        if (offset + nalLen > size) {
-            break;
+            // Sliced output is gathered once here and delivered as a single slice
+            for (const auto &s : frame.slices) {
+                job_->bytes.insert(job_->bytes.end(), s.first, s.first + s.second);
+            }
+            job_->slices.emplace_back(out.offset, frame.size);
         }
-        AppendStartCode(out);
-        out.insert(out.end(), data + offset, data + offset + nalLen);
-        offset += nalLen;
+        out.meta.size = frame.size;
+        out.slice_count = job_->slices.size() - out.slice_begin;
+        job_->frames.push_back(std::move(out));
     }
-    return out;
-}
 
-static inline std::vector<uint8_t> BuildAdtsHeader(const TrackInfo &ti, size_t aac_payload_size)
-{
-    std::vector<uint8_t> hdr(7);
-    uint16_t frameLen = static_cast<uint16_t>(aac_payload_size + 7);
-    // Byte 0-1: sync + flags
-    hdr[0] = 0xFF;
-    hdr[1] = 0xF1; // 1111 0001: MPEG-4, no CRC
-    // Byte 2: profile(2) + sampling_frequency_index(4) + private_bit(1) + channel_config high(1)
-    hdr[2] = static_cast<uint8_t>(((ti.aac_profile & 0x03) << 6) | ((ti.aac_sample_rate_index & 0x0F) << 2) |
-                                  ((ti.aac_channel_config >> 2) & 0x01));
-    // Byte 3: channel_config low(2) + original/copy(1) + home(1) + copyright bits(2) + frame length high(2)
-    hdr[3] = static_cast<uint8_t>(((ti.aac_channel_config & 0x03) << 6) | ((frameLen >> 11) & 0x03));
-    // Byte 4: frame length mid 8 bits
-    hdr[4] = static_cast<uint8_t>((frameLen >> 3) & 0xFF);
-    // Byte 5: frame length low 3 bits + fullness high 5 bits
-    hdr[5] = static_cast<uint8_t>(((frameLen & 0x07) << 5) | 0x1F);
-    // Byte 6: fullness low 8 bits + num_raw_blocks(2)
-    hdr[6] = static_cast<uint8_t>(0xFC); // 0x7FF fullness (VBR), num_blocks=0
-    return hdr;
-}
+    void OnError(int code, const std::string &msg) override { job_->errors.emplace_back(code, msg); }
+
+private:
+    ParallelJob *job_ = nullptr;
+};
 
 class MkvDemuxer::Impl {
 public:
-    Impl() : running_(false), timecodeScaleNs_(1000000), currentClusterTimecodeNs_(0)
+    explicit Impl(std::pmr::memory_resource *resource)
+        : running_(false), timecodeScaleNs_(1000000), currentClusterTimecodeNs_(0), state_(ParseState::kHeader),
+          streamPos_(0), skipRemaining_(0), headerLen_(0), carry_(resource), resyncBuf_(resource), replay_(resource),
+          outputMode_(MkvOutputMode::kConverted), laces_(resource), laceSizes_(resource), frameSlices_(resource),
+          frameBuf_(resource), scratchPeak_(0), inflateBuf_(resource), batchBytes_(resource), batchHeaders_(resource),
+          readBuf_(resource)
     {
         // Default weak_ptr empty; use nullListener_ on lock fallback
     }
     ~Impl() { Stop(false); }
+    void SetOutputMode(MkvOutputMode mode)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        outputMode_ = mode;
+    }
+
+    void SetFrameBatchSize(size_t frames)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FlushFrames();
+        batchSize_ = frames;
+        batch_.resize(frames);
+        batchHeaders_.resize(frames * IMkvPacketizer::kMaxHeaderSize);
+    }
+
+    void RegisterPacketizer(const std::string &codec_id_prefix, MkvPacketizerFactory factory)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        packetizers_.emplace_back(codec_id_prefix, std::move(factory));
+    }
+
+    void SetKeyframesOnly(bool enable)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        keyframesOnly_ = enable;
+    }
+
     void SetTrackFilter(const std::vector<uint64_t> &tracks)
     {
         std::lock_guard<std::mutex> lock(mutex_);
@@ -414,6 +264,11 @@ public:
             return;
         running_ = false;
         LMMKV_LOGI("MKV Demuxer stopped");
+        if (notify && state_ == ParseState::kResync) {
+            // Input ended before a valid Cluster was found
+            ReportSkipped(streamPos_);
+            state_ = ParseState::kHeader;
+        }
         if (notify) {
             auto listener = listener_.lock();
             if (listener) {
@@ -429,69 +284,108 @@ public:
     }
 
     size_t ParseData(const uint8_t *data, size_t size)
-    {
-        BufferCursor cur(data, size);
-        DemuxCursor(cur);
-        return size;
-    }
-
-    bool DemuxCursor(BufferCursor &cur)
     {
         std::lock_guard<std::mutex> lock(mutex_);
         if (!running_) {
             LMMKV_LOGE("Demuxer not running");
-            return false;
+            return 0;
+        }
+        if (state_ == ParseState::kFailed) {
+            return 0;
         }
+        size_t consumed = ParseChunk(data, size);
+        // Batched frames may point into data
+        FlushFrames();
+        return consumed;
+    }
 
-        EbmlElementHeader hdr{};
-        // Find Segment
-        if (!NextElement(cur, hdr)) {
-            LMMKV_LOGE("Failed to read first element");
-            return false;
+    // Run the state machine over one input buffer; returns bytes consumed.
+    size_t ParseChunk(const uint8_t *data, size_t size)
+    {
+        size_t off = 0;
+        // In pull mode stop after each block so ReadPacket() can hand its frames out
+        while (!HasPendingFrames()) {
+            bool replay = replayPos_ < replay_.size();
+            if (!replay && off == size) {
+                break;
+            }
+            // Bytes Resync() took back from its probe buffer come before the caller's
+            bool more = replay ? ParseStep(replay_.data(), replay_.size(), replayPos_) : ParseStep(data, size, off);
+            if (!more && state_ == ParseState::kFailed) {
+                return off;
+            }
         }
-        if (hdr.id != kSegmentId) {
-            // There may be EBML header first; skip until Segment
-            size_t after_first = cur.Tell();
-            if (!cur.Seek(after_first + static_cast<size_t>(hdr.size))) {
-                LMMKV_LOGE("Failed to skip first element");
-                return false;
+        CloseFinishedLevels();
+        return off;
+    }
+
+    // One state machine step over data from off. False when the rest of data is needed
+    // first (it was taken into headerBuf_) or parsing failed.
+    bool ParseStep(const uint8_t *data, size_t size, size_t &off)
+    {
+        size_t avail = size - off;
+        if (state_ == ParseState::kSkip) {
+            size_t n = static_cast<size_t>(std::min<uint64_t>(skipRemaining_, avail));
+            Advance(off, n);
+            skipRemaining_ -= n;
+            if (skipRemaining_ == 0) {
+                state_ = ParseState::kHeader;
             }
-            bool found = false;
-            while (NextElement(cur, hdr)) {
-                if (hdr.id == kSegmentId) {
-                    found = true;
-                    break;
+        } else if (state_ == ParseState::kPayload) {
+            size_t need = static_cast<size_t>(pendingHdr_.size) - carry_.size();
+            if (carry_.empty() && avail >= need) {
+                // Whole payload present in caller buffer: parse in place
+                const uint8_t *payload = data + off;
+                Advance(off, need);
+                state_ = ParseState::kHeader;
+                HandleElement(pendingHdr_.id, payload, need);
+            } else {
+                size_t n = std::min(need, avail);
+                carry_.insert(carry_.end(), data + off, data + off + n);
+                Advance(off, n);
+                if (carry_.size() == pendingHdr_.size) {
+                    scratchPeak_ = std::max(scratchPeak_, carry_.size());
+                    state_ = ParseState::kHeader;
+                    HandleElement(pendingHdr_.id, carry_.data(), carry_.size());
+                    if (!HasPendingFrames()) {
+                        // Batched frames may point into carry_
+                        FlushFrames();
+                        carry_.clear();
+                    }
                 }
-                size_t payload_end = cur.Tell() + static_cast<size_t>(hdr.size);
-                if (!cur.Seek(payload_end)) {
-                    break;
+            }
+        } else if (state_ == ParseState::kBlockPeek) {
+            size_t peek = static_cast<size_t>(std::min<uint64_t>(pendingHdr_.size, kBlockPeekLength));
+            if (carry_.empty() && avail >= peek) {
+                // Decide in place; a kept block is then parsed from the caller buffer
+                PeekBlock(data + off, peek, 0);
+            } else {
+                size_t n = std::min(peek - carry_.size(), avail);
+                carry_.insert(carry_.end(), data + off, data + off + n);
+                Advance(off, n);
+                if (carry_.size() == peek) {
+                    PeekBlock(carry_.data(), peek, peek);
                 }
             }
-            if (!found) {
-                LMMKV_LOGE("Segment not found");
+        } else if (state_ == ParseState::kResync) {
+            Resync(data, size, off);
+        } else {
+            CloseFinishedLevels();
+            EbmlElementHeader hdr{};
+            uint64_t header_pos = streamPos_ - headerLen_;
+            EbmlProbeResult res = ReadHeader(data, size, off, hdr);
+            if (res == EbmlProbeResult::kNeedMore) {
                 return false;
             }
-        }
-
-        size_t seg_end = cur.Tell() + static_cast<size_t>(hdr.size);
-        while (cur.Tell() < seg_end) {
-            size_t before = cur.Tell();
-            if (!NextElement(cur, hdr))
-                break;
-            size_t payload_end = cur.Tell() + static_cast<size_t>(hdr.size);
-            if (hdr.id == kInfoId) {
-                ParseInfo(cur, hdr.size);
-            } else if (hdr.id == kTracksId) {
-                ParseTracks(cur, hdr.size);
-            } else if (hdr.id == kClusterId) {
-                ParseCluster(cur, hdr.size);
-            } else {
-                // Unknown element skipped
+            if (res == EbmlProbeResult::kInvalid &&
+                !Corrupt(kMkvErrorInvalidData,
+                         "Invalid EBML element header at offset " + std::to_string(header_pos), header_pos)) {
+                return false;
+            }
+            if (res == EbmlProbeResult::kOk && !BeginElement(hdr)) {
+                return false;
             }
-            if (!cur.Seek(payload_end))
-                break;
         }
-
         return true;
     }
 
@@ -507,364 +401,1592 @@ public:
         tracks_.clear();
         timecodeScaleNs_ = 1000000;
         currentClusterTimecodeNs_ = 0;
+        state_ = ParseState::kHeader;
+        streamPos_ = 0;
+        skipRemaining_ = 0;
+        headerLen_ = 0;
+        levels_.clear();
+        carry_.clear();
+        resyncBuf_.clear();
+        replay_.clear();
+        replayPos_ = 0;
+        segmentSeen_ = false;
+        segmentDataPos_ = 0;
+        segmentEnd_ = kEbmlUnknownSize;
+        seekEntries_.clear();
+        cues_.Clear();
+        cuesLoaded_ = false;
+        clustersSeen_.Clear();
+        firstClusterPos_ = 0;
+        durationTicks_ = 0.0;
+        tags_.clear();
+        batchCount_ = 0;
+        batchBytes_.clear();
+        blockNext_ = blockCount_ = 0;
+        pullMode_ = false;
+        readPos_ = readLen_ = 0;
+        readOffset_ = 0;
     }
 
-private:
-    void ParseInfo(BufferCursor &cur, uint64_t size)
+    void SetByteSource(const std::shared_ptr<IByteSource> &source)
     {
-        size_t end = cur.Tell() + static_cast<size_t>(size);
-        EbmlElementHeader sub{};
-        while (cur.Tell() < end) {
-            if (!NextElement(cur, sub))
-                break;
-            if (sub.id == 0x2AD7B1ULL) { // TimecodeScale
-                // unsigned integer
-                timecodeScaleNs_ = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
-            } else if (sub.id == 0x4489ULL) { // Duration (float)
-                (void)ReadFloatBE(cur, static_cast<size_t>(sub.size));
-            } else {
-                SkipBytes(cur, static_cast<size_t>(sub.size));
-            }
-        }
-        LMMKV_LOGI("Info: TimecodeScale=%llu ns", (unsigned long long)timecodeScaleNs_);
-        MkvInfo info;
-        info.timecode_scale_ns = timecodeScaleNs_;
-        info.duration_seconds = 0.0; // not computed in streaming
-        {
-            auto listener = listener_.lock();
-            if (listener) {
-                listener->OnInfo(info);
-            }
-        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        source_ = source;
     }
 
-    void ParseTracks(BufferCursor &cur, uint64_t size)
+    int64_t Open(const std::shared_ptr<IByteSource> &source)
     {
-        size_t end = cur.Tell() + static_cast<size_t>(size);
-        EbmlElementHeader sub{};
-        while (cur.Tell() < end) {
-            if (!NextElement(cur, sub))
-                break;
-            size_t payload_end = cur.Tell() + static_cast<size_t>(sub.size);
-            if (sub.id == kTrackEntryId) {
-                ParseTrackEntry(cur, sub.size);
-            } else {
-                // skip unknown track-level elements
-            }
-            if (!cur.Seek(payload_end))
-                break;
-        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        return OpenLocked(source);
     }
 
-    void ParseTrackEntry(BufferCursor &cur, uint64_t size)
+    int64_t OpenLocked(const std::shared_ptr<IByteSource> &source)
     {
-        size_t end = cur.Tell() + static_cast<size_t>(size);
-        EbmlElementHeader sub{};
-        TrackInfo ti;
-        while (cur.Tell() < end) {
-            if (!NextElement(cur, sub))
-                break;
-            if (sub.id == kTrackNumberId) {
-                ti.track_number = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
-            } else if (sub.id == kTrackTypeId) {
-                ti.track_type = static_cast<uint8_t>(ReadUnsignedBE(cur, static_cast<size_t>(sub.size)) & 0xFF);
-            } else if (sub.id == kCodecId) {
-                auto payload = ReadPayload(cur, static_cast<size_t>(sub.size));
-                ti.codec_id.assign(payload.begin(), payload.end());
-                // trim trailing nulls
-                while (!ti.codec_id.empty() && ti.codec_id.back() == '\0')
-                    ti.codec_id.pop_back();
-            } else if (sub.id == kCodecPrivate) {
-                ti.codec_private = ReadPayload(cur, static_cast<size_t>(sub.size));
-            } else if (sub.id == kDefaultDurationId) {
-                ti.default_duration_ns = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
-            } else if (sub.id == kAudioId) {
-                // parse nested audio for sample rate/channels
-                size_t a_end = cur.Tell() + static_cast<size_t>(sub.size);
-                EbmlElementHeader a_sub{};
-                while (cur.Tell() < a_end) {
-                    if (!NextElement(cur, a_sub))
-                        break;
-                    if (a_sub.id == kChannelsId) {
-                        ti.aac_channel_config =
-                            static_cast<uint8_t>(ReadUnsignedBE(cur, static_cast<size_t>(a_sub.size)) & 0xFF);
-                    } else if (a_sub.id == kSamplingFreqId) {
-                        double sf = ReadFloatBE(cur, static_cast<size_t>(a_sub.size));
-                        ti.aac_sample_rate = static_cast<uint32_t>(sf + 0.5);
-                        // map to index roughly
-                        static const uint32_t rates[16] = {96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050,
-                                                           16000, 12000, 11025, 8000,  7350,  0,     0,     0};
-                        for (uint8_t i = 0; i < 16; ++i)
-                            if (rates[i] == ti.aac_sample_rate)
-                                ti.aac_sample_rate_index = i;
-                    } else {
-                        SkipBytes(cur, static_cast<size_t>(a_sub.size));
-                    }
-                }
-            } else if (sub.id == kVideoId) {
-                // parse nested video for dimensions
-                size_t v_end = cur.Tell() + static_cast<size_t>(sub.size);
-                EbmlElementHeader v_sub{};
-                while (cur.Tell() < v_end) {
-                    if (!NextElement(cur, v_sub))
-                        break;
-                    if (v_sub.id == kPixelWidthId) {
-                        ti.pixel_width = static_cast<uint32_t>(ReadUnsignedBE(cur, static_cast<size_t>(v_sub.size)));
-                    } else if (v_sub.id == kPixelHeightId) {
-                        ti.pixel_height = static_cast<uint32_t>(ReadUnsignedBE(cur, static_cast<size_t>(v_sub.size)));
-                    } else {
-                        SkipBytes(cur, static_cast<size_t>(v_sub.size));
-                    }
-                }
-            } else {
-                SkipBytes(cur, static_cast<size_t>(sub.size));
-            }
+        if (!running_) {
+            LMMKV_LOGE("Demuxer not running");
+            return -1;
+        }
+        Reset();
+        source_ = source;
+        if (!source_ || !LocateSegment()) {
+            LMMKV_LOGE("Open: Segment not found");
+            return -1;
         }
 
-        // If H264: parse avcC
-        if (StartsWith(ti.codec_id, "V_MPEG4/ISO/AVC")) {
-            ParseAvcC(ti);
+        // Jump straight to the header elements instead of walking the Segment
+        std::vector<uint8_t> payload;
+        if (ReadLevel1Element(kInfoId, payload)) {
+            BufferCursor cur(payload.data(), payload.size());
+            ParseInfoFields(cur, payload.size());
         }
-        // If HEVC: parse hvcC
-        if (StartsWith(ti.codec_id, "V_MPEGH/ISO/HEVC") || StartsWith(ti.codec_id, "V_MPEGH/ISO/HEVC")) {
-            ParseHvcC(ti);
+        if (ReadLevel1Element(kTagsId, payload)) {
+            BufferCursor cur(payload.data(), payload.size());
+            ParseTags(cur, payload.size());
         }
-        // If AAC: parse ASC
-        if (StartsWith(ti.codec_id, "A_AAC")) {
-            ParseAacAsc(ti);
+        EmitInfo();
+        if (ReadLevel1Element(kTracksId, payload)) {
+            BufferCursor cur(payload.data(), payload.size());
+            ParseTracks(cur, payload.size());
         }
+        LoadCuesFromSource();
 
-        tracks_[ti.track_number] = ti;
-
-        // Emit class-based track info
-        {
-            MkvTrackInfo t;
-            t.track_number = ti.track_number;
-            t.codec_id = ti.codec_id;
-            t.codec_name = ti.codec_id;
-            if (ti.track_type == kTrackTypeVideo) {
-                t.metadata["type"] = "video";
-                t.width = ti.pixel_width;
-                t.height = ti.pixel_height;
-            }
-            if (ti.track_type == kTrackTypeAudio) {
-                t.metadata["type"] = "audio";
-                t.sample_rate = ti.aac_sample_rate;
-                t.channels = ti.aac_channel_config;
-            }
-            t.metadata["timecode_scale_ns"] = std::to_string(timecodeScaleNs_);
-            t.codec_private = ti.codec_private;
-            auto listener = listener_.lock();
-            if (listener) {
-                listener->OnTrack(t);
+        if (firstClusterPos_ == 0) {
+            uint64_t timecode = 0;
+            const CuePoint *first = cues_.Find(0);
+            if (first) {
+                firstClusterPos_ = segmentDataPos_ + first->cluster_pos;
+            } else if (!FindClusterAt(*source_, segmentDataPos_, segmentEnd_, firstClusterPos_, timecode)) {
+                LMMKV_LOGW("Open: no Cluster found");
+                firstClusterPos_ = source_->Size();
             }
         }
+        RepositionAt(firstClusterPos_);
+        return static_cast<int64_t>(firstClusterPos_);
     }
 
-    void ParseCluster(BufferCursor &cur, uint64_t size)
+    int64_t Seek(int64_t target_ns)
     {
-        size_t end = cur.Tell() + static_cast<size_t>(size);
-        EbmlElementHeader sub{};
-        while (cur.Tell() < end) {
-            if (!NextElement(cur, sub))
-                break;
-            if (sub.id == kClusterTimecodeId) {
-                uint64_t tc = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
-                currentClusterTimecodeNs_ = tc * timecodeScaleNs_;
-            } else if (sub.id == kSimpleBlockId) {
-                ParseSimpleBlock(cur, sub.size);
-            } else if (sub.id == kBlockGroupId) {
-                // Minimal: skip BlockGroup for now
-                SkipBytes(cur, static_cast<size_t>(sub.size));
-            } else {
-                SkipBytes(cur, static_cast<size_t>(sub.size));
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!segmentSeen_ && !(source_ && LocateSegment())) {
+            LMMKV_LOGW("Seek: Segment not located yet");
+            return -1;
+        }
+        if (!cuesLoaded_ && source_) {
+            LoadCuesFromSource();
+        }
+
+        uint64_t offset = 0;
+        const CuePoint *cue = cues_.Find(target_ns);
+        if (cue) {
+            offset = segmentDataPos_ + cue->cluster_pos;
+        } else if (source_) {
+            uint64_t target_tc = target_ns > 0 ? static_cast<uint64_t>(target_ns) / timecodeScaleNs_ : 0;
+            if (!BisectClusters(*source_, segmentDataPos_, segmentEnd_, target_tc, offset)) {
+                LMMKV_LOGW("Seek: no Cluster found by bisection");
+                return -1;
             }
+        } else if ((cue = clustersSeen_.Find(target_ns)) != nullptr) {
+            // No Cues and no random access: fall back to clusters already streamed
+            offset = segmentDataPos_ + cue->cluster_pos;
+        } else {
+            LMMKV_LOGW("Seek: no Cues, byte source or streamed clusters");
+            return -1;
         }
+
+        RepositionAt(offset);
+        PrefetchClusters(offset, kPrefetchBytes);
+        LMMKV_LOGI("Seek to %lld ns -> offset %llu", (long long)target_ns, (unsigned long long)offset);
+        return static_cast<int64_t>(offset);
     }
 
-    void ParseSimpleBlock(BufferCursor &cur, uint64_t size)
+    bool SeekToOffset(uint64_t offset)
     {
-        size_t block_end = cur.Tell() + static_cast<size_t>(size);
-        // TrackNumber (vint, strip leading 1-bits like size)
-        uint64_t track_number = 0;
-        size_t tn_len = ReadVintSize(cur, track_number);
-        if (tn_len == 0) {
-            SkipBytes(cur, static_cast<size_t>(size));
-            return;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!segmentSeen_ && !(source_ && LocateSegment())) {
+            LMMKV_LOGW("SeekToOffset: Segment not located yet");
+            return false;
         }
-        // Timecode (signed 16-bit, big endian)
-        uint8_t tcb[2] = {0};
-        if (ReadBytes(cur, tcb, 2) != 2)
-            return;
-        int16_t rel_tc = static_cast<int16_t>((tcb[0] << 8) | tcb[1]);
-        // Flags
-        uint8_t flags = 0;
-        if (ReadBytes(cur, &flags, 1) != 1)
-            return;
-        bool keyframe = (flags & 0x80) != 0;
-        uint8_t lacing = (flags & 0x06) >> 1; // 0=no lacing, 1=xiph,2=fixed,3=ebml
-        std::vector<std::vector<uint8_t>> payloads;
-        std::vector<uint64_t> payload_timestamps;
-        if (lacing == 0) {
-            size_t payload_size = block_end - cur.Tell();
-            payloads.emplace_back(ReadPayload(cur, payload_size));
-            payload_timestamps.push_back(0);
-        } else if (lacing == 1) {
-            // Xiph lacing: num_frames = 1 + next byte, sizes encoded as series of bytes summing to size
-            uint8_t num_frames_minus1 = 0;
-            if (ReadBytes(cur, &num_frames_minus1, 1) != 1)
-                return;
-            uint8_t num_frames = static_cast<uint8_t>(num_frames_minus1 + 1);
-            std::vector<size_t> sizes;
-            sizes.reserve(num_frames);
-            for (uint8_t fi = 0; fi < num_frames - 1; ++fi) {
-                size_t sz = 0;
-                while (true) {
-                    uint8_t b = 0;
-                    if (ReadBytes(cur, &b, 1) != 1)
-                        return;
-                    sz += b;
-                    if (b != 255)
-                        break;
+        if (offset < segmentDataPos_ || (segmentEnd_ != kEbmlUnknownSize && offset >= segmentEnd_)) {
+            LMMKV_LOGW("SeekToOffset: offset %llu is outside the Segment", (unsigned long long)offset);
+            return false;
+        }
+        RepositionAt(offset);
+        return true;
+    }
+
+    // Pull mode: parse from the byte source until the next frame is ready. Runs without
+    // the demuxer lock so the per-frame cost is a plain function call.
+    int ReadPacket(MkvPacket &packet)
+    {
+        if (!running_ || !source_) {
+            LMMKV_LOGE("ReadPacket: demuxer not running or no byte source");
+            return -1;
+        }
+        pullMode_ = true;
+        while (true) {
+            while (HasPendingFrames()) {
+                if (BuildFrame(blockNext_++, packet)) {
+                    return 1;
                 }
-                sizes.push_back(sz);
             }
-            // last frame size is remainder
-            size_t consumed = 0;
-            for (size_t i = 0; i < sizes.size(); ++i)
-                consumed += sizes[i];
-            size_t remaining = block_end - cur.Tell();
-            size_t last_sz = remaining - consumed;
-            sizes.push_back(last_sz);
-            for (size_t sz : sizes) {
-                payloads.emplace_back(ReadPayload(cur, sz));
-                payload_timestamps.push_back(0);
-            }
-        } else if (lacing == 2) {
-            // Fixed-size lacing: num_frames = 1 + next byte, then equally sized frames
-            uint8_t num_frames_minus1 = 0;
-            if (ReadBytes(cur, &num_frames_minus1, 1) != 1)
-                return;
-            uint8_t num_frames = static_cast<uint8_t>(num_frames_minus1 + 1);
-            size_t total = block_end - cur.Tell();
-            size_t per = total / num_frames;
-            for (uint8_t fi = 0; fi < num_frames; ++fi) {
-                payloads.emplace_back(ReadPayload(cur, per));
-                payload_timestamps.push_back(0);
+            if (state_ == ParseState::kFailed) {
+                return -1;
             }
-        } else if (lacing == 3) {
-            // EBML lacing: num_frames = 1 + next byte, first size as EBML vint, then deltas as signed
-            uint8_t num_frames_minus1 = 0;
-            if (ReadBytes(cur, &num_frames_minus1, 1) != 1)
-                return;
-            uint8_t num_frames = static_cast<uint8_t>(num_frames_minus1 + 1);
-            uint64_t first_size = 0;
-            size_t vsz = ReadVintSize(cur, first_size);
-            if (vsz == 0)
-                return;
-            auto read_signed_vint = [&](int64_t &out) -> bool {
-                uint64_t u = 0;
-                size_t w = ReadVintSize(cur, u);
-                if (w == 0)
-                    return false;
-                // Mapping described in Matroska notes: signed = unsigned - (2^((7*w)-1) - 1)
-                uint64_t bias = (w >= 1) ? ((1ULL << (7 * w - 1)) - 1ULL) : 0ULL;
-                out = static_cast<int64_t>(static_cast<int64_t>(u) - static_cast<int64_t>(bias));
-                return true;
-            };
-            std::vector<size_t> sizes;
-            sizes.reserve(num_frames);
-            sizes.push_back(static_cast<size_t>(first_size));
-            for (uint8_t i = 1; i < num_frames - 1; ++i) {
-                int64_t delta = 0;
-                if (!read_signed_vint(delta))
-                    return;
-                int64_t sz = static_cast<int64_t>(sizes.back()) + delta;
-                if (sz < 0)
-                    return;
-                sizes.push_back(static_cast<size_t>(sz));
+            if (state_ == ParseState::kHeader) {
+                // Between elements carry_ only holds the block just handed out
+                carry_.clear();
             }
-            // Last frame size is remainder
-            size_t consumed = 0;
-            for (size_t i = 0; i < sizes.size(); ++i)
-                consumed += sizes[i];
-            size_t remaining = block_end - cur.Tell();
-            size_t last_sz = remaining - consumed;
-            sizes.push_back(last_sz);
-            for (size_t sz : sizes) {
-                payloads.emplace_back(ReadPayload(cur, sz));
-                payload_timestamps.push_back(0);
+            if (readPos_ == readLen_ || readOffset_ != InputPos()) {
+                // Drained, or repositioned by Open()/Seek(): read on from the parse position
+                if (state_ == ParseState::kSkip) {
+                    // The rest of a skipped payload (unwanted block, unparsed element) is not read
+                    streamPos_ += skipRemaining_;
+                    skipRemaining_ = 0;
+                    state_ = ParseState::kHeader;
+                }
+                if (readBuf_.size() < kPullReadSize) {
+                    readBuf_.resize(kPullReadSize);
+                }
+                size_t window = kPullReadSize;
+                if (keyframesOnly_) {
+                    // Read up to the end of a kept block, then peek at the next one in small steps
+                    uint64_t rest = state_ == ParseState::kPayload ? pendingHdr_.size - carry_.size() : 0;
+                    window = static_cast<size_t>(std::min<uint64_t>(kPullReadSize, rest + kPullPeekReadSize));
+                }
+                readOffset_ = InputPos();
+                readPos_ = 0;
+                readLen_ = source_->ReadAt(readOffset_, readBuf_.data(), window);
+                if (readLen_ == 0) {
+                    return 0;
+                }
+            }
+            size_t n = ParseChunk(readBuf_.data() + readPos_, readLen_ - readPos_);
+            readPos_ += n;
+            readOffset_ += n;
+            if (n == 0 && !HasPendingFrames()) {
+                // Parsing stopped on invalid data before the Segment
+                return -1;
             }
         }
+    }
 
-        auto it = tracks_.find(track_number);
-        if (it == tracks_.end()) {
-            // Unknown track, skip
-            return;
+    bool DemuxParallel(const std::shared_ptr<IByteSource> &source, size_t threads)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (OpenLocked(source) < 0) {
+            return false;
         }
-        const TrackInfo &ti = it->second;
-        uint64_t timestamp_ns = currentClusterTimecodeNs_ + static_cast<int64_t>(rel_tc) * timecodeScaleNs_;
-
-        // Calculate per-frame timestamps for laced frames if DefaultDuration is known
-        for (size_t i = 0; i < payloads.size(); ++i) {
-            const auto &payload = payloads[i];
-            std::vector<uint8_t> out;
-            if (ti.track_type == kTrackTypeVideo && StartsWith(ti.codec_id, "V_MPEG4/ISO/AVC")) {
-                out = ConvertAvccFrameToAnnexB(ti, payload.data(), payload.size(), keyframe);
-            } else if (ti.track_type == kTrackTypeVideo && StartsWith(ti.codec_id, "V_MPEGH/ISO/HEVC")) {
-                out = ConvertHvccFrameToAnnexB(ti, payload.data(), payload.size(), keyframe);
-            } else if (ti.track_type == kTrackTypeAudio && StartsWith(ti.codec_id, "A_AAC")) {
-                auto adts = BuildAdtsHeader(ti, payload.size());
-                out.insert(out.end(), adts.begin(), adts.end());
-                out.insert(out.end(), payload.begin(), payload.end());
-            } else if (ti.track_type == kTrackTypeAudio && StartsWith(ti.codec_id, "A_OPUS")) {
-                // For Opus, emit raw Opus packets (no Ogg framing) and let consumer wrap if needed.
-                out.insert(out.end(), payload.begin(), payload.end());
-            } else {
-                // Unsupported codec/frame, skip
-                continue;
-            }
-            if (!out.empty()) {
-                if (!trackFilter_.empty() && trackFilter_.count(track_number) == 0) {
-                    continue;
-                }
-                uint64_t ts_emit = timestamp_ns;
-                if (i > 0 && ti.default_duration_ns > 0) {
-                    ts_emit = timestamp_ns + static_cast<uint64_t>(i) * ti.default_duration_ns;
+        uint64_t end = std::min<uint64_t>(source_->Size(), segmentEnd_);
+
+        // Split at Cluster boundaries: Cues when present, otherwise a header walk
+        std::vector<uint64_t> starts;
+        if (!cues_.Empty()) {
+            EbmlElementHeader hdr{};
+            size_t header_len = 0;
+            starts.push_back(firstClusterPos_);
+            for (const auto &point : cues_.Points()) {
+                uint64_t pos = segmentDataPos_ + point.cluster_pos;
+                if (pos > firstClusterPos_ && pos < end && ReadHeaderAt(*source_, pos, hdr, header_len) &&
+                    hdr.id == kClusterId) {
+                    starts.push_back(pos);
                 }
-                MkvFrame f;
-                f.track_number = track_number;
-                f.timecode_ns = static_cast<int64_t>(ts_emit);
-                f.keyframe = keyframe;
-                f.data = out.data();
-                f.size = out.size();
-                auto listener = listener_.lock();
-                if (listener) {
-                    listener->OnFrame(f);
+            }
+            std::sort(starts.begin(), starts.end());
+            starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+        } else {
+            ListClusterStarts(*source_, firstClusterPos_, end, starts);
+        }
+        if (starts.empty() || starts.front() >= end) {
+            LMMKV_LOGW("DemuxParallel: no Cluster found");
+            RepositionAt(end);
+            return true;
+        }
+
+        std::vector<ParallelJob> jobs;
+        for (size_t i = 0; i < starts.size(); ++i) {
+            if (jobs.empty() || starts[i] - jobs.back().begin >= kParallelJobBytes) {
+                if (!jobs.empty()) {
+                    jobs.back().end = starts[i];
                 }
+                jobs.emplace_back();
+                jobs.back().begin = starts[i];
             }
         }
-    }
+        jobs.back().end = end;
 
-private:
-    mutable std::mutex mutex_;
-    bool running_;
-    uint64_t timecodeScaleNs_;
-    uint64_t currentClusterTimecodeNs_;
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = std::min(threads, jobs.size());
+        size_t window = threads * kParallelJobsPerWorker;
+        LMMKV_LOGI("DemuxParallel: %zu clusters in %zu jobs on %zu threads", starts.size(), jobs.size(), threads);
 
-    std::unordered_map<uint64_t, TrackInfo> tracks_;
-    std::unordered_set<uint64_t> trackFilter_;
-    std::weak_ptr<IMkvDemuxListener> listener_;
+        std::mutex job_mutex;
+        std::condition_variable job_cv;
+        size_t next = 0;
+        size_t emitted = 0;
+        auto worker_main = [&]() {
+            // Workers allocate from the thread-safe global heap; scratch is reused across jobs
+            Impl worker(std::pmr::new_delete_resource());
+            worker.InheritStreamContext(*this);
+            auto collector = std::make_shared<ParallelJobCollector>();
+            worker.listener_ = collector;
+            std::vector<uint8_t> input;
+            while (true) {
+                size_t index = 0;
+                {
+                    std::unique_lock<std::mutex> job_lock(job_mutex);
+                    job_cv.wait(job_lock, [&] { return next >= jobs.size() || next < emitted + window; });
+                    if (next >= jobs.size()) {
+                        return;
+                    }
+                    index = next++;
+                }
+                if (index + threads < jobs.size()) {
+                    // The job a worker takes after this round
+                    const ParallelJob &ahead = jobs[index + threads];
+                    source_->Prefetch(ahead.begin, static_cast<size_t>(ahead.end - ahead.begin));
+                }
+                ParallelJob &job = jobs[index];
+                input.resize(static_cast<size_t>(job.end - job.begin));
+                size_t n = source_->ReadAt(job.begin, input.data(), input.size());
+                if (n != input.size()) {
+                    job.errors.emplace_back(kMkvErrorInvalidData, "Short read of Clusters at offset " +
+                                                                      std::to_string(job.begin));
+                }
+                collector->SetJob(&job);
+                worker.RepositionAt(job.begin);
+                worker.ParseData(input.data(), n);
+                {
+                    std::lock_guard<std::mutex> job_lock(job_mutex);
+                    job.done = true;
+                }
+                job_cv.notify_all();
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back(worker_main);
+        }
+        auto listener = listener_.lock();
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            {
+                std::unique_lock<std::mutex> job_lock(job_mutex);
+                job_cv.wait(job_lock, [&] { return jobs[i].done; });
+            }
+            EmitParallelJob(jobs[i], listener.get());
+            std::vector<uint8_t>().swap(jobs[i].bytes);
+            std::vector<ParallelJob::Frame>().swap(jobs[i].frames);
+            std::vector<std::pair<size_t, size_t>>().swap(jobs[i].slices);
+            {
+                std::lock_guard<std::mutex> job_lock(job_mutex);
+                emitted = i + 1;
+            }
+            job_cv.notify_all();
+        }
+        for (auto &t : workers) {
+            t.join();
+        }
+        RepositionAt(end);
+        return true;
+    }
+
+private:
+    // Master element currently being descended into
+    struct ContainerLevel {
+        uint64_t id;
+        uint64_t end;      // absolute stream offset one past the payload
+        bool unknown_size; // live stream: ends at the next non-child element
+    };
+
+    enum class ParseState {
+        kHeader,    // expecting the next element header
+        kPayload,   // gathering a payload that is parsed as a whole
+        kSkip,      // discarding a payload we do not parse
+        kBlockPeek, // reading the first bytes of a SimpleBlock to decide whether to keep it
+        kResync,    // dropping corrupt bytes until the next valid Cluster
+        kFailed,    // unrecoverable input error; cleared by Reset()
+    };
+
+    // Hint the byte source that the Clusters from pos on are read next: up to the Cue
+    // point after pos when Cues are loaded, otherwise size_hint bytes.
+    void PrefetchClusters(uint64_t pos, uint64_t size_hint)
+    {
+        if (!source_ || pos >= source_->Size()) {
+            return;
+        }
+        uint64_t size = size_hint;
+        if (!cues_.Empty() && pos >= segmentDataPos_) {
+            const auto &points = cues_.Points();
+            auto it = std::upper_bound(points.begin(), points.end(), pos - segmentDataPos_,
+                                       [](uint64_t rel, const CuePoint &p) { return rel < p.cluster_pos; });
+            // Points are in time order, which is file order in practice
+            if (it != points.end() && it->cluster_pos > pos - segmentDataPos_) {
+                size = segmentDataPos_ + it->cluster_pos - pos;
+            }
+        }
+        size = std::min(size, std::min(kPrefetchBytes, source_->Size() - pos));
+        source_->Prefetch(pos, static_cast<size_t>(size));
+    }
+
+    // Stream offset of the next input byte, after any bytes still to be replayed
+    uint64_t InputPos() const { return streamPos_ + (replay_.size() - replayPos_); }
+
+    void Advance(size_t &off, size_t n)
+    {
+        off += n;
+        streamPos_ += n;
+    }
+
+    void Fail(int code, const std::string &msg)
+    {
+        FlushFrames();
+        LMMKV_LOGE("%s", msg.c_str());
+        state_ = ParseState::kFailed;
+        auto listener = listener_.lock();
+        if (listener) {
+            listener->OnError(code, msg);
+        }
+    }
+
+    // Corrupt input inside a Segment drops bytes up to the next valid Cluster instead
+    // of stopping; before the Segment there is nothing to resync on. from is the
+    // offset of the first bad byte. Returns false if parsing failed.
+    bool Corrupt(int code, const std::string &msg, uint64_t from)
+    {
+        if (levels_.empty() || levels_.front().id != kSegmentId) {
+            Fail(code, msg);
+            return false;
+        }
+        LMMKV_LOGW("%s; resynchronizing on the next Cluster", msg.c_str());
+        state_ = ParseState::kResync;
+        resyncStart_ = from;
+        headerLen_ = 0;
+        carry_.clear();
+        resyncBuf_.clear();
+        return true;
+    }
+
+    // Scan for a Cluster ID whose Timecode child validates. Candidates cut off at the
+    // end of a buffer are held in resyncBuf_ (at most kClusterProbeLength bytes) and
+    // completed from the next call, so the scan works on any input split.
+    void Resync(const uint8_t *data, size_t size, size_t &off)
+    {
+        size_t avail = size - off;
+        size_t held = resyncBuf_.size();
+        size_t pos = 0;
+        if (held == 0) {
+            bool found = ScanForClusterStart(data + off, avail, pos);
+            Advance(off, pos);
+            if (found) {
+                EndResync();
+                return;
+            }
+            resyncBuf_.assign(data + off, data + size);
+            Advance(off, size - off);
+            return;
+        }
+
+        size_t n = std::min(avail, kClusterProbeLength);
+        resyncBuf_.insert(resyncBuf_.end(), data + off, data + off + n);
+        bool found = ScanForClusterStart(resyncBuf_.data(), resyncBuf_.size(), pos);
+        if (pos >= held) {
+            // Held bytes are ruled out; continue in the caller's buffer
+            resyncBuf_.clear();
+            Advance(off, pos - held);
+            if (found) {
+                EndResync();
+            }
+            return;
+        }
+        if (found) {
+            // The Cluster starts in the held bytes: ParseChunk() replays them before off.
+            // They stay in replay_ after that, as frames may point into them.
+            size_t len = held - pos;
+            streamPos_ -= len;
+            EndResync();
+            replay_.assign(resyncBuf_.begin() + static_cast<std::ptrdiff_t>(pos), resyncBuf_.begin() + held);
+            replayPos_ = 0;
+            resyncBuf_.clear();
+            return;
+        }
+        resyncBuf_.erase(resyncBuf_.begin(), resyncBuf_.begin() + static_cast<std::ptrdiff_t>(pos));
+        Advance(off, n);
+    }
+
+    // First validated Cluster start in data. Returns true with its index, or false with
+    // the index of the first byte that could still begin one once more data arrives.
+    static bool ScanForClusterStart(const uint8_t *data, size_t size, size_t &pos)
+    {
+        const uint8_t *end = data + size;
+        const uint8_t *p = data;
+        uint64_t timecode = 0;
+        while ((p = FindClusterId(p, end)) != nullptr) {
+            EbmlProbeResult res = ProbeClusterStart(p, static_cast<size_t>(end - p), timecode);
+            if (res == EbmlProbeResult::kOk ||
+                (res == EbmlProbeResult::kNeedMore && static_cast<size_t>(end - p) < kClusterProbeLength)) {
+                pos = static_cast<size_t>(p - data);
+                return res == EbmlProbeResult::kOk;
+            }
+            ++p;
+        }
+        // Keep a tail that may hold the first bytes of a Cluster ID
+        pos = size - std::min<size_t>(size, kEbmlMaxIdLength - 1);
+        return false;
+    }
+
+    // Resume at the Cluster found at streamPos_ and report the bytes dropped
+    void EndResync()
+    {
+        ReportSkipped(streamPos_);
+        RepositionAt(streamPos_);
+    }
+
+    void ReportSkipped(uint64_t end)
+    {
+        std::string msg = "Skipped " + std::to_string(end - resyncStart_) + " corrupt bytes [" +
+                          std::to_string(resyncStart_) + ", " + std::to_string(end) + ")";
+        LMMKV_LOGW("%s", msg.c_str());
+        FlushFrames();
+        auto listener = listener_.lock();
+        if (listener) {
+            listener->OnError(kMkvErrorResync, msg);
+        }
+    }
+
+    void CloseFinishedLevels()
+    {
+        while (!levels_.empty() && streamPos_ >= levels_.back().end) {
+            levels_.pop_back();
+        }
+    }
+
+    // Resume streaming inside the Segment at a Cluster boundary
+    void RepositionAt(uint64_t offset)
+    {
+        levels_.clear();
+        levels_.push_back({kSegmentId, segmentEnd_, segmentEnd_ == kEbmlUnknownSize});
+        state_ = ParseState::kHeader;
+        streamPos_ = offset;
+        skipRemaining_ = 0;
+        headerLen_ = 0;
+        carry_.clear();
+        replay_.clear();
+        replayPos_ = 0;
+        currentClusterTimecodeNs_ = 0;
+        blockNext_ = blockCount_ = 0;
+    }
+
+    // Parallel worker setup: parse Clusters with the parent's Segment, Tracks and output settings
+    void InheritStreamContext(const Impl &parent)
+    {
+        running_ = true;
+        tracks_ = parent.tracks_;
+        trackFilter_ = parent.trackFilter_;
+        keyframesOnly_ = parent.keyframesOnly_;
+        outputMode_ = parent.outputMode_;
+        timecodeScaleNs_ = parent.timecodeScaleNs_;
+        segmentSeen_ = true;
+        segmentDataPos_ = parent.segmentDataPos_;
+        segmentEnd_ = parent.segmentEnd_;
+    }
+
+    // Deliver a finished parallel job, pointing frames back into its byte arena
+    void EmitParallelJob(const ParallelJob &job, IMkvDemuxListener *listener)
+    {
+        if (listener == nullptr) {
+            return;
+        }
+        for (const auto &out : job.frames) {
+            MkvFrame &f = batchSize_ > 0 ? batch_[batchCount_] : frame_;
+            f.track_number = out.meta.track_number;
+            f.timecode_ns = out.meta.timecode_ns;
+            f.keyframe = out.meta.keyframe;
+            f.duration_ns = out.meta.duration_ns;
+            f.references_ns.assign(out.meta.references_ns.begin(), out.meta.references_ns.end());
+            f.size = out.meta.size;
+            f.data = out.has_data ? job.bytes.data() + out.offset : nullptr;
+            f.slices.clear();
+            for (size_t i = 0; i < out.slice_count; ++i) {
+                const auto &s = job.slices[out.slice_begin + i];
+                f.slices.emplace_back(job.bytes.data() + s.first, s.second);
+            }
+            if (batchSize_ == 0) {
+                listener->OnFrame(f);
+            } else if (++batchCount_ == batchSize_) {
+                FlushFrames();
+            }
+        }
+        FlushFrames();
+        for (const auto &err : job.errors) {
+            listener->OnError(err.first, err.second);
+        }
+    }
+
+    // An unknown-size Cluster ends at the next Segment-level or top-level element,
+    // an unknown-size Segment at the next top-level element.
+    void CloseUnknownSizeLevels(uint64_t id)
+    {
+        while (!levels_.empty() && levels_.back().unknown_size) {
+            uint64_t open_id = levels_.back().id;
+            bool ends = IsTopLevelId(id) || (open_id == kClusterId && IsSegmentLevelId(id));
+            if (!ends) {
+                break;
+            }
+            levels_.pop_back();
+        }
+    }
+
+    // Decode the next element header, completing one that was split across calls.
+    EbmlProbeResult ReadHeader(const uint8_t *data, size_t size, size_t &off, EbmlElementHeader &hdr)
+    {
+        size_t avail = size - off;
+        size_t header_len = 0;
+        if (headerLen_ == 0) {
+            EbmlProbeResult res = ProbeElementHeader(data + off, avail, hdr, header_len);
+            if (res == EbmlProbeResult::kOk) {
+                Advance(off, header_len);
+                lastHeaderLen_ = header_len;
+            } else if (res == EbmlProbeResult::kNeedMore) {
+                std::memcpy(headerBuf_, data + off, avail);
+                headerLen_ = avail;
+                Advance(off, avail);
+            }
+            return res;
+        }
+
+        size_t n = std::min(kEbmlMaxHeaderLength - headerLen_, avail);
+        std::memcpy(headerBuf_ + headerLen_, data + off, n);
+        EbmlProbeResult res = ProbeElementHeader(headerBuf_, headerLen_ + n, hdr, header_len);
+        if (res == EbmlProbeResult::kOk) {
+            Advance(off, header_len - headerLen_);
+            headerLen_ = 0;
+            lastHeaderLen_ = header_len;
+        } else if (res == EbmlProbeResult::kNeedMore) {
+            headerLen_ += n;
+            Advance(off, n);
+        }
+        return res;
+    }
+
+    // Decide how to treat the element whose header was just read.
+    bool BeginElement(const EbmlElementHeader &hdr)
+    {
+        CloseUnknownSizeLevels(hdr.id);
+        uint64_t parent_id = levels_.empty() ? 0 : levels_.back().id;
+        bool unknown_size = hdr.size == kEbmlUnknownSize;
+        uint64_t header_pos = streamPos_ - lastHeaderLen_;
+        if (!unknown_size && !levels_.empty() && hdr.size > levels_.back().end - streamPos_) {
+            return Corrupt(kMkvErrorInvalidData,
+                           "Element 0x" + ToHex(hdr.id) + " overflows its parent at offset " +
+                               std::to_string(header_pos),
+                           header_pos);
+        }
+
+        // Only elements at their schema position are interpreted; anything else is skipped
+        MkvElement element = ElementOf(hdr.id);
+        if (element != MkvElement::kUnknown && SpecOf(element).parent != parent_id) {
+            element = MkvElement::kUnknown;
+        }
+        if (element != MkvElement::kUnknown && !unknown_size && !IsValidSize(SpecOf(element), hdr.size)) {
+            return Corrupt(kMkvErrorInvalidData,
+                           std::string("Invalid size ") + std::to_string(hdr.size) + " for " + SpecOf(element).name +
+                               " at offset " + std::to_string(header_pos),
+                           header_pos);
+        }
+
+        bool descend = false;
+        bool gather = false;
+        switch (element) {
+            case MkvElement::kSegment:
+            case MkvElement::kCluster:
+                descend = true;
+                break;
+            case MkvElement::kInfo:
+            case MkvElement::kTracks:
+            case MkvElement::kSeekHead:
+            case MkvElement::kCues:
+            case MkvElement::kTags:
+            case MkvElement::kClusterTimecode:
+            case MkvElement::kSimpleBlock:
+            case MkvElement::kBlockGroup:
+                gather = true;
+                break;
+            default:
+                break;
+        }
+
+        if (unknown_size && !descend) {
+            return Corrupt(kMkvErrorInvalidData,
+                           "Unknown size on element 0x" + ToHex(hdr.id) + " at offset " + std::to_string(header_pos),
+                           header_pos);
+        }
+
+        if (descend) {
+            if (hdr.id == kClusterId) {
+                FlushFrames();
+                TrimScratch();
+                clusterStart_ = streamPos_ - lastHeaderLen_;
+                if (pullMode_ && !unknown_size) {
+                    // Read the next Cluster while this one is parsed; assume it is about as large
+                    PrefetchClusters(streamPos_ + hdr.size, lastHeaderLen_ + hdr.size);
+                }
+            }
+            uint64_t end = streamPos_ + hdr.size;
+            if (unknown_size) {
+                end = levels_.empty() ? kEbmlUnknownSize : levels_.back().end;
+            }
+            if (hdr.id == kSegmentId) {
+                segmentSeen_ = true;
+                segmentDataPos_ = streamPos_;
+                segmentEnd_ = end;
+            }
+            levels_.push_back({hdr.id, end, unknown_size});
+            state_ = ParseState::kHeader;
+        } else if (gather) {
+            if (hdr.size > kMaxBufferedElementSize) {
+                return Corrupt(kMkvErrorElementTooLarge,
+                               "Element 0x" + ToHex(hdr.id) + " too large to buffer: " + std::to_string(hdr.size) +
+                                   " bytes",
+                               header_pos);
+            }
+            pendingHdr_ = hdr;
+            state_ = ParseState::kPayload;
+            if (element == MkvElement::kSimpleBlock && (keyframesOnly_ || !trackFilter_.empty())) {
+                state_ = ParseState::kBlockPeek;
+            }
+            if (hdr.size == 0) {
+                state_ = ParseState::kHeader;
+                HandleElement(hdr.id, nullptr, 0);
+            }
+        } else {
+            skipRemaining_ = hdr.size;
+            state_ = hdr.size > 0 ? ParseState::kSkip : ParseState::kHeader;
+        }
+        return true;
+    }
+
+    // Parse a fully buffered element payload.
+    void HandleElement(uint64_t id, const uint8_t *payload, size_t size)
+    {
+        BufferCursor cur(payload, size);
+        switch (ElementOf(id)) {
+            case MkvElement::kInfo:
+                ParseInfo(cur, size);
+                break;
+            case MkvElement::kTracks:
+                ParseTracks(cur, size);
+                break;
+            case MkvElement::kClusterTimecode:
+                currentClusterTimecodeNs_ = ReadUnsignedBE(cur, size) * timecodeScaleNs_;
+                clustersSeen_.Add(static_cast<int64_t>(currentClusterTimecodeNs_), clusterStart_ - segmentDataPos_);
+                break;
+            case MkvElement::kTags:
+                // Tags usually trail the Clusters; report them as an Info update
+                ParseTags(cur, size);
+                EmitInfo();
+                break;
+            case MkvElement::kSeekHead:
+                seekEntries_.clear();
+                ParseSeekHead(cur, size, seekEntries_);
+                break;
+            case MkvElement::kCues:
+                cues_.Clear();
+                ParseCues(cur, size, timecodeScaleNs_, cues_);
+                cues_.Finalize();
+                cuesLoaded_ = true;
+                break;
+            case MkvElement::kSimpleBlock:
+                ParseSimpleBlock(cur, size);
+                break;
+            case MkvElement::kBlockGroup:
+                ParseBlockGroup(cur, size);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Called per cluster: give back scratch memory that a single outsized frame
+    // grew far beyond what the previous cluster needed. Capacity is otherwise kept.
+    void TrimScratch()
+    {
+        size_t keep = std::max(scratchPeak_, kScratchTrimThreshold);
+        if (carry_.empty() && carry_.capacity() > 4 * keep) {
+            carry_.shrink_to_fit();
+        }
+        if (frameBuf_.capacity() > 4 * keep) {
+            frameBuf_.clear();
+            frameBuf_.shrink_to_fit();
+        }
+        if (batchBytes_.capacity() > 4 * keep) {
+            batchBytes_.shrink_to_fit();
+        }
+        scratchPeak_ = 0;
+    }
+
+    static std::string ToHex(uint64_t v)
+    {
+        char buf[20];
+        std::snprintf(buf, sizeof(buf), "%llX", (unsigned long long)v);
+        return buf;
+    }
+
+    void ParseInfo(BufferCursor &cur, uint64_t size)
+    {
+        ParseInfoFields(cur, size);
+        LMMKV_LOGI("Info: TimecodeScale=%llu ns", (unsigned long long)timecodeScaleNs_);
+        EmitInfo();
+    }
+
+    void EmitInfo()
+    {
+        FlushFrames();
+        MkvInfo info;
+        info.timecode_scale_ns = timecodeScaleNs_;
+        info.duration_seconds = durationTicks_ * static_cast<double>(timecodeScaleNs_) / 1e9;
+        info.tags = tags_;
+        auto listener = listener_.lock();
+        if (listener) {
+            listener->OnInfo(info);
+        }
+    }
+
+    // Collect global SimpleTag name/value pairs; track-targeted tags are ignored
+    void ParseTags(BufferCursor &cur, uint64_t size)
+    {
+        size_t end = cur.Tell() + static_cast<size_t>(size);
+        EbmlElementHeader tag{};
+        while (cur.Tell() < end) {
+            if (!NextElement(cur, tag) || tag.size > end - cur.Tell())
+                break;
+            size_t tag_end = cur.Tell() + static_cast<size_t>(tag.size);
+            if (tag.id != kTagId) {
+                cur.Seek(tag_end);
+                continue;
+            }
+            bool global = true;
+            std::vector<std::pair<std::string, std::string>> simple;
+            EbmlElementHeader sub{};
+            while (cur.Tell() < tag_end) {
+                if (!NextElement(cur, sub) || sub.size > tag_end - cur.Tell())
+                    break;
+                size_t sub_end = cur.Tell() + static_cast<size_t>(sub.size);
+                if (sub.id == kTargetsId) {
+                    EbmlElementHeader target{};
+                    while (cur.Tell() < sub_end) {
+                        if (!NextElement(cur, target) || target.size > sub_end - cur.Tell())
+                            break;
+                        if (target.id == kTagTrackUidId) {
+                            global = false;
+                        }
+                        SkipBytes(cur, static_cast<size_t>(target.size));
+                    }
+                } else if (sub.id == kSimpleTagId) {
+                    std::string name;
+                    std::string value;
+                    EbmlElementHeader field{};
+                    while (cur.Tell() < sub_end) {
+                        if (!NextElement(cur, field) || field.size > sub_end - cur.Tell())
+                            break;
+                        if (field.id == kTagNameId || field.id == kTagStringId) {
+                            std::string &dst = field.id == kTagNameId ? name : value;
+                            dst.assign(reinterpret_cast<const char *>(cur.Current()), static_cast<size_t>(field.size));
+                            while (!dst.empty() && dst.back() == '\0')
+                                dst.pop_back();
+                        }
+                        SkipBytes(cur, static_cast<size_t>(field.size));
+                    }
+                    if (!name.empty()) {
+                        simple.emplace_back(std::move(name), std::move(value));
+                    }
+                }
+                cur.Seek(sub_end);
+            }
+            if (global) {
+                for (auto &kv : simple) {
+                    tags_[kv.first] = kv.second;
+                }
+            }
+            cur.Seek(tag_end);
+        }
+    }
+
+    void ParseInfoFields(BufferCursor &cur, uint64_t size)
+    {
+        size_t end = cur.Tell() + static_cast<size_t>(size);
+        EbmlElementHeader sub{};
+        while (cur.Tell() < end) {
+            if (!NextElement(cur, sub))
+                break;
+            switch (ElementOf(sub.id)) {
+                case MkvElement::kTimecodeScale:
+                    timecodeScaleNs_ = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                    break;
+                case MkvElement::kDuration:
+                    // float, in TimecodeScale units
+                    durationTicks_ = ReadFloatBE(cur, static_cast<size_t>(sub.size));
+                    break;
+                default:
+                    SkipBytes(cur, static_cast<size_t>(sub.size));
+                    break;
+            }
+        }
+    }
+
+    // Read a whole element payload through the byte source
+    bool ReadSourcePayload(uint64_t offset, uint64_t size, std::vector<uint8_t> &out)
+    {
+        if (size > kMaxBufferedElementSize) {
+            return false;
+        }
+        out.resize(static_cast<size_t>(size));
+        return source_->ReadAt(offset, out.data(), out.size()) == out.size();
+    }
+
+    // Find the Segment through the byte source and read the SeekHead and Info that
+    // precede the first Cluster, without emitting anything.
+    bool LocateSegment()
+    {
+        EbmlElementHeader hdr{};
+        size_t header_len = 0;
+        uint64_t off = 0;
+        while (ReadHeaderAt(*source_, off, hdr, header_len)) {
+            if (hdr.id == kSegmentId) {
+                segmentSeen_ = true;
+                segmentDataPos_ = off + header_len;
+                segmentEnd_ = hdr.size == kEbmlUnknownSize ? kEbmlUnknownSize : segmentDataPos_ + hdr.size;
+                break;
+            }
+            if (hdr.size == kEbmlUnknownSize) {
+                return false;
+            }
+            off += header_len + hdr.size;
+        }
+        if (!segmentSeen_) {
+            return false;
+        }
+
+        // Walk level-1 headers up to the first Cluster. Only headers are read, plus
+        // the SeekHead and Info payloads; other elements are recorded like SeekHead
+        // entries so Open() can reach them even when the SeekHead omits them.
+        std::vector<uint8_t> payload;
+        std::vector<SeekEntry> walked;
+        uint64_t parsed_seek_head = kEbmlUnknownSize;
+        off = segmentDataPos_;
+        while (off < segmentEnd_ && ReadHeaderAt(*source_, off, hdr, header_len)) {
+            if (hdr.id == kClusterId) {
+                firstClusterPos_ = off;
+                break;
+            }
+            if (hdr.size == kEbmlUnknownSize) {
+                break;
+            }
+            walked.push_back({hdr.id, off - segmentDataPos_});
+            if ((hdr.id == kSeekHeadId || hdr.id == kInfoId) &&
+                ReadSourcePayload(off + header_len, hdr.size, payload)) {
+                BufferCursor cur(payload.data(), payload.size());
+                if (hdr.id == kSeekHeadId) {
+                    ParseSeekHead(cur, payload.size(), seekEntries_);
+                    parsed_seek_head = off;
+                } else {
+                    ParseInfoFields(cur, payload.size());
+                }
+            }
+            off += header_len + hdr.size;
+        }
+
+        // Follow a SeekHead that points at a further SeekHead (e.g. one written at the end)
+        std::vector<SeekEntry> chained;
+        for (const auto &entry : seekEntries_) {
+            uint64_t pos = segmentDataPos_ + entry.pos;
+            if (entry.id != kSeekHeadId || pos == parsed_seek_head ||
+                !ReadHeaderAt(*source_, pos, hdr, header_len) || hdr.id != kSeekHeadId ||
+                !ReadSourcePayload(pos + header_len, hdr.size, payload)) {
+                continue;
+            }
+            BufferCursor cur(payload.data(), payload.size());
+            ParseSeekHead(cur, payload.size(), chained);
+        }
+        seekEntries_.insert(seekEntries_.end(), chained.begin(), chained.end());
+        // Walked positions go last: they are verified, but SeekHead entries may point past the first Cluster
+        seekEntries_.insert(seekEntries_.end(), walked.begin(), walked.end());
+        return true;
+    }
+
+    // Read a level-1 element announced by the SeekHead (or found by the walk) into out.
+    // Entries are tried in order so a stale SeekHead position falls back to the next candidate.
+    bool ReadLevel1Element(uint64_t id, std::vector<uint8_t> &out)
+    {
+        EbmlElementHeader hdr{};
+        size_t header_len = 0;
+        for (const auto &entry : seekEntries_) {
+            if (entry.id != id) {
+                continue;
+            }
+            uint64_t off = segmentDataPos_ + entry.pos;
+            if (ReadHeaderAt(*source_, off, hdr, header_len) && hdr.id == id &&
+                ReadSourcePayload(off + header_len, hdr.size, out)) {
+                return true;
+            }
+            LMMKV_LOGW("SeekHead entry 0x%llX points to invalid data at %llu", (unsigned long long)id,
+                       (unsigned long long)off);
+        }
+        return false;
+    }
+
+    // Load Cues at the position announced by the SeekHead
+    void LoadCuesFromSource()
+    {
+        cuesLoaded_ = true; // one attempt; files without Cues fall back to bisection
+        std::vector<uint8_t> payload;
+        if (!ReadLevel1Element(kCuesId, payload)) {
+            return;
+        }
+        BufferCursor cur(payload.data(), payload.size());
+        cues_.Clear();
+        ParseCues(cur, payload.size(), timecodeScaleNs_, cues_);
+        cues_.Finalize();
+        LMMKV_LOGI("Loaded %zu cue points", cues_.Size());
+    }
+
+    void ParseTracks(BufferCursor &cur, uint64_t size)
+    {
+        size_t end = cur.Tell() + static_cast<size_t>(size);
+        EbmlElementHeader sub{};
+        while (cur.Tell() < end) {
+            if (!NextElement(cur, sub))
+                break;
+            size_t payload_end = cur.Tell() + static_cast<size_t>(sub.size);
+            if (sub.id == kTrackEntryId) {
+                ParseTrackEntry(cur, sub.size);
+            } else {
+                // skip unknown track-level elements
+            }
+            if (!cur.Seek(payload_end))
+                break;
+        }
+    }
+
+    // Audio: sample rate and channels for ADTS headers
+    void ParseTrackAudio(BufferCursor &cur, uint64_t size, TrackInfo &ti)
+    {
+        size_t end = cur.Tell() + static_cast<size_t>(size);
+        EbmlElementHeader sub{};
+        while (cur.Tell() < end) {
+            if (!NextElement(cur, sub))
+                break;
+            switch (ElementOf(sub.id)) {
+                case MkvElement::kChannels:
+                    ti.channels = static_cast<uint32_t>(ReadUnsignedBE(cur, static_cast<size_t>(sub.size)) & 0xFF);
+                    break;
+                case MkvElement::kSamplingFreq:
+                    ti.sample_rate = static_cast<uint32_t>(ReadFloatBE(cur, static_cast<size_t>(sub.size)) + 0.5);
+                    break;
+                default:
+                    SkipBytes(cur, static_cast<size_t>(sub.size));
+                    break;
+            }
+        }
+    }
+
+    // Video: dimensions
+    void ParseTrackVideo(BufferCursor &cur, uint64_t size, TrackInfo &ti)
+    {
+        size_t end = cur.Tell() + static_cast<size_t>(size);
+        EbmlElementHeader sub{};
+        while (cur.Tell() < end) {
+            if (!NextElement(cur, sub))
+                break;
+            switch (ElementOf(sub.id)) {
+                case MkvElement::kPixelWidth:
+                    ti.pixel_width = static_cast<uint32_t>(ReadUnsignedBE(cur, static_cast<size_t>(sub.size)));
+                    break;
+                case MkvElement::kPixelHeight:
+                    ti.pixel_height = static_cast<uint32_t>(ReadUnsignedBE(cur, static_cast<size_t>(sub.size)));
+                    break;
+                default:
+                    SkipBytes(cur, static_cast<size_t>(sub.size));
+                    break;
+            }
+        }
+    }
+
+    void ParseTrackEntry(BufferCursor &cur, uint64_t size)
+    {
+        size_t end = cur.Tell() + static_cast<size_t>(size);
+        EbmlElementHeader sub{};
+        TrackInfo ti;
+        while (cur.Tell() < end) {
+            if (!NextElement(cur, sub))
+                break;
+            switch (ElementOf(sub.id)) {
+                case MkvElement::kTrackNumber:
+                    ti.track_number = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                    break;
+                case MkvElement::kTrackType:
+                    ti.track_type = static_cast<uint8_t>(ReadUnsignedBE(cur, static_cast<size_t>(sub.size)) & 0xFF);
+                    break;
+                case MkvElement::kCodec: {
+                    auto payload = ReadPayload(cur, static_cast<size_t>(sub.size));
+                    ti.codec_id.assign(payload.begin(), payload.end());
+                    // trim trailing nulls
+                    while (!ti.codec_id.empty() && ti.codec_id.back() == '\0')
+                        ti.codec_id.pop_back();
+                    break;
+                }
+                case MkvElement::kCodecPrivate:
+                    ti.codec_private = ReadPayload(cur, static_cast<size_t>(sub.size));
+                    break;
+                case MkvElement::kDefaultDuration:
+                    ti.default_duration_ns = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                    break;
+                case MkvElement::kAudio:
+                    ParseTrackAudio(cur, sub.size, ti);
+                    break;
+                case MkvElement::kVideo:
+                    ParseTrackVideo(cur, sub.size, ti);
+                    break;
+                case MkvElement::kContentEncodings:
+                    ParseContentEncodings(cur, static_cast<size_t>(sub.size), ti.encoding);
+                    break;
+                default:
+                    SkipBytes(cur, static_cast<size_t>(sub.size));
+                    break;
+            }
+        }
+        if (ti.encoding.codec_private) {
+            DecodeCodecPrivate(ti);
+        }
+
+        MkvTrackInfo t;
+        t.track_number = ti.track_number;
+        t.codec_id = ti.codec_id;
+        t.codec_name = ti.codec_id;
+        if (ti.track_type == kTrackTypeVideo) {
+            t.metadata["type"] = "video";
+            t.width = ti.pixel_width;
+            t.height = ti.pixel_height;
+        }
+        if (ti.track_type == kTrackTypeAudio) {
+            t.metadata["type"] = "audio";
+            t.sample_rate = ti.sample_rate;
+            t.channels = ti.channels;
+            AacConfig asc;
+            if (StartsWith(ti.codec_id, "A_AAC") && ParseAacConfig(ti.codec_private, asc)) {
+                t.sample_rate = asc.sample_rate;
+                t.channels = asc.channel_config;
+            }
+        }
+        t.metadata["timecode_scale_ns"] = std::to_string(timecodeScaleNs_);
+        if (ti.default_duration_ns > 0) {
+            t.metadata["default_duration_ns"] = std::to_string(ti.default_duration_ns);
+        }
+        if (ti.encoding.frames && ti.encoding.compression != ContentCompression::kNone) {
+            // kPassthrough delivers blocks as stored, so tell the caller how they are encoded
+            static const char *const kNames[] = {"none", "zlib", "header_stripping", "unsupported"};
+            t.metadata["content_compression"] = kNames[static_cast<size_t>(ti.encoding.compression)];
+        }
+        t.codec_private = ti.codec_private;
+        ti.packetizer = CreatePacketizer(t);
+
+        // Batched frames may point at the parameter sets of the track being replaced
+        FlushFrames();
+        tracks_[ti.track_number] = std::move(ti);
+
+        auto listener = listener_.lock();
+        if (listener) {
+            listener->OnTrack(t);
+        }
+    }
+
+    // CodecPrivate is covered by the ContentEncoding (Scope bit 1); decode it before packetizers see it
+    void DecodeCodecPrivate(TrackInfo &ti)
+    {
+        if (ti.encoding.compression == ContentCompression::kHeaderStrip) {
+            ti.codec_private.insert(ti.codec_private.begin(), ti.encoding.header.begin(), ti.encoding.header.end());
+        } else if (ti.encoding.compression == ContentCompression::kZlib && !ti.codec_private.empty()) {
+            size_t n = 0;
+            if (inflater_.Inflate(ti.codec_private.data(), ti.codec_private.size(), inflateBuf_, n)) {
+                ti.codec_private.assign(inflateBuf_.begin(), inflateBuf_.begin() + n);
+            } else {
+                LMMKV_LOGW("Track %llu: cannot inflate CodecPrivate", (unsigned long long)ti.track_number);
+            }
+        }
+    }
+
+    // User factories registered for a codec ID prefix, newest first, then the built-in ones
+    std::shared_ptr<IMkvPacketizer> CreatePacketizer(const MkvTrackInfo &track)
+    {
+        for (auto it = packetizers_.rbegin(); it != packetizers_.rend(); ++it) {
+            if (StartsWith(track.codec_id, it->first)) {
+                return it->second(track);
+            }
+        }
+        return CreateDefaultPacketizer(track);
+    }
+
+    // BlockGroup: a Block plus BlockDuration and ReferenceBlock. A Block has no keyframe
+    // flag; it is a keyframe when nothing is referenced.
+    void ParseBlockGroup(BufferCursor &cur, uint64_t size)
+    {
+        size_t end = cur.Tell() + static_cast<size_t>(size);
+        const uint8_t *block = nullptr;
+        size_t block_size = 0;
+        int64_t duration_ns = -1;
+        blockRefs_.clear();
+        EbmlElementHeader sub{};
+        while (cur.Tell() < end) {
+            if (!NextElement(cur, sub) || sub.size > end - cur.Tell())
+                break;
+            switch (ElementOf(sub.id)) {
+                case MkvElement::kBlock:
+                    block = cur.Current();
+                    block_size = static_cast<size_t>(sub.size);
+                    SkipBytes(cur, block_size);
+                    break;
+                case MkvElement::kBlockDuration:
+                    duration_ns = static_cast<int64_t>(ReadUnsignedBE(cur, static_cast<size_t>(sub.size)) *
+                                                       timecodeScaleNs_);
+                    break;
+                case MkvElement::kReferenceBlock:
+                    blockRefs_.push_back(ReadSignedBE(cur, static_cast<size_t>(sub.size)) *
+                                         static_cast<int64_t>(timecodeScaleNs_));
+                    break;
+                default:
+                    SkipBytes(cur, static_cast<size_t>(sub.size));
+                    break;
+            }
+        }
+        if (block == nullptr || (keyframesOnly_ && !blockRefs_.empty())) {
+            return;
+        }
+        BufferCursor block_cur(block, block_size);
+        ParseBlock(block_cur, block_size, blockRefs_.empty(), duration_ns);
+    }
+
+    void ParseSimpleBlock(BufferCursor &cur, uint64_t size)
+    {
+        blockRefs_.clear();
+        ParseBlock(cur, size, false, -1);
+    }
+
+    // Block header and lacing shared by SimpleBlock and Block. group_keyframe replaces
+    // the SimpleBlock keyframe flag inside a BlockGroup; duration_ns is BlockDuration or -1.
+    void ParseBlock(BufferCursor &cur, uint64_t size, bool group_keyframe, int64_t duration_ns)
+    {
+        size_t block_end = cur.Tell() + static_cast<size_t>(size);
+        // TrackNumber (vint, strip leading 1-bits like size)
+        uint64_t track_number = 0;
+        size_t tn_len = ReadVintSize(cur, track_number);
+        if (tn_len == 0) {
+            SkipBytes(cur, static_cast<size_t>(size));
+            return;
+        }
+        // Timecode (signed 16-bit, big endian) and flags
+        const uint8_t *fixed = cur.Take(3);
+        if (fixed == nullptr)
+            return;
+        int16_t rel_tc = static_cast<int16_t>((fixed[0] << 8) | fixed[1]);
+        uint8_t flags = fixed[2];
+        bool keyframe = group_keyframe || (flags & 0x80) != 0;
+        uint8_t lacing = (flags & 0x06) >> 1; // 0=no lacing, 1=xiph,2=fixed,3=ebml
+
+        // Unknown and filtered-out tracks are dropped before the payload is touched
+        auto it = tracks_.find(track_number);
+        if (it == tracks_.end() || !WantBlock(track_number, keyframe)) {
+            return;
+        }
+        if (!DelaceBlock(cur, block_end, lacing)) {
+            LMMKV_LOGW("Malformed lacing in block for track %llu", (unsigned long long)track_number);
+            return;
+        }
+        blockTrack_ = &it->second;
+        blockTimestampNs_ = currentClusterTimecodeNs_ + static_cast<int64_t>(rel_tc) * timecodeScaleNs_;
+        blockKeyframe_ = keyframe;
+        blockDurationNs_ = duration_ns;
+        if (blockDurationNs_ < 0) {
+            blockDurationNs_ = static_cast<int64_t>(it->second.default_duration_ns * laces_.size());
+        }
+        blockNext_ = 0;
+        blockCount_ = outputMode_ == MkvOutputMode::kPassthrough ? 1 : laces_.size();
+        if (pullMode_) {
+            // ReadPacket() takes the frames one at a time
+            return;
+        }
+        if (batchSize_ > 0) {
+            while (blockNext_ < blockCount_) {
+                AddToBatch(blockNext_++);
+            }
+            return;
+        }
+        auto listener = listener_.lock();
+        while (listener && blockNext_ < blockCount_) {
+            if (BuildFrame(blockNext_++, frame_)) {
+                listener->OnFrame(frame_);
+            }
+        }
+        blockNext_ = blockCount_;
+    }
+
+    // Build one frame into the next batch entry. kConverted payloads are appended to
+    // batchBytes_ and each entry has its own packetizer header slot, so earlier entries
+    // stay intact until the batch is flushed.
+    void AddToBatch(size_t index)
+    {
+        MkvFrame &f = batch_[batchCount_];
+        if (!BuildFrame(index, f, batchHeaders_.data() + batchCount_ * IMkvPacketizer::kMaxHeaderSize, batchBytes_)) {
+            return;
+        }
+        // Sliced zlib frames point into inflateBuf_, which the next frame overwrites
+        const ContentEncodingInfo &enc = blockTrack_->encoding;
+        bool inflated = outputMode_ == MkvOutputMode::kSliced && enc.frames &&
+                        enc.compression == ContentCompression::kZlib;
+        if (++batchCount_ == batchSize_ || inflated) {
+            FlushFrames();
+        }
+    }
+
+    void FlushFrames()
+    {
+        if (batchCount_ == 0) {
+            return;
+        }
+        if (!batchBytes_.empty()) {
+            // kConverted payloads lie back to back; point them at the final buffer
+            size_t offset = 0;
+            for (size_t i = 0; i < batchCount_; ++i) {
+                batch_[i].data = batchBytes_.data() + offset;
+                offset += batch_[i].size;
+            }
+        }
+        auto listener = listener_.lock();
+        if (listener) {
+            listener->OnFrames(batch_.data(), batchCount_);
+        }
+        batchCount_ = 0;
+        batchBytes_.clear();
+    }
+
+    bool HasPendingFrames() const { return blockNext_ < blockCount_; }
+
+    bool WantBlock(uint64_t track_number, bool keyframe) const
+    {
+        return (keyframe || !keyframesOnly_) && (trackFilter_.empty() || trackFilter_.count(track_number) != 0);
+    }
+
+    // Decide on a SimpleBlock from its first bytes (track number and flags). Unwanted
+    // blocks are skipped without reading the rest; consumed bytes are already behind us.
+    void PeekBlock(const uint8_t *p, size_t n, size_t consumed)
+    {
+        uint64_t track_number = 0;
+        size_t tn_len = DecodeVint(p, n, false, track_number);
+        state_ = ParseState::kPayload;
+        if (tn_len == 0 || tn_len + 3 > n) {
+            // Malformed; ParseSimpleBlock rejects it
+            return;
+        }
+        bool keyframe = (p[tn_len + 2] & 0x80) != 0;
+        if (tracks_.count(track_number) != 0 && WantBlock(track_number, keyframe)) {
+            return;
+        }
+        carry_.clear();
+        skipRemaining_ = pendingHdr_.size - consumed;
+        state_ = skipRemaining_ > 0 ? ParseState::kSkip : ParseState::kHeader;
+    }
+
+    // Fill f with output unit index of the current block: the whole block in kPassthrough,
+    // otherwise one lace. Returns false when the lace yields no frame (no packetizer, empty).
+    bool BuildFrame(size_t index, MkvFrame &f)
+    {
+        frameBuf_.clear();
+        return BuildFrame(index, f, frameHeader_, frameBuf_);
+    }
+
+    // As above, with the packetizer header written to header and kConverted output appended to out
+    bool BuildFrame(size_t index, MkvFrame &f, uint8_t *header, std::pmr::vector<uint8_t> &out)
+    {
+        const TrackInfo &ti = *blockTrack_;
+        f.track_number = ti.track_number;
+        f.keyframe = blockKeyframe_;
+        f.references_ns.assign(blockRefs_.begin(), blockRefs_.end());
+        f.slices.clear();
+
+        if (outputMode_ == MkvOutputMode::kPassthrough) {
+            // Raw block payload straight from the input; laces exposed as slices
+            f.timecode_ns = static_cast<int64_t>(blockTimestampNs_);
+            f.duration_ns = blockDurationNs_;
+            f.data = laces_.front().first;
+            f.size = static_cast<size_t>(laces_.back().first + laces_.back().second - laces_.front().first);
+            if (laces_.size() > 1) {
+                f.slices.assign(laces_.begin(), laces_.end());
+            }
+            return true;
+        }
+
+        if (!ti.packetizer) {
+            return false;
+        }
+        MkvPayload payload;
+        payload.data = laces_[index];
+        if (ti.encoding.frames && !DecodePayload(ti, payload)) {
+            return false;
+        }
+        frameSlices_.clear();
+        ti.packetizer->Packetize(payload, blockKeyframe_, header, frameSlices_);
+        size_t frame_size = SlicesSize(frameSlices_);
+        if (frame_size == 0) {
+            return false;
+        }
+        // Laced frames after the first are spaced by DefaultDuration when it is known
+        uint64_t ts_emit = blockTimestampNs_;
+        if (index > 0 && ti.default_duration_ns > 0) {
+            ts_emit = blockTimestampNs_ + static_cast<uint64_t>(index) * ti.default_duration_ns;
+        }
+        f.timecode_ns = static_cast<int64_t>(ts_emit);
+        f.duration_ns = blockDurationNs_ / static_cast<int64_t>(laces_.size());
+        if (outputMode_ == MkvOutputMode::kSliced) {
+            f.data = nullptr;
+            f.size = frame_size;
+            f.slices.assign(frameSlices_.begin(), frameSlices_.end());
+        } else {
+            AppendSlices(frameSlices_, out);
+            scratchPeak_ = std::max(scratchPeak_, out.size());
+            f.data = out.data() + out.size() - frame_size;
+            f.size = frame_size;
+        }
+        return true;
+    }
+
+    // Undo the track's ContentEncoding for one frame. A stripped header becomes the shared
+    // prefix (no copy); zlib frames are inflated into inflateBuf_, valid until the next frame.
+    bool DecodePayload(const TrackInfo &ti, MkvPayload &payload)
+    {
+        switch (ti.encoding.compression) {
+            case ContentCompression::kHeaderStrip:
+                payload.prefix = MkvSlice(ti.encoding.header.data(), ti.encoding.header.size());
+                return true;
+            case ContentCompression::kZlib: {
+                size_t n = 0;
+                if (!inflater_.Inflate(payload.data.first, payload.data.second, inflateBuf_, n)) {
+                    LMMKV_LOGW("Track %llu: dropping frame that does not inflate", (unsigned long long)ti.track_number);
+                    return false;
+                }
+                payload.data = MkvSlice(inflateBuf_.data(), n);
+                return true;
+            }
+            default:
+                return true;
+        }
+    }
+
+    // Split a block payload into laces_ without copying; entries point into the cursor buffer.
+    bool DelaceBlock(BufferCursor &cur, size_t block_end, uint8_t lacing)
+    {
+        laces_.clear();
+        if (cur.Tell() > block_end) {
+            return false;
+        }
+        if (lacing == 0) {
+            laces_.emplace_back(cur.Current(), block_end - cur.Tell());
+            return true;
+        }
+
+        const uint8_t *count = cur.Take(1);
+        if (count == nullptr)
+            return false;
+        size_t num_frames = static_cast<size_t>(*count) + 1;
+        laceSizes_.clear();
+        if (lacing == 1) {
+            // Xiph lacing: sizes encoded as series of bytes summing to size, last frame implied
+            for (size_t fi = 0; fi + 1 < num_frames; ++fi) {
+                size_t sz = 0;
+                while (true) {
+                    const uint8_t *b = cur.Take(1);
+                    if (b == nullptr)
+                        return false;
+                    sz += *b;
+                    if (*b != 255)
+                        break;
+                }
+                laceSizes_.push_back(sz);
+            }
+        } else if (lacing == 3) {
+            // EBML lacing: first size as EBML vint, then deltas as signed vints
+            uint64_t first_size = 0;
+            if (ReadVintSize(cur, first_size) == 0)
+                return false;
+            laceSizes_.push_back(static_cast<size_t>(first_size));
+            for (size_t fi = 1; fi + 1 < num_frames; ++fi) {
+                uint64_t u = 0;
+                size_t w = ReadVintSize(cur, u);
+                if (w == 0)
+                    return false;
+                // Mapping described in Matroska notes: signed = unsigned - (2^((7*w)-1) - 1)
+                int64_t bias = static_cast<int64_t>((1ULL << (7 * w - 1)) - 1ULL);
+                int64_t sz = static_cast<int64_t>(laceSizes_.back()) + static_cast<int64_t>(u) - bias;
+                if (sz < 0)
+                    return false;
+                laceSizes_.push_back(static_cast<size_t>(sz));
+            }
+        }
+        if (cur.Tell() > block_end) {
+            return false;
+        }
+        size_t remaining = block_end - cur.Tell();
+        if (lacing == 2) {
+            // Fixed-size lacing: equally sized frames
+            size_t per = remaining / num_frames;
+            laceSizes_.assign(num_frames, per);
+        } else {
+            // Last frame size is remainder
+            size_t consumed = 0;
+            for (size_t sz : laceSizes_)
+                consumed += sz;
+            if (consumed > remaining)
+                return false;
+            laceSizes_.push_back(remaining - consumed);
+        }
+
+        const uint8_t *p = cur.Current();
+        for (size_t sz : laceSizes_) {
+            laces_.emplace_back(p, sz);
+            p += sz;
+        }
+        return true;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    bool running_;
+    uint64_t timecodeScaleNs_;
+    uint64_t currentClusterTimecodeNs_;
+
+    // Streaming state carried across Consume() calls
+    ParseState state_;
+    uint64_t streamPos_;
+    uint64_t skipRemaining_;
+    std::vector<ContainerLevel> levels_;
+    EbmlElementHeader pendingHdr_{};
+    uint8_t headerBuf_[kEbmlMaxHeaderLength]{};
+    size_t headerLen_;
+    std::pmr::vector<uint8_t> carry_; // payload split across calls; bounded by the largest element
+    std::pmr::vector<uint8_t> resyncBuf_; // Cluster candidate cut off at the end of the previous call
+    uint64_t resyncStart_ = 0;            // first corrupt byte of the current resync
+    std::pmr::vector<uint8_t> replay_;    // held bytes from the Cluster found by Resync() on
+    size_t replayPos_ = 0;                // replay_ bytes parsed; input continues after the rest
+
+    // Per-frame scratch, reused across frames so steady-state demuxing does not allocate
+    MkvOutputMode outputMode_;
+    SliceList laces_; // de-laced frames of the current block
+    std::pmr::vector<size_t> laceSizes_;
+    SliceList frameSlices_;              // output slices of the frame being emitted
+    std::pmr::vector<uint8_t> frameBuf_; // contiguous output in kConverted mode
+    size_t scratchPeak_;                 // largest scratch use in the current cluster
+    MkvFrame frame_;
+    uint8_t frameHeader_[IMkvPacketizer::kMaxHeaderSize]{};
+    ZlibInflater inflater_;               // zlib-compressed tracks (ContentEncoding)
+    std::pmr::vector<uint8_t> inflateBuf_; // inflated frame; only grows
+
+    // Batched delivery (SetFrameBatchSize); entries are reused so their slice storage is kept
+    size_t batchSize_ = 0;
+    std::vector<MkvFrame> batch_;
+    size_t batchCount_ = 0;
+    std::pmr::vector<uint8_t> batchBytes_; // kConverted payloads of the batch
+    std::pmr::vector<uint8_t> batchHeaders_; // packetizer header slot per entry
+
+    // Block whose frames are being emitted; in pull mode the rest wait for ReadPacket()
+    const TrackInfo *blockTrack_ = nullptr;
+    uint64_t blockTimestampNs_ = 0;
+    bool blockKeyframe_ = false;
+    int64_t blockDurationNs_ = 0;
+    std::vector<int64_t> blockRefs_; // ReferenceBlock offsets of the current BlockGroup
+    size_t blockNext_ = 0;
+    size_t blockCount_ = 0;
+
+    // Pull mode input window over source_
+    bool pullMode_ = false;
+    std::pmr::vector<uint8_t> readBuf_;
+    size_t readPos_ = 0;
+    size_t readLen_ = 0;
+    uint64_t readOffset_ = 0; // absolute offset of readBuf_[readPos_]
+
+    // Seek support
+    std::shared_ptr<IByteSource> source_;
+    size_t lastHeaderLen_ = 0;
+    bool segmentSeen_ = false;
+    uint64_t segmentDataPos_ = 0;             // absolute offset of the Segment payload
+    uint64_t segmentEnd_ = kEbmlUnknownSize;  // absolute end, or unknown for live streams
+    uint64_t clusterStart_ = 0;               // absolute offset of the current Cluster header
+    std::vector<SeekEntry> seekEntries_;
+    CueIndex cues_;
+    bool cuesLoaded_ = false;
+    CueIndex clustersSeen_; // Cluster times met while streaming, used when there are no Cues
+    uint64_t firstClusterPos_ = 0;
+
+    double durationTicks_ = 0.0; // Info Duration in TimecodeScale units
+    std::map<std::string, std::string> tags_;
+
+    std::unordered_map<uint64_t, TrackInfo> tracks_;
+    std::unordered_set<uint64_t> trackFilter_;
+    bool keyframesOnly_ = false;
+    std::vector<std::pair<std::string, MkvPacketizerFactory>> packetizers_;
+    std::weak_ptr<IMkvDemuxListener> listener_;
 };
 
-MkvDemuxer::MkvDemuxer() : impl_(new Impl) {}
+MkvDemuxer::MkvDemuxer() : impl_(new Impl(std::pmr::get_default_resource())) {}
+MkvDemuxer::MkvDemuxer(std::pmr::memory_resource *resource)
+    : impl_(new Impl(resource ? resource : std::pmr::get_default_resource()))
+{
+}
 MkvDemuxer::~MkvDemuxer() = default;
 
+void MkvDemuxer::SetFrameBatchSize(size_t frames)
+{
+    impl_->SetFrameBatchSize(frames);
+}
+
+void MkvDemuxer::RegisterPacketizer(const std::string &codec_id_prefix, MkvPacketizerFactory factory)
+{
+    impl_->RegisterPacketizer(codec_id_prefix, std::move(factory));
+}
+
+void MkvDemuxer::SetKeyframesOnly(bool enable)
+{
+    impl_->SetKeyframesOnly(enable);
+}
+
 void MkvDemuxer::SetTrackFilter(const std::vector<uint64_t> &tracks)
 {
     impl_->SetTrackFilter(tracks);
 }
 
+void MkvDemuxer::SetOutputMode(MkvOutputMode mode)
+{
+    impl_->SetOutputMode(mode);
+}
+
 bool MkvDemuxer::Start()
 {
     return impl_->Start();
@@ -883,6 +2005,36 @@ size_t MkvDemuxer::Consume(const uint8_t *data, size_t size)
     return impl_->ParseData(data, size);
 }
 
+void MkvDemuxer::SetByteSource(const std::shared_ptr<IByteSource> &source)
+{
+    impl_->SetByteSource(source);
+}
+
+int64_t MkvDemuxer::Open(const std::shared_ptr<IByteSource> &source)
+{
+    return impl_->Open(source);
+}
+
+int64_t MkvDemuxer::Seek(int64_t target_ns)
+{
+    return impl_->Seek(target_ns);
+}
+
+bool MkvDemuxer::SeekToOffset(uint64_t offset)
+{
+    return impl_->SeekToOffset(offset);
+}
+
+int MkvDemuxer::ReadPacket(MkvPacket &packet)
+{
+    return impl_->ReadPacket(packet);
+}
+
+bool MkvDemuxer::DemuxParallel(const std::shared_ptr<IByteSource> &source, size_t threads)
+{
+    return impl_->DemuxParallel(source, threads);
+}
+
 void MkvDemuxer::SetListener(const std::shared_ptr<IMkvDemuxListener> &listener)
 {
     impl_->SetListener(listener);
@@ -0,0 +1,546 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "lmmkv/mkv_file_source.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef LMMKV_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#include "internal_logger.h"
+
+namespace lmshao::lmmkv {
+
+#ifndef _WIN32
+
+// Open path read-only and return its size; -1 on failure
+static int OpenFile(const std::string &path, uint64_t &size)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LMMKV_LOGE("Cannot open %s: %s", path.c_str(), std::strerror(errno));
+        return -1;
+    }
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) {
+        LMMKV_LOGE("Cannot stat %s: %s", path.c_str(), std::strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+    size = static_cast<uint64_t>(st.st_size);
+    return fd;
+}
+
+// pread until size bytes, end of file or an error; returns bytes read
+static size_t PreadFull(int fd, uint64_t offset, uint8_t *dst, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t r = ::pread(fd, dst + done, size - done, static_cast<off_t>(offset + done));
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            break;
+        }
+        done += static_cast<size_t>(r);
+    }
+    return done;
+}
+
+static void FadviseWillNeed(int fd, uint64_t offset, size_t size)
+{
+#ifdef POSIX_FADV_WILLNEED
+    ::posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(size), POSIX_FADV_WILLNEED);
+#endif
+}
+
+// MmapByteSource
+
+std::shared_ptr<MmapByteSource> MmapByteSource::Open(const std::string &path, const MmapOptions &options)
+{
+    uint64_t size = 0;
+    int fd = OpenFile(path, size);
+    if (fd < 0) {
+        return nullptr;
+    }
+    if (size == 0) {
+        ::close(fd);
+        return std::shared_ptr<MmapByteSource>(new MmapByteSource(nullptr, 0));
+    }
+    void *addr = ::mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps the file referenced
+    if (addr == MAP_FAILED) {
+        LMMKV_LOGE("Cannot map %s: %s", path.c_str(), std::strerror(errno));
+        return nullptr;
+    }
+    size_t len = static_cast<size_t>(size);
+    if (options.sequential) {
+        ::madvise(addr, len, MADV_SEQUENTIAL);
+    }
+    if (options.will_need) {
+        ::madvise(addr, len, MADV_WILLNEED);
+    }
+#ifdef MADV_HUGEPAGE
+    if (options.huge_pages && ::madvise(addr, len, MADV_HUGEPAGE) != 0) {
+        LMMKV_LOGW("MADV_HUGEPAGE not supported for %s: %s", path.c_str(), std::strerror(errno));
+    }
+#endif
+    return std::shared_ptr<MmapByteSource>(new MmapByteSource(static_cast<const uint8_t *>(addr), len));
+}
+
+MmapByteSource::~MmapByteSource()
+{
+    if (data_) {
+        ::munmap(const_cast<uint8_t *>(data_), size_);
+    }
+}
+
+size_t MmapByteSource::ReadAt(uint64_t offset, uint8_t *dst, size_t size)
+{
+    if (offset >= size_)
+        return 0;
+    size_t n = size < size_ - offset ? size : static_cast<size_t>(size_ - offset);
+    std::memcpy(dst, data_ + offset, n);
+    return n;
+}
+
+void MmapByteSource::Prefetch(uint64_t offset, size_t size)
+{
+    if (offset >= size_) {
+        return;
+    }
+    // madvise wants a page-aligned start
+    static const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t begin = static_cast<size_t>(offset) & ~(page - 1);
+    size_t end = std::min(size_, static_cast<size_t>(offset) + size);
+    ::madvise(const_cast<uint8_t *>(data_) + begin, end - begin, MADV_WILLNEED);
+}
+
+// PreadByteSource
+
+std::shared_ptr<PreadByteSource> PreadByteSource::Open(const std::string &path, size_t block_size)
+{
+    uint64_t size = 0;
+    int fd = OpenFile(path, size);
+    if (fd < 0) {
+        return nullptr;
+    }
+    return std::shared_ptr<PreadByteSource>(new PreadByteSource(fd, size, std::max<size_t>(block_size, 4096)));
+}
+
+PreadByteSource::PreadByteSource(int fd, uint64_t size, size_t block_size) : fd_(fd), size_(size), block_(block_size)
+{
+}
+
+PreadByteSource::~PreadByteSource()
+{
+    ::close(fd_);
+}
+
+size_t PreadByteSource::ReadAt(uint64_t offset, uint8_t *dst, size_t size)
+{
+    if (offset >= size_)
+        return 0;
+    size = static_cast<size_t>(std::min<uint64_t>(size, size_ - offset));
+    if (size >= block_.size()) {
+        return PreadFull(fd_, offset, dst, size);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = offset + done;
+        if (pos < blockOffset_ || pos >= blockOffset_ + blockLen_) {
+            blockOffset_ = pos - pos % block_.size();
+            blockLen_ = PreadFull(fd_, blockOffset_, block_.data(), block_.size());
+            if (pos >= blockOffset_ + blockLen_) {
+                break;
+            }
+        }
+        size_t in_block = static_cast<size_t>(pos - blockOffset_);
+        size_t n = std::min(size - done, blockLen_ - in_block);
+        std::memcpy(dst + done, block_.data() + in_block, n);
+        done += n;
+    }
+    return done;
+}
+
+void PreadByteSource::Prefetch(uint64_t offset, size_t size)
+{
+    FadviseWillNeed(fd_, offset, size);
+}
+
+#else // _WIN32
+
+std::shared_ptr<MmapByteSource> MmapByteSource::Open(const std::string &path, const MmapOptions &options)
+{
+    (void)path;
+    (void)options;
+    LMMKV_LOGE("MmapByteSource is not available on this platform");
+    return nullptr;
+}
+
+MmapByteSource::~MmapByteSource() = default;
+
+size_t MmapByteSource::ReadAt(uint64_t offset, uint8_t *dst, size_t size)
+{
+    (void)offset;
+    (void)dst;
+    (void)size;
+    return 0;
+}
+
+void MmapByteSource::Prefetch(uint64_t offset, size_t size)
+{
+    (void)offset;
+    (void)size;
+}
+
+std::shared_ptr<PreadByteSource> PreadByteSource::Open(const std::string &path, size_t block_size)
+{
+    (void)path;
+    (void)block_size;
+    LMMKV_LOGE("PreadByteSource is not available on this platform");
+    return nullptr;
+}
+
+PreadByteSource::PreadByteSource(int fd, uint64_t size, size_t block_size) : fd_(fd), size_(size)
+{
+    (void)block_size;
+}
+
+PreadByteSource::~PreadByteSource() = default;
+
+size_t PreadByteSource::ReadAt(uint64_t offset, uint8_t *dst, size_t size)
+{
+    (void)offset;
+    (void)dst;
+    (void)size;
+    return 0;
+}
+
+void PreadByteSource::Prefetch(uint64_t offset, size_t size)
+{
+    (void)offset;
+    (void)size;
+}
+
+#endif // _WIN32
+
+// IoUringByteSource
+
+#ifdef LMMKV_HAVE_IO_URING
+
+// user_data of FADVISE requests, whose completions are only reaped
+static constexpr uint64_t kPrefetchTag = ~0ULL;
+
+// Submission and completion rings set up with the raw syscalls, so there is no liburing dependency
+struct IoUringByteSource::Ring {
+    int fd = -1;
+    void *sqPtr = MAP_FAILED;
+    size_t sqLen = 0;
+    void *cqPtr = MAP_FAILED;
+    size_t cqLen = 0;
+    io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+    size_t sqesLen = 0;
+
+    unsigned *sqHead = nullptr;
+    unsigned *sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned *sqArray = nullptr;
+    unsigned sqEntries = 0;
+    unsigned *cqHead = nullptr;
+    unsigned *cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe *cqes = nullptr;
+    unsigned unsubmitted = 0; // pushed but not yet taken by the kernel
+    unsigned prefetching = 0; // FADVISE requests not yet completed
+    bool broken = false;      // io_uring_enter failed; reads fall back to pread
+
+    ~Ring()
+    {
+        if (sqes != MAP_FAILED)
+            ::munmap(sqes, sqesLen);
+        if (cqPtr != MAP_FAILED && cqPtr != sqPtr)
+            ::munmap(cqPtr, cqLen);
+        if (sqPtr != MAP_FAILED)
+            ::munmap(sqPtr, sqLen);
+        if (fd >= 0)
+            ::close(fd);
+    }
+
+    bool Setup(unsigned depth)
+    {
+        io_uring_params p{};
+        fd = static_cast<int>(::syscall(__NR_io_uring_setup, depth, &p));
+        if (fd < 0) {
+            return false;
+        }
+        sqLen = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cqLen = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sqLen = cqLen = std::max(sqLen, cqLen);
+        }
+        sqPtr = ::mmap(nullptr, sqLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqPtr == MAP_FAILED) {
+            return false;
+        }
+        cqPtr = single ? sqPtr
+                       : ::mmap(nullptr, cqLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                IORING_OFF_CQ_RING);
+        if (cqPtr == MAP_FAILED) {
+            return false;
+        }
+        sqesLen = p.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe *>(
+            ::mmap(nullptr, sqesLen, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+
+        auto *sq = static_cast<uint8_t *>(sqPtr);
+        sqHead = reinterpret_cast<unsigned *>(sq + p.sq_off.head);
+        sqTail = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+        sqEntries = p.sq_entries;
+        auto *cq = static_cast<uint8_t *>(cqPtr);
+        cqHead = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+        cqTail = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+        return true;
+    }
+
+    // Queue one request; the kernel sees it on the next Enter(). flags is rw_flags or
+    // fadvise_advice. False if the submission queue has no free slot.
+    bool Push(uint8_t opcode, int file, uint64_t offset, void *addr, uint32_t len, uint32_t flags, uint64_t user_data)
+    {
+        unsigned tail = *sqTail;
+        if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+            return false;
+        }
+        unsigned index = tail & sqMask;
+        io_uring_sqe &sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = file;
+        sqe.off = offset;
+        sqe.addr = reinterpret_cast<uint64_t>(addr);
+        sqe.len = len;
+        sqe.rw_flags = flags;
+        sqe.user_data = user_data;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        ++unsubmitted;
+        return true;
+    }
+
+    // Submit what is queued and wait for min_complete completions. EAGAIN/EBUSY mean
+    // the completion queue is full; the caller reaps and calls again.
+    bool Enter(unsigned min_complete)
+    {
+        unsigned flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        int r;
+        do {
+            r = static_cast<int>(::syscall(__NR_io_uring_enter, fd, unsubmitted, min_complete, flags, nullptr, 0));
+        } while (r < 0 && errno == EINTR);
+        if (r >= 0) {
+            unsubmitted -= std::min(unsubmitted, static_cast<unsigned>(r));
+            return true;
+        }
+        if (errno == EAGAIN || errno == EBUSY) {
+            return true;
+        }
+        LMMKV_LOGE("io_uring_enter failed: %s", std::strerror(errno));
+        broken = true;
+        return false;
+    }
+
+    // Visit and release every available completion; FADVISE completions are only counted
+    template <typename F>
+    void Reap(F &&on_cqe)
+    {
+        unsigned head = *cqHead;
+        while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe &cqe = cqes[head & cqMask];
+            if (cqe.user_data == kPrefetchTag) {
+                prefetching -= std::min(prefetching, 1u);
+            } else {
+                on_cqe(cqe.user_data, cqe.res);
+            }
+            ++head;
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+};
+
+std::shared_ptr<IoUringByteSource> IoUringByteSource::Open(const std::string &path, unsigned queue_depth,
+                                                           size_t block_size)
+{
+    uint64_t size = 0;
+    int fd = OpenFile(path, size);
+    if (fd < 0) {
+        return nullptr;
+    }
+    std::unique_ptr<Ring> ring(new Ring);
+    if (!ring->Setup(std::max(queue_depth, 1u))) {
+        LMMKV_LOGE("io_uring setup failed: %s", std::strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+    return std::shared_ptr<IoUringByteSource>(
+        new IoUringByteSource(fd, size, std::max<size_t>(block_size, 4096), std::move(ring)));
+}
+
+IoUringByteSource::IoUringByteSource(int fd, uint64_t size, size_t block_size, std::unique_ptr<Ring> ring)
+    : fd_(fd), size_(size), blockSize_(block_size), ring_(std::move(ring))
+{
+}
+
+IoUringByteSource::~IoUringByteSource()
+{
+    ring_.reset();
+    ::close(fd_);
+}
+
+size_t IoUringByteSource::ReadAt(uint64_t offset, uint8_t *dst, size_t size)
+{
+    if (offset >= size_)
+        return 0;
+    size = static_cast<size_t>(std::min<uint64_t>(size, size_ - offset));
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring &ring = *ring_;
+    if (ring.broken) {
+        return PreadFull(fd_, offset, dst, size);
+    }
+    size_t blocks = (size + blockSize_ - 1) / blockSize_;
+    size_t next = 0; // next block to queue
+    size_t inflight = 0;
+    size_t contiguous = size; // bytes from the start known to be read
+    auto complete = [&](uint64_t block, int res) {
+        --inflight;
+        size_t begin = static_cast<size_t>(block) * blockSize_;
+        size_t len = std::min(blockSize_, size - begin);
+        size_t got = res > 0 ? static_cast<size_t>(res) : 0;
+        if (got < len) {
+            // Short or failed read: finish the block synchronously
+            got += PreadFull(fd_, offset + begin + got, dst + begin + got, len - got);
+            if (got < len) {
+                contiguous = std::min(contiguous, begin + got);
+            }
+        }
+    };
+    while (next < blocks || inflight > 0) {
+        // Queued prefetches hold slots too, and every request must fit in the completion queue
+        while (next < blocks && inflight + ring.prefetching < ring.sqEntries) {
+            size_t begin = next * blockSize_;
+            uint32_t len = static_cast<uint32_t>(std::min(blockSize_, size - begin));
+            if (!ring.Push(IORING_OP_READ, fd_, offset + begin, dst + begin, len, 0, next)) {
+                break;
+            }
+            ++next;
+            ++inflight;
+        }
+        if (!ring.Enter(1)) {
+            // The reads pushed last never reached the kernel. Those that did still write
+            // into dst, so wait for them (without io_uring_enter), then pread the rest.
+            size_t queued = std::min<size_t>(ring.unsubmitted, inflight);
+            while (inflight > queued) {
+                ring.Reap(complete);
+                if (inflight > queued) {
+                    ::sched_yield();
+                }
+            }
+            size_t begin = (next - queued) * blockSize_;
+            size_t got = PreadFull(fd_, offset + begin, dst + begin, size - begin);
+            if (got < size - begin) {
+                contiguous = std::min(contiguous, begin + got);
+            }
+            return contiguous;
+        }
+        ring.Reap(complete);
+    }
+    return contiguous;
+}
+
+void IoUringByteSource::Prefetch(uint64_t offset, size_t size)
+{
+    if (offset >= size_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    Ring &ring = *ring_;
+    if (ring.broken) {
+        return;
+    }
+    ring.Reap([](uint64_t, int) {});
+    uint32_t len = static_cast<uint32_t>(std::min<uint64_t>(size, UINT32_MAX));
+    // A hint only: dropped when the queue is full
+    if (ring.prefetching >= ring.sqEntries ||
+        !ring.Push(IORING_OP_FADVISE, fd_, offset, nullptr, len, POSIX_FADV_WILLNEED, kPrefetchTag)) {
+        return;
+    }
+    ++ring.prefetching;
+    ring.Enter(0);
+}
+
+#else
+
+struct IoUringByteSource::Ring {};
+
+std::shared_ptr<IoUringByteSource> IoUringByteSource::Open(const std::string &path, unsigned queue_depth,
+                                                           size_t block_size)
+{
+    (void)path;
+    (void)queue_depth;
+    (void)block_size;
+    LMMKV_LOGW("io_uring support not built in");
+    return nullptr;
+}
+
+IoUringByteSource::IoUringByteSource(int fd, uint64_t size, size_t block_size, std::unique_ptr<Ring> ring)
+    : fd_(fd), size_(size), blockSize_(block_size), ring_(std::move(ring))
+{
+}
+
+IoUringByteSource::~IoUringByteSource() = default;
+
+size_t IoUringByteSource::ReadAt(uint64_t offset, uint8_t *dst, size_t size)
+{
+    (void)offset;
+    (void)dst;
+    (void)size;
+    return 0;
+}
+
+void IoUringByteSource::Prefetch(uint64_t offset, size_t size)
+{
+    (void)offset;
+    (void)size;
+}
+
+#endif // LMMKV_HAVE_IO_URING
+
+} // namespace lmshao::lmmkv
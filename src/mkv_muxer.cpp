@@ -8,21 +8,982 @@
 
 #include "lmmkv/mkv_muxer.h"
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "annexb.h"
+#include "ebml_writer.h"
+#include "internal_logger.h"
+#include "mkv_schema.h"
+
 namespace lmshao::lmmkv {
 
+// SimpleBlock ID (1) + size vint (8) + track vint (8) + relative timecode (2) + flags (1)
+static constexpr size_t kMaxBlockHeader = 20;
+
+// Void reserved for the SeekHead: header (5) + 3 Seeks of at most 21 bytes, with room to spare
+static constexpr size_t kSeekHeadReserve = 96;
+
+// Frames in one lace: the lace count is stored in one byte
+static constexpr size_t kMaxLaceFrames = 256;
+
+// SimpleBlock lacing flags
+static constexpr uint8_t kLacingXiph = 0x02;
+static constexpr uint8_t kLacingFixed = 0x04;
+static constexpr uint8_t kLacingEbml = 0x06;
+
+// Matroska TrackType values
+static constexpr uint64_t kTrackTypeVideo = 1;
+static constexpr uint64_t kTrackTypeAudio = 2;
+static constexpr uint64_t kTrackTypeSubtitle = 0x11;
+
+// TrackType from the codec ID prefix (V_, A_, S_), else from metadata "type"; 0 if unknown
+static uint64_t TrackTypeOf(const MkvTrackInfo &track)
+{
+    const std::string &codec = track.codec_id;
+    if (codec.compare(0, 2, "V_") == 0) {
+        return kTrackTypeVideo;
+    }
+    if (codec.compare(0, 2, "A_") == 0) {
+        return kTrackTypeAudio;
+    }
+    if (codec.compare(0, 2, "S_") == 0) {
+        return kTrackTypeSubtitle;
+    }
+    auto it = track.metadata.find("type");
+    if (it != track.metadata.end()) {
+        if (it->second == "video") {
+            return kTrackTypeVideo;
+        }
+        if (it->second == "audio") {
+            return kTrackTypeAudio;
+        }
+        if (it->second == "subtitle") {
+            return kTrackTypeSubtitle;
+        }
+    }
+    return 0;
+}
+
+// Width of a signed EBML lace size difference
+static size_t SignedVintLength(int64_t value)
+{
+    uint64_t magnitude = value < 0 ? static_cast<uint64_t>(-value) : static_cast<uint64_t>(value);
+    size_t width = 1;
+    while (width < kEbmlMaxSizeLength && magnitude > (1ULL << (7 * width - 1)) - 1) {
+        ++width;
+    }
+    return width;
+}
+
+// Lace header (frame count and sizes) for the cheapest of fixed, Xiph and EBML lacing;
+// returns the SimpleBlock lacing flags
+static uint8_t BuildLaceHeader(const std::vector<size_t> &sizes, std::vector<uint8_t> &out)
+{
+    size_t n = sizes.size();
+    bool fixed = true;
+    size_t xiph = 0;
+    size_t ebml = EbmlSizeLength(sizes[0]);
+    for (size_t i = 0; i + 1 < n; ++i) {
+        fixed = fixed && sizes[i] == sizes[i + 1];
+        xiph += sizes[i] / 255 + 1;
+        if (i > 0) {
+            ebml += SignedVintLength(static_cast<int64_t>(sizes[i]) - static_cast<int64_t>(sizes[i - 1]));
+        }
+    }
+
+    out.clear();
+    out.push_back(static_cast<uint8_t>(n - 1));
+    if (fixed) {
+        return kLacingFixed;
+    }
+    if (xiph <= ebml) {
+        for (size_t i = 0; i + 1 < n; ++i) {
+            out.insert(out.end(), sizes[i] / 255, 255);
+            out.push_back(static_cast<uint8_t>(sizes[i] % 255));
+        }
+        return kLacingXiph;
+    }
+    uint8_t field[kEbmlMaxSizeLength];
+    size_t width = EbmlSizeLength(sizes[0]);
+    PutEbmlSize(field, sizes[0], width);
+    out.insert(out.end(), field, field + width);
+    for (size_t i = 1; i + 1 < n; ++i) {
+        int64_t diff = static_cast<int64_t>(sizes[i]) - static_cast<int64_t>(sizes[i - 1]);
+        width = SignedVintLength(diff);
+        int64_t bias = static_cast<int64_t>((1ULL << (7 * width - 1)) - 1);
+        PutEbmlSize(field, static_cast<uint64_t>(diff + bias), width);
+        out.insert(out.end(), field, field + width);
+    }
+    return kLacingEbml;
+}
+
 struct MkvMuxer::Impl {
+    // Frames held back for the next laced block; payloads are copied since the
+    // caller's buffers are only valid during WriteFrame()
+    struct PendingLace {
+        std::vector<uint8_t> bytes;
+        std::vector<size_t> sizes;
+        int64_t first_ns = 0;
+        int64_t timecode = 0; // first frame, in timecode scale units
+    };
+
+    // Frame held by the interleaver; frame.data points into bytes once released
+    struct QueuedFrame {
+        MkvFrame frame;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct MuxTrack {
+        MkvTrackInfo info;
+        uint64_t type = 0;                // Matroska TrackType
+        uint64_t default_duration_ns = 0; // from metadata "default_duration_ns"
+        bool lacing = false;
+        bool flag_lacing = false; // FlagLacing left at 1: lacing, or metadata "flag_lacing" = "1"
+        PendingLace lace;
+
+        // Annex B input (metadata "stream_format" = "annexb"), stored length-prefixed
+        bool annexb = false;
+        bool hevc = false;
+        bool needs_config = false; // codec_private is built from the first parameter sets
+        std::vector<std::vector<uint8_t>> vps, sps, pps; // collected, then those in codec_private
+
+        std::deque<QueuedFrame> queue; // interleaver, oldest first
+    };
+
     MkvMuxerOptions opts_;
     IMkvMuxListener *listener_ = nullptr;
-    void *writer_ = nullptr; // examples/utilities may provide a concrete writer
+    IMkvWriter *writer_ = nullptr;
     MkvInfo info_;
-    std::vector<MkvTrackInfo> tracks_;
+    std::vector<MuxTrack> tracks_;
+
+    // Segment state
+    bool started_ = false;
+    bool headWritten_ = false; // deferred until every Annex B track has its parameter sets
+    bool dropWarned_ = false;
+    bool seekable_ = true;         // cleared by the first failed WriteAt(); sizes then stay unknown
+    uint64_t segmentSizePos_ = 0;  // offset of the Segment's 8-byte size field
+    uint64_t segmentDataPos_ = 0;  // first byte of the Segment payload
+    EbmlBuffer head_;              // EBML header, Info, Tracks, Cluster headers, Cues
+    std::vector<uint8_t> init_;    // EBML header to the end of Tracks, see InitSection()
+    bool hasVideo_ = false;
+    uint64_t seekHeadPos_ = 0;     // reserved SeekHead Void (0 = none)
+    uint64_t infoPos_ = 0;
+    uint64_t tracksPos_ = 0;
+    uint64_t durationPos_ = 0;     // Duration float payload
+    uint64_t cuesReservePos_ = 0;  // reserved Cues Void (0 = none)
+    int64_t endNs_ = 0;            // end of the latest frame, for Duration
+
+    // Interleaver (max_interleave_delta_ms > 0)
+    static constexpr size_t kMaxSpareBuffers = 16;
+    size_t queuedBytes_ = 0;
+    int64_t newestQueuedNs_ = 0;
+    bool interleaveStalled_ = false;            // forced writes of the current stall were reported
+    std::vector<std::vector<uint8_t>> spare_;   // payload buffers of released frames, reused
+
+    struct CuePoint {
+        uint64_t timecode;          // in timecode scale units
+        uint64_t track;
+        uint64_t cluster_position;  // relative to the Segment payload
+        uint64_t relative_position; // block offset inside the Cluster payload
+    };
+    std::vector<CuePoint> cues_;
+
+    // Cluster state
+    bool clusterOpen_ = false;
+    uint64_t clusterPos_ = 0;      // offset of the Cluster ID
+    uint64_t clusterSizePos_ = 0;  // offset of the Cluster's 8-byte size field
+    uint64_t clusterBytes_ = 0;    // Cluster payload written so far
+    int64_t clusterTimecode_ = 0;  // in timecode scale units
+    int64_t clusterStartNs_ = 0;
+    int64_t lastTimecodeNs_ = 0;
+    bool clusterCued_ = false;
 
-    explicit Impl(const MkvMuxerOptions &o) : opts_(o) {}
+    // SimpleBlock header, lace header and gather list, reused for every block
+    uint8_t blockHeader_[kMaxBlockHeader];
+    std::vector<uint8_t> laceHeader_;
+    std::vector<MkvSlice> iov_;
+
+    // Annex B conversion: NAL units of the current frame and their 4-byte length prefixes
+    std::vector<MkvSlice> nals_;
+    std::vector<uint8_t> nalLengths_;
+    std::vector<uint8_t> annexbCopy_; // frames given as several slices, made contiguous
+
+    explicit Impl(const MkvMuxerOptions &o) : opts_(o)
+    {
+        if (opts_.timecode_scale_ns == 0) {
+            LMMKV_LOGW("Timecode scale 0 is invalid; using 1 ms");
+            opts_.timecode_scale_ns = 1000000;
+        }
+        if (opts_.doc_type.empty()) {
+            opts_.doc_type = "matroska";
+        }
+        if (opts_.live) {
+            // Nothing is patched or held back in live output
+            opts_.write_cues = false;
+            opts_.write_seek_head = false;
+            opts_.enable_lacing = false;
+        }
+        iov_.reserve(16);
+        opts_.max_lace_frames = std::min<uint32_t>(std::max<uint32_t>(opts_.max_lace_frames, 1), kMaxLaceFrames);
+    }
 
     void ResetInternal()
     {
         tracks_.clear();
         info_ = MkvInfo{};
+        started_ = false;
+        headWritten_ = false;
+        seekable_ = true;
+        clusterOpen_ = false;
+        cues_.clear();
+        head_.Clear();
+        init_.clear();
+        ClearQueues();
+    }
+
+    void ClearQueues()
+    {
+        for (auto &t : tracks_) {
+            t.queue.clear();
+        }
+        queuedBytes_ = 0;
+        newestQueuedNs_ = 0;
+        interleaveStalled_ = false;
+    }
+
+    void Error(int code, const std::string &msg)
+    {
+        LMMKV_LOGE("%s", msg.c_str());
+        if (listener_) {
+            listener_->OnError(code, msg);
+        }
+    }
+
+    bool Emit(const MkvSlice *slices, size_t count)
+    {
+        if (!writer_->Write(slices, count)) {
+            Error(kMkvErrorWriteFailed, "Muxer output write failed");
+            return false;
+        }
+        return true;
+    }
+
+    bool EmitHead()
+    {
+        MkvSlice slice(head_.Bytes().data(), head_.Size());
+        bool ok = Emit(&slice, 1);
+        head_.Clear();
+        return ok;
+    }
+
+    // Overwrite bytes written earlier; false once the output turned out not to seek
+    bool PatchAt(uint64_t pos, const uint8_t *data, size_t size)
+    {
+        if (seekable_ && !writer_->WriteAt(pos, data, size)) {
+            LMMKV_LOGD("Output cannot seek; element sizes stay unknown");
+            seekable_ = false;
+        }
+        return seekable_;
+    }
+
+    // Patch an 8-byte size field written as unknown. Outputs that cannot seek keep the
+    // unknown size, which readers accept for Segments and Clusters.
+    void PatchSize(uint64_t pos, uint64_t size)
+    {
+        uint8_t field[kEbmlPatchableSizeLength];
+        PutEbmlSize(field, size, kEbmlPatchableSizeLength);
+        PatchAt(pos, field, sizeof(field));
+    }
+
+    // Put element at the start of the Void of reserve bytes at pos; a shorter Void
+    // header keeps the rest of the reserved space valid
+    bool PatchReserved(uint64_t pos, size_t reserve, const EbmlBuffer &element)
+    {
+        size_t size = element.Size();
+        if (size != reserve && size + 2 > reserve) {
+            return false;
+        }
+        if (!PatchAt(pos, element.Bytes().data(), size)) {
+            return false;
+        }
+        if (size < reserve) {
+            uint8_t header[1 + kEbmlMaxSizeLength];
+            PatchAt(pos + size, header, PutVoidHeader(header, reserve - size));
+        }
+        return seekable_;
+    }
+
+    MuxTrack *FindTrack(uint64_t track_number)
+    {
+        for (auto &t : tracks_) {
+            if (t.info.track_number == track_number) {
+                return &t;
+            }
+        }
+        return nullptr;
+    }
+
+    void BuildEbmlHeader()
+    {
+        size_t mark = head_.OpenMaster(kEbmlHeaderId);
+        head_.PutUInt(kEbmlVersionId, 1);
+        head_.PutUInt(kEbmlReadVersionId, 1);
+        head_.PutUInt(kEbmlMaxIdLengthId, kEbmlMaxIdLength);
+        head_.PutUInt(kEbmlMaxSizeLengthId, kEbmlMaxSizeLength);
+        head_.PutString(kDocTypeId, opts_.doc_type);
+        head_.PutUInt(kDocTypeVersionId, 4);
+        head_.PutUInt(kDocTypeReadVersionId, 2);
+        head_.CloseMaster(mark);
+    }
+
+    // Info with a Duration that EndSegment() patches once the last frame is known;
+    // returns the Duration payload offset in head_, 0 in live output, which has none
+    size_t BuildInfo()
+    {
+        size_t mark = head_.OpenMaster(kInfoId);
+        head_.PutUInt(kTimecodeScaleId, opts_.timecode_scale_ns);
+        if (!opts_.live) {
+            head_.PutFloat(kDurationId, info_.duration_seconds * 1e9 / static_cast<double>(opts_.timecode_scale_ns));
+        }
+        size_t duration_end = head_.Size() - (mark + kEbmlPatchableSizeLength);
+        head_.PutString(kMuxingAppId, "lmmkv");
+        head_.PutString(kWritingAppId, "lmmkv");
+        size_t payload = head_.CloseMaster(mark);
+        return opts_.live ? 0 : payload + duration_end - sizeof(double);
+    }
+
+    void BuildTracks()
+    {
+        size_t tracks = head_.OpenMaster(kTracksId);
+        for (const auto &track : tracks_) {
+            const MkvTrackInfo &t = track.info;
+            uint64_t type = track.type;
+            size_t entry = head_.OpenMaster(kTrackEntryId);
+            head_.PutUInt(kTrackNumberId, t.track_number);
+            head_.PutUInt(kTrackUidId, t.track_number);
+            head_.PutUInt(kTrackTypeId, type);
+            if (!track.flag_lacing) {
+                head_.PutUInt(kFlagLacingId, 0);
+            }
+            if (track.default_duration_ns > 0) {
+                head_.PutUInt(kDefaultDurationId, track.default_duration_ns);
+            }
+            head_.PutString(kCodecId, t.codec_id);
+            if (!t.codec_name.empty()) {
+                head_.PutString(kCodecNameId, t.codec_name);
+            }
+            if (!t.codec_private.empty()) {
+                head_.PutBinary(kCodecPrivateId, t.codec_private.data(), t.codec_private.size());
+            }
+            if (type == kTrackTypeVideo && t.width > 0 && t.height > 0) {
+                size_t video = head_.OpenMaster(kVideoId);
+                head_.PutUInt(kPixelWidthId, t.width);
+                head_.PutUInt(kPixelHeightId, t.height);
+                head_.CloseMaster(video);
+            } else if (type == kTrackTypeAudio && t.sample_rate > 0) {
+                size_t audio = head_.OpenMaster(kAudioId);
+                head_.PutFloat(kSamplingFreqId, static_cast<double>(t.sample_rate));
+                head_.PutUInt(kChannelsId, t.channels > 0 ? t.channels : 1);
+                head_.CloseMaster(audio);
+            }
+            head_.CloseMaster(entry);
+        }
+        head_.CloseMaster(tracks);
+    }
+
+    bool HeadReady() const
+    {
+        for (const auto &t : tracks_) {
+            if (t.needs_config) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // EBML header, Segment, reserved SeekHead, Info, Tracks and reserved Cues
+    bool WriteHead()
+    {
+        // EBML header and Segment with an unknown size, patched by EndSegment()
+        BuildEbmlHeader();
+        size_t segment_header = head_.Size();
+        auto &bytes = head_.Bytes();
+        bytes.resize(segment_header + 4 + kEbmlPatchableSizeLength);
+        StoreBE(bytes.data() + segment_header, kSegmentId, 4);
+        PutEbmlUnknownSize(bytes.data() + segment_header + 4);
+        segmentSizePos_ = writer_->Position() + segment_header + 4;
+        segmentDataPos_ = segmentSizePos_ + kEbmlPatchableSizeLength;
+
+        // Offsets below are head_ offsets until base is added
+        uint64_t base = writer_->Position();
+        seekHeadPos_ = 0;
+        if (opts_.write_seek_head) {
+            seekHeadPos_ = base + head_.Size();
+            head_.PutVoid(kSeekHeadReserve);
+        }
+        infoPos_ = base + head_.Size();
+        size_t duration = BuildInfo();
+        durationPos_ = duration != 0 ? base + duration : 0;
+        tracksPos_ = base + head_.Size();
+        BuildTracks();
+        init_.assign(head_.Bytes().begin(), head_.Bytes().end());
+        cuesReservePos_ = 0;
+        if (opts_.write_cues && opts_.cues_reserve_bytes >= 2) {
+            cuesReservePos_ = base + head_.Size();
+            head_.PutVoid(opts_.cues_reserve_bytes);
+        }
+        if (!EmitHead()) {
+            return false;
+        }
+        headWritten_ = true;
+        if (listener_) {
+            for (const auto &t : tracks_) {
+                listener_->OnTrackWritten(t.info);
+            }
+        }
+        if (opts_.live && listener_) {
+            MkvChunk chunk;
+            chunk.type = MkvChunkType::kInitSection;
+            chunk.offset = base;
+            chunk.size = init_.size();
+            listener_->OnChunk(chunk);
+        }
+        return true;
+    }
+
+    // keyframe: the first block is a keyframe that a live subscriber can start from
+    bool OpenCluster(int64_t timecode, int64_t timecode_ns, bool keyframe)
+    {
+        // Unknown size until CloseCluster() patches it
+        auto &bytes = head_.Bytes();
+        bytes.resize(4 + kEbmlPatchableSizeLength);
+        StoreBE(bytes.data(), kClusterId, 4);
+        PutEbmlUnknownSize(bytes.data() + 4);
+        head_.PutUInt(kClusterTimecodeId, static_cast<uint64_t>(timecode));
+
+        clusterPos_ = writer_->Position();
+        clusterSizePos_ = clusterPos_ + 4;
+        clusterBytes_ = head_.Size() - 4 - kEbmlPatchableSizeLength;
+        size_t header_size = head_.Size();
+        if (!EmitHead()) {
+            return false;
+        }
+        clusterOpen_ = true;
+        clusterCued_ = false;
+        clusterTimecode_ = timecode;
+        clusterStartNs_ = timecode_ns;
+        lastTimecodeNs_ = timecode_ns;
+        if (listener_) {
+            listener_->OnClusterStart(timecode_ns);
+        }
+        if (opts_.live && listener_) {
+            MkvChunk chunk;
+            chunk.type = MkvChunkType::kClusterStart;
+            chunk.offset = clusterPos_;
+            chunk.size = header_size;
+            chunk.timecode_ns = timecode_ns;
+            chunk.keyframe = keyframe;
+            listener_->OnChunk(chunk);
+        }
+        return true;
+    }
+
+    void CloseCluster()
+    {
+        if (!clusterOpen_) {
+            return;
+        }
+        // Held-back laces belong to this Cluster
+        FlushLaces();
+        clusterOpen_ = false;
+        PatchSize(clusterSizePos_, clusterBytes_);
+        if (listener_) {
+            listener_->OnClusterEnd(lastTimecodeNs_);
+        }
+    }
+
+    // Start a new Cluster when none is open, the current one reached its duration or
+    // size limit, or the block's relative timecode would not fit in 16 bits. Live output
+    // with video cuts at video keyframes (join) instead of the limits.
+    bool NeedNewCluster(int64_t timecode, int64_t timecode_ns, bool join) const
+    {
+        if (!clusterOpen_) {
+            return true;
+        }
+        int64_t relative = timecode - clusterTimecode_;
+        if (relative > std::numeric_limits<int16_t>::max() || relative < std::numeric_limits<int16_t>::min()) {
+            return true;
+        }
+        if (opts_.live && hasVideo_) {
+            return join;
+        }
+        if (clusterBytes_ >= opts_.cluster_size_bytes) {
+            return true;
+        }
+        return timecode_ns - clusterStartNs_ >= static_cast<int64_t>(opts_.cluster_duration_ms) * 1000000;
+    }
+
+    bool WriteBlock(const MuxTrack &track, const MkvFrame &frame, int64_t timecode)
+    {
+        // Payload goes to the writer as is: data/size, or the gathered slices when data is null
+        iov_.clear();
+        iov_.emplace_back(blockHeader_, 0);
+        uint64_t payload = 0;
+        if (frame.data != nullptr) {
+            iov_.emplace_back(frame.data, frame.size);
+            payload = frame.size;
+        } else {
+            for (const auto &s : frame.slices) {
+                iov_.push_back(s);
+                payload += s.second;
+            }
+        }
+        int64_t end_ns = frame.timecode_ns + std::max<int64_t>(frame.duration_ns, 0);
+        return EmitBlock(track, timecode, frame.keyframe ? 0x80 : 0x00, payload, frame.timecode_ns, end_ns);
+    }
+
+    // Write the held-back frames of track as one block, laced when there are several
+    bool FlushLace(MuxTrack &track)
+    {
+        PendingLace &lace = track.lace;
+        size_t count = lace.sizes.size();
+        if (count == 0) {
+            return true;
+        }
+        uint8_t flags = 0x80;
+        iov_.clear();
+        iov_.emplace_back(blockHeader_, 0);
+        uint64_t payload = lace.bytes.size();
+        if (count > 1) {
+            flags |= BuildLaceHeader(lace.sizes, laceHeader_);
+            iov_.emplace_back(laceHeader_.data(), laceHeader_.size());
+            payload += laceHeader_.size();
+        }
+        iov_.emplace_back(lace.bytes.data(), lace.bytes.size());
+        int64_t last_ns = lace.first_ns + static_cast<int64_t>((count - 1) * track.default_duration_ns);
+        bool ok = EmitBlock(track, lace.timecode, flags, payload, last_ns,
+                            last_ns + static_cast<int64_t>(track.default_duration_ns));
+        lace.bytes.clear();
+        lace.sizes.clear();
+        return ok;
+    }
+
+    bool FlushLaces()
+    {
+        bool ok = true;
+        for (auto &t : tracks_) {
+            ok = FlushLace(t) && ok;
+        }
+        return ok;
+    }
+
+    // Laced blocks are written behind the other tracks' blocks that arrive while the lace
+    // is open; sending laces older than max_lace_duration_ms bounds that reordering
+    bool FlushExpiredLaces(int64_t now_ns)
+    {
+        int64_t max_ns = static_cast<int64_t>(opts_.max_lace_duration_ms) * 1000000;
+        bool ok = true;
+        for (auto &t : tracks_) {
+            if (!t.lace.sizes.empty() && now_ns - t.lace.first_ns >= max_ns) {
+                ok = FlushLace(t) && ok;
+            }
+        }
+        return ok;
+    }
+
+    // Whether frame continues the track's pending lace: spaced by DefaultDuration (to
+    // within one timecode tick, the precision of block timecodes) and within the caps
+    bool ExtendsLace(const MuxTrack &track, const MkvFrame &frame) const
+    {
+        const PendingLace &lace = track.lace;
+        if (lace.sizes.empty()) {
+            return true;
+        }
+        int64_t dd = static_cast<int64_t>(track.default_duration_ns);
+        int64_t expected = lace.first_ns + static_cast<int64_t>(lace.sizes.size()) * dd;
+        int64_t diff = frame.timecode_ns - expected;
+        int64_t tick = static_cast<int64_t>(opts_.timecode_scale_ns);
+        if (diff >= tick || -diff >= tick) {
+            return false;
+        }
+        return expected + dd - lace.first_ns <= static_cast<int64_t>(opts_.max_lace_duration_ms) * 1000000;
+    }
+
+    // Append frame to the track's pending lace; sent once it holds max_lace_frames
+    bool AddToLace(MuxTrack &track, const MkvFrame &frame, int64_t timecode)
+    {
+        PendingLace &lace = track.lace;
+        if (lace.sizes.empty()) {
+            lace.first_ns = frame.timecode_ns;
+            lace.timecode = timecode;
+        }
+        size_t size = 0;
+        if (frame.data != nullptr) {
+            lace.bytes.insert(lace.bytes.end(), frame.data, frame.data + frame.size);
+            size = frame.size;
+        } else {
+            for (const auto &s : frame.slices) {
+                lace.bytes.insert(lace.bytes.end(), s.first, s.first + s.second);
+                size += s.second;
+            }
+        }
+        lace.sizes.push_back(size);
+        return lace.sizes.size() < opts_.max_lace_frames || FlushLace(track);
+    }
+
+    // NAL units of an Annex B frame into nals_; parameter sets are kept until the
+    // track's codec_private can be built from them
+    void SplitFrame(MuxTrack &track, const MkvFrame &frame)
+    {
+        const uint8_t *data = frame.data;
+        size_t size = frame.size;
+        if (data == nullptr && frame.slices.size() == 1) {
+            data = frame.slices[0].first;
+            size = frame.slices[0].second;
+        } else if (data == nullptr) {
+            annexbCopy_.clear();
+            for (const auto &s : frame.slices) {
+                annexbCopy_.insert(annexbCopy_.end(), s.first, s.first + s.second);
+            }
+            data = annexbCopy_.data();
+            size = annexbCopy_.size();
+        }
+        SplitAnnexB(data, size, nals_);
+        if (!track.needs_config) {
+            return;
+        }
+
+        for (const auto &nal : nals_) {
+            std::vector<std::vector<uint8_t>> *sets = ParamSets(track, nal);
+            if (sets != nullptr) {
+                std::vector<uint8_t> ps(nal.first, nal.first + nal.second);
+                if (std::find(sets->begin(), sets->end(), ps) == sets->end()) {
+                    sets->push_back(std::move(ps));
+                }
+            }
+        }
+        if (track.sps.empty() || track.pps.empty() || (track.hevc && track.vps.empty())) {
+            return;
+        }
+        bool built = track.hevc ? BuildHvcC(track.vps, track.sps, track.pps, track.info.codec_private)
+                                : BuildAvcC(track.sps, track.pps, track.info.codec_private);
+        if (!built) {
+            LMMKV_LOGW("Track %llu: cannot build CodecPrivate from SPS; waiting for the next one",
+                       (unsigned long long)track.info.track_number);
+            track.sps.clear();
+            return;
+        }
+        track.needs_config = false;
+    }
+
+    // Parameter set list of track matching the type of nal, nullptr for other NAL units
+    static std::vector<std::vector<uint8_t>> *ParamSets(MuxTrack &track, const MkvSlice &nal)
+    {
+        if (track.hevc) {
+            switch (HevcNalType(nal.first)) {
+                case kHevcNalVps:
+                    return &track.vps;
+                case kHevcNalSps:
+                    return &track.sps;
+                case kHevcNalPps:
+                    return &track.pps;
+                default:
+                    return nullptr;
+            }
+        }
+        switch (AvcNalType(nal.first)) {
+            case kAvcNalSps:
+                return &track.sps;
+            case kAvcNalPps:
+                return &track.pps;
+            default:
+                return nullptr;
+        }
+    }
+
+    // In-band copy of a parameter set already in codec_private; readers prepend those to keyframes
+    static bool InCodecPrivate(MuxTrack &track, const MkvSlice &nal)
+    {
+        const std::vector<std::vector<uint8_t>> *sets = ParamSets(track, nal);
+        if (sets == nullptr) {
+            return false;
+        }
+        for (const auto &ps : *sets) {
+            if (ps.size() == nal.second && std::memcmp(ps.data(), nal.first, nal.second) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Whether nal is stored: access unit delimiters and parameter sets repeated from
+    // codec_private are dropped
+    static bool StoredNal(MuxTrack &track, const MkvSlice &nal)
+    {
+        uint8_t type = track.hevc ? HevcNalType(nal.first) : AvcNalType(nal.first);
+        return type != (track.hevc ? kHevcNalAud : kAvcNalAud) && !InCodecPrivate(track, nal);
+    }
+
+    // nals_ as length-prefixed NAL units: 4-byte lengths from nalLengths_, payload
+    // slices pointing at the caller's frame
+    bool WriteAnnexBBlock(MuxTrack &track, const MkvFrame &frame, int64_t timecode)
+    {
+        iov_.clear();
+        iov_.emplace_back(blockHeader_, 0);
+        nalLengths_.resize(4 * nals_.size());
+        uint64_t payload = 0;
+        for (size_t i = 0; i < nals_.size(); ++i) {
+            const MkvSlice &nal = nals_[i];
+            if (!StoredNal(track, nal)) {
+                continue;
+            }
+            uint8_t *length = nalLengths_.data() + 4 * i;
+            StoreBE(length, nal.second, 4);
+            iov_.emplace_back(length, 4);
+            iov_.push_back(nal);
+            payload += 4 + nal.second;
+        }
+        int64_t end_ns = frame.timecode_ns + std::max<int64_t>(frame.duration_ns, 0);
+        return EmitBlock(track, timecode, frame.keyframe ? 0x80 : 0x00, payload, frame.timecode_ns, end_ns);
+    }
+
+    // SimpleBlock header into iov_[0]; iov_[1..] hold payload bytes (lace header and frames)
+    bool EmitBlock(const MuxTrack &track, int64_t timecode, uint8_t flags, uint64_t payload, int64_t timecode_ns,
+                   int64_t end_ns)
+    {
+        uint64_t track_number = track.info.track_number;
+        size_t track_len = EbmlSizeLength(track_number);
+        uint64_t block_size = track_len + 3 + payload;
+        uint8_t *p = blockHeader_;
+        p += PutElementHeader(p, kSimpleBlockId, block_size);
+        PutEbmlSize(p, track_number, track_len);
+        p += track_len;
+        StoreBE(p, static_cast<uint16_t>(static_cast<int16_t>(timecode - clusterTimecode_)), 2);
+        p[2] = flags;
+        p += 3;
+        size_t header_len = static_cast<size_t>(p - blockHeader_);
+        iov_.front().second = header_len;
+
+        uint64_t offset = writer_->Position();
+        if (!Emit(iov_.data(), iov_.size())) {
+            return false;
+        }
+        bool keyframe = (flags & 0x80) != 0;
+        if (opts_.live && listener_) {
+            MkvChunk chunk;
+            chunk.type = MkvChunkType::kBlock;
+            chunk.offset = offset;
+            chunk.size = header_len + payload;
+            chunk.timecode_ns = timecode_ns;
+            chunk.track_number = track_number;
+            chunk.keyframe = keyframe;
+            listener_->OnChunk(chunk);
+        }
+        if (opts_.write_cues && keyframe && (hasVideo_ ? track.type == kTrackTypeVideo : !clusterCued_)) {
+            cues_.push_back({static_cast<uint64_t>(timecode), track_number, clusterPos_ - segmentDataPos_,
+                             clusterBytes_});
+            clusterCued_ = true;
+        }
+        clusterBytes_ += header_len + payload;
+        if (timecode_ns > lastTimecodeNs_) {
+            lastTimecodeNs_ = timecode_ns;
+        }
+        endNs_ = std::max(endNs_, end_ns);
+        return true;
+    }
+
+    // Write frame of track: Annex B conversion, deferred Segment header, lacing, Cluster cuts
+    bool Mux(MuxTrack &track, const MkvFrame &frame)
+    {
+        if (track.annexb) {
+            SplitFrame(track, frame);
+        }
+        if (!headWritten_) {
+            if (!HeadReady()) {
+                if (!dropWarned_) {
+                    LMMKV_LOGW("Dropping frames until every Annex B track has sent its parameter sets");
+                    dropWarned_ = true;
+                }
+                return true;
+            }
+            if (!WriteHead()) {
+                return false;
+            }
+        }
+
+        // An access unit of nothing but AUDs and known parameter sets has no block to
+        // write: no empty SimpleBlock, Cluster or cue point for it
+        if (track.annexb && std::none_of(nals_.begin(), nals_.end(),
+                                         [&track](const MkvSlice &nal) { return StoredNal(track, nal); })) {
+            return true;
+        }
+
+        int64_t timecode = frame.timecode_ns / static_cast<int64_t>(opts_.timecode_scale_ns);
+        bool lace = track.lacing && frame.keyframe;
+        if ((!lace || !ExtendsLace(track, frame)) && !FlushLace(track)) {
+            return false;
+        }
+        if (!FlushExpiredLaces(frame.timecode_ns)) {
+            return false;
+        }
+        // A keyframe of the video track (any track without video) is where playback can start
+        bool join = frame.keyframe && (!hasVideo_ || track.type == kTrackTypeVideo);
+        if (NeedNewCluster(timecode, frame.timecode_ns, join)) {
+            CloseCluster();
+            if (!OpenCluster(timecode, frame.timecode_ns, join)) {
+                return false;
+            }
+        }
+        if (lace) {
+            return AddToLace(track, frame, timecode);
+        }
+        if (track.annexb) {
+            return WriteAnnexBBlock(track, frame, timecode);
+        }
+        return WriteBlock(track, frame, timecode);
+    }
+
+    // Copy frame into its track's queue; payload slices are made contiguous
+    void Enqueue(MuxTrack &track, const MkvFrame &frame)
+    {
+        QueuedFrame queued;
+        if (!spare_.empty()) {
+            queued.bytes = std::move(spare_.back());
+            spare_.pop_back();
+        }
+        queued.bytes.clear();
+        if (frame.data != nullptr) {
+            queued.bytes.assign(frame.data, frame.data + frame.size);
+        } else {
+            for (const auto &s : frame.slices) {
+                queued.bytes.insert(queued.bytes.end(), s.first, s.first + s.second);
+            }
+        }
+        queued.frame.track_number = frame.track_number;
+        queued.frame.timecode_ns = frame.timecode_ns;
+        queued.frame.duration_ns = frame.duration_ns;
+        queued.frame.keyframe = frame.keyframe;
+        queued.frame.references_ns = frame.references_ns;
+        queuedBytes_ += queued.bytes.size();
+        newestQueuedNs_ = std::max(newestQueuedNs_, frame.timecode_ns);
+        track.queue.push_back(std::move(queued));
+    }
+
+    // Write queued frames in timestamp order while every track has one queued (all of
+    // them when drain is set). With a track stalled, the oldest frames are written
+    // anyway while the queue spans more than the delta or exceeds the byte budget.
+    bool Release(bool drain)
+    {
+        int64_t max_delta_ns = static_cast<int64_t>(opts_.max_interleave_delta_ms) * 1000000;
+        for (;;) {
+            MuxTrack *next = nullptr;
+            const MuxTrack *stalled = nullptr;
+            for (auto &t : tracks_) {
+                if (t.queue.empty()) {
+                    stalled = stalled != nullptr ? stalled : &t;
+                    continue;
+                }
+                if (next == nullptr || t.queue.front().frame.timecode_ns < next->queue.front().frame.timecode_ns) {
+                    next = &t;
+                }
+            }
+            if (next == nullptr) {
+                return true;
+            }
+            QueuedFrame &queued = next->queue.front();
+            if (stalled == nullptr) {
+                interleaveStalled_ = false;
+            } else if (!drain) {
+                bool over_delta = newestQueuedNs_ - queued.frame.timecode_ns > max_delta_ns;
+                bool over_budget = queuedBytes_ > opts_.interleave_buffer_bytes;
+                if (!over_delta && !over_budget) {
+                    return true;
+                }
+                if (!interleaveStalled_) {
+                    interleaveStalled_ = true;
+                    MkvFlushReason reason = over_budget ? MkvFlushReason::kBufferFull : MkvFlushReason::kMaxDelta;
+                    LMMKV_LOGD("Interleaver: track %llu stalled, writing frames up to %lld ns (%s)",
+                               (unsigned long long)stalled->info.track_number, (long long)queued.frame.timecode_ns,
+                               over_budget ? "buffer full" : "max delta");
+                    if (listener_) {
+                        listener_->OnInterleaveFlush(reason, stalled->info.track_number, queued.frame.timecode_ns);
+                    }
+                }
+            }
+
+            queued.frame.data = queued.bytes.data();
+            queued.frame.size = queued.bytes.size();
+            bool ok = Mux(*next, queued.frame);
+            queuedBytes_ -= queued.bytes.size();
+            if (spare_.size() < kMaxSpareBuffers) {
+                spare_.push_back(std::move(queued.bytes));
+            }
+            next->queue.pop_front();
+            if (!ok) {
+                return false;
+            }
+        }
+    }
+
+    // Cues into the reserved Void when they fit, else appended after the last Cluster.
+    // Returns the Cues offset, 0 if none were written.
+    uint64_t WriteCues()
+    {
+        if (!opts_.write_cues || cues_.empty()) {
+            return 0;
+        }
+        size_t mark = head_.OpenMaster(kCuesId);
+        for (const auto &cue : cues_) {
+            size_t point = head_.OpenMaster(kCuePointId);
+            head_.PutUInt(kCueTimeId, cue.timecode);
+            size_t positions = head_.OpenMaster(kCueTrackPositionsId);
+            head_.PutUInt(kCueTrackId, cue.track);
+            head_.PutUInt(kCueClusterPositionId, cue.cluster_position);
+            head_.PutUInt(kCueRelativePositionId, cue.relative_position);
+            head_.CloseMaster(positions);
+            head_.CloseMaster(point);
+        }
+        head_.CloseMaster(mark);
+
+        if (cuesReservePos_ != 0 && PatchReserved(cuesReservePos_, opts_.cues_reserve_bytes, head_)) {
+            head_.Clear();
+            return cuesReservePos_;
+        }
+        if (cuesReservePos_ != 0) {
+            LMMKV_LOGD("Cues (%zu bytes) do not fit in the %u reserved bytes; appending them", head_.Size(),
+                       opts_.cues_reserve_bytes);
+        }
+        uint64_t pos = writer_->Position();
+        return EmitHead() ? pos : 0;
+    }
+
+    void WriteSeekHead(uint64_t cues_pos)
+    {
+        const std::pair<uint64_t, uint64_t> entries[] = {
+            {kInfoId, infoPos_}, {kTracksId, tracksPos_}, {kCuesId, cues_pos}};
+        EbmlBuffer seek_head;
+        size_t mark = seek_head.OpenMaster(kSeekHeadId);
+        for (const auto &e : entries) {
+            if (e.second == 0) {
+                continue;
+            }
+            uint8_t id[4];
+            StoreBE(id, e.first, sizeof(id));
+            size_t seek = seek_head.OpenMaster(kSeekId);
+            seek_head.PutBinary(kSeekIdId, id, sizeof(id));
+            seek_head.PutUInt(kSeekPositionId, e.second - segmentDataPos_);
+            seek_head.CloseMaster(seek);
+        }
+        seek_head.CloseMaster(mark);
+        if (!PatchReserved(seekHeadPos_, kSeekHeadReserve, seek_head)) {
+            LMMKV_LOGW("SeekHead not written: output cannot seek");
+        }
     }
 };
 
@@ -35,38 +996,183 @@ void MkvMuxer::SetListener(IMkvMuxListener *listener)
 {
     impl_->listener_ = listener;
 }
-void MkvMuxer::SetWriter(void *writer)
+void MkvMuxer::SetWriter(IMkvWriter *writer)
 {
     impl_->writer_ = writer;
 }
 
 bool MkvMuxer::AddTrack(const MkvTrackInfo &track)
 {
-    impl_->tracks_.push_back(track);
-    if (impl_->listener_)
-        impl_->listener_->OnTrackWritten(track);
+    if (impl_->started_) {
+        LMMKV_LOGE("Tracks must be added before BeginSegment");
+        return false;
+    }
+    if (track.track_number == 0 || impl_->FindTrack(track.track_number) != nullptr) {
+        LMMKV_LOGE("Invalid or duplicate track number %llu", (unsigned long long)track.track_number);
+        return false;
+    }
+    uint64_t type = TrackTypeOf(track);
+    if (track.codec_id.empty() || type == 0) {
+        LMMKV_LOGE("Track %llu: cannot tell the track type of codec '%s'", (unsigned long long)track.track_number,
+                   track.codec_id.c_str());
+        return false;
+    }
+    Impl::MuxTrack t;
+    t.info = track;
+    t.type = type;
+    auto it = track.metadata.find("default_duration_ns");
+    if (it != track.metadata.end()) {
+        t.default_duration_ns = std::strtoull(it->second.c_str(), nullptr, 10);
+    }
+    auto format = track.metadata.find("stream_format");
+    if (format != track.metadata.end() && format->second == "annexb") {
+        t.hevc = track.codec_id == "V_MPEGH/ISO/HEVC";
+        if (!t.hevc && track.codec_id != "V_MPEG4/ISO/AVC") {
+            LMMKV_LOGE("Track %llu: Annex B input needs an AVC or HEVC codec ID",
+                       (unsigned long long)track.track_number);
+            return false;
+        }
+        t.annexb = true;
+        t.needs_config = track.codec_private.empty();
+    }
+    // A lace stores one timecode, so only tracks whose frames are DefaultDuration apart are laced
+    t.lacing = impl_->opts_.enable_lacing && type == kTrackTypeAudio && t.default_duration_ns > 0;
+    auto flag = track.metadata.find("flag_lacing");
+    t.flag_lacing = t.lacing || (flag != track.metadata.end() && flag->second == "1");
+    impl_->tracks_.push_back(std::move(t));
     return true;
 }
 
 bool MkvMuxer::BeginSegment(const MkvInfo &info)
 {
+    if (impl_->writer_ == nullptr) {
+        LMMKV_LOGE("No writer set");
+        return false;
+    }
+    if (impl_->started_) {
+        LMMKV_LOGE("Segment already started");
+        return false;
+    }
+    if (impl_->tracks_.empty()) {
+        LMMKV_LOGE("No tracks added");
+        return false;
+    }
     impl_->info_ = info;
-    if (impl_->listener_)
+    impl_->seekable_ = !impl_->opts_.live;
+    impl_->clusterOpen_ = false;
+    impl_->cues_.clear();
+    impl_->endNs_ = 0;
+    impl_->ClearQueues();
+    impl_->hasVideo_ = false;
+    for (const auto &t : impl_->tracks_) {
+        impl_->hasVideo_ |= t.type == kTrackTypeVideo;
+    }
+    if (impl_->listener_) {
         impl_->listener_->OnSegmentStart();
-    // TODO: write EBML header + Segment + Info + Tracks
+    }
+
+    impl_->headWritten_ = false;
+    impl_->dropWarned_ = false;
+    if (impl_->HeadReady() && !impl_->WriteHead()) {
+        return false;
+    }
+    impl_->started_ = true;
     return true;
 }
 
 bool MkvMuxer::WriteFrame(const MkvFrame &frame)
 {
-    (void)frame;
-    // TODO: rolling Cluster management and SimpleBlock writing
-    return impl_->writer_ != nullptr;
+    if (!impl_->started_) {
+        LMMKV_LOGE("WriteFrame before BeginSegment");
+        return false;
+    }
+    Impl::MuxTrack *track = impl_->FindTrack(frame.track_number);
+    if (track == nullptr) {
+        LMMKV_LOGE("Frame for unknown track %llu", (unsigned long long)frame.track_number);
+        return false;
+    }
+    if (frame.timecode_ns < 0) {
+        LMMKV_LOGE("Negative timecode %lld on track %llu", (long long)frame.timecode_ns,
+                   (unsigned long long)frame.track_number);
+        return false;
+    }
+    if (impl_->opts_.max_interleave_delta_ms == 0) {
+        return impl_->Mux(*track, frame);
+    }
+    impl_->Enqueue(*track, frame);
+    return impl_->Release(false);
+}
+
+bool MkvMuxer::WriteRawCluster(const MkvRawCluster &cluster, IByteSource &source)
+{
+    // Queued frames precede the copied Cluster
+    if (impl_->started_ && !impl_->Release(true)) {
+        return false;
+    }
+    if (!impl_->started_ || !impl_->headWritten_) {
+        LMMKV_LOGE("WriteRawCluster before the Segment header was written");
+        return false;
+    }
+    if (cluster.timecode_ns < 0) {
+        LMMKV_LOGE("Negative Cluster timecode %lld", (long long)cluster.timecode_ns);
+        return false;
+    }
+    impl_->CloseCluster();
+    int64_t timecode = cluster.timecode_ns / static_cast<int64_t>(impl_->opts_.timecode_scale_ns);
+    if (!impl_->OpenCluster(timecode, cluster.timecode_ns, cluster.keyframe_track != 0)) {
+        return false;
+    }
+
+    const Impl::MuxTrack *key = impl_->FindTrack(cluster.keyframe_track);
+    if (impl_->opts_.write_cues && key != nullptr && (!impl_->hasVideo_ || key->type == kTrackTypeVideo)) {
+        uint64_t cue_timecode = static_cast<uint64_t>(cluster.keyframe_ns) / impl_->opts_.timecode_scale_ns;
+        impl_->cues_.push_back({cue_timecode, cluster.keyframe_track, impl_->clusterPos_ - impl_->segmentDataPos_,
+                                impl_->clusterBytes_});
+    }
+    if (!impl_->writer_->WriteFrom(source, cluster.offset, cluster.size)) {
+        impl_->Error(kMkvErrorWriteFailed, "Muxer output copy failed");
+        return false;
+    }
+    impl_->clusterBytes_ += cluster.size;
+    impl_->endNs_ = std::max(impl_->endNs_, cluster.end_ns);
+    impl_->CloseCluster();
+    return true;
 }
 
 bool MkvMuxer::EndSegment()
 {
-    // TODO: optionally write Cues for seekable outputs
+    if (!impl_->started_) {
+        LMMKV_LOGE("EndSegment without BeginSegment");
+        return false;
+    }
+    if (!impl_->Release(true)) {
+        return false;
+    }
+    if (!impl_->headWritten_) {
+        LMMKV_LOGW("Segment ends before the parameter sets of every Annex B track were seen");
+        if (!impl_->WriteHead()) {
+            return false;
+        }
+    }
+    impl_->CloseCluster();
+    uint64_t cues_pos = impl_->WriteCues();
+    if (impl_->seekHeadPos_ != 0) {
+        impl_->WriteSeekHead(cues_pos);
+    }
+
+    // Duration from the end of the latest frame, unless the caller's is longer
+    double duration = std::max(static_cast<double>(impl_->endNs_), impl_->info_.duration_seconds * 1e9) /
+                      static_cast<double>(impl_->opts_.timecode_scale_ns);
+    uint64_t bits = 0;
+    std::memcpy(&bits, &duration, sizeof(bits));
+    uint8_t field[sizeof(bits)];
+    StoreBE(field, bits, sizeof(field));
+    if (impl_->durationPos_ != 0) {
+        impl_->PatchAt(impl_->durationPos_, field, sizeof(field));
+    }
+
+    impl_->PatchSize(impl_->segmentSizePos_, impl_->writer_->Position() - impl_->segmentDataPos_);
+    impl_->started_ = false;
     return true;
 }
 
@@ -75,4 +1181,9 @@ void MkvMuxer::Reset()
     impl_->ResetInternal();
 }
 
-} // namespace lmshao::lmmkv
\ No newline at end of file
+const std::vector<uint8_t> &MkvMuxer::InitSection() const
+{
+    return impl_->init_;
+}
+
+} // namespace lmshao::lmmkv
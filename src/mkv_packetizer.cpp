@@ -0,0 +1,224 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "lmmkv/mkv_packetizer.h"
+
+#include <cstring>
+#include <string>
+
+#include "codec_config.h"
+#include "internal_logger.h"
+
+namespace lmshao::lmmkv {
+
+namespace {
+
+static const uint8_t kStartCode[4] = {0x00, 0x00, 0x00, 0x01};
+static constexpr size_t kAdtsHeaderSize = 7;
+
+bool StartsWith(const std::string &s, const char *prefix)
+{
+    return s.compare(0, std::strlen(prefix), prefix) == 0;
+}
+
+// Length-prefixed NAL units (avcC/hvcC samples) -> Annex B slices. Parameter sets
+// are taken from CodecPrivate once and prepended to keyframes.
+class AnnexBPacketizer final : public IMkvPacketizer {
+public:
+    // avcC: SPS and PPS arrays
+    bool ParseAvcC(const std::vector<uint8_t> &cp)
+    {
+        if (cp.size() < 7) {
+            LMMKV_LOGW("avcC too short: %zu", cp.size());
+            return false;
+        }
+        nalLengthSize_ = static_cast<uint8_t>((cp[4] & 0x03) + 1);
+        uint8_t numSps = cp[5] & 0x1F;
+        size_t offset = 6;
+        for (uint8_t i = 0; i < numSps; ++i) {
+            if (!ReadParamSet(cp, offset)) {
+                return true;
+            }
+        }
+        if (offset + 1 > cp.size())
+            return true;
+        uint8_t numPps = cp[offset];
+        offset += 1;
+        for (uint8_t i = 0; i < numPps; ++i) {
+            if (!ReadParamSet(cp, offset)) {
+                return true;
+            }
+        }
+        return true;
+    }
+
+    // hvcC (minimal): VPS, SPS and PPS arrays, kept in that order
+    bool ParseHvcC(const std::vector<uint8_t> &cp)
+    {
+        if (cp.size() < 23) {
+            LMMKV_LOGW("hvcC too short: %zu", cp.size());
+            return false;
+        }
+        // lengthSizeMinusOne is at byte 21 in ISO/IEC 14496-15 (HEVC)
+        nalLengthSize_ = static_cast<uint8_t>((cp[21] & 0x03) + 1);
+        std::vector<std::vector<uint8_t>> sets[3]; // VPS, SPS, PPS
+        size_t offset = 22;
+        uint8_t numArrays = cp[offset++];
+        for (uint8_t ai = 0; ai < numArrays; ++ai) {
+            if (offset + 3 > cp.size())
+                break;
+            uint8_t nalUnitType = cp[offset] & 0x3F; // 32..34
+            uint16_t numNalus = static_cast<uint16_t>((cp[offset + 1] << 8) | cp[offset + 2]);
+            offset += 3;
+            for (uint16_t ni = 0; ni < numNalus; ++ni) {
+                if (offset + 2 > cp.size())
+                    break;
+                uint16_t nalSize = static_cast<uint16_t>((cp[offset] << 8) | cp[offset + 1]);
+                offset += 2;
+                if (offset + nalSize > cp.size())
+                    break;
+                if (nalUnitType >= 32 && nalUnitType <= 34) {
+                    sets[nalUnitType - 32].emplace_back(cp.begin() + offset, cp.begin() + offset + nalSize);
+                }
+                offset += nalSize;
+            }
+        }
+        for (auto &list : sets) {
+            for (auto &nal : list) {
+                paramSets_.push_back(std::move(nal));
+            }
+        }
+        return true;
+    }
+
+    void Packetize(const MkvPayload &payload, bool keyframe, uint8_t *header, MkvSliceList &out) const override
+    {
+        (void)header;
+        if (keyframe) {
+            for (const auto &ps : paramSets_) {
+                out.emplace_back(kStartCode, sizeof(kStartCode));
+                out.emplace_back(ps.data(), ps.size());
+            }
+        }
+        size_t size = payload.Size();
+        size_t offset = 0;
+        while (offset + nalLengthSize_ <= size) {
+            uint32_t nalLen = 0;
+            if (offset >= payload.prefix.second) {
+                // Past the stripped header: read the length straight from the block
+                const uint8_t *p = payload.data.first + (offset - payload.prefix.second);
+                for (uint8_t i = 0; i < nalLengthSize_; ++i) {
+                    nalLen = (nalLen << 8) | p[i];
+                }
+            } else {
+                for (uint8_t i = 0; i < nalLengthSize_; ++i) {
+                    nalLen = (nalLen << 8) | payload.At(offset + i);
+                }
+            }
+            offset += nalLengthSize_;
+            if (nalLen > size - offset) {
+                break;
+            }
+            out.emplace_back(kStartCode, sizeof(kStartCode));
+            payload.AppendRange(offset, nalLen, out);
+            offset += nalLen;
+        }
+    }
+
+private:
+    bool ReadParamSet(const std::vector<uint8_t> &cp, size_t &offset)
+    {
+        if (offset + 2 > cp.size())
+            return false;
+        uint16_t len = static_cast<uint16_t>((cp[offset] << 8) | cp[offset + 1]);
+        offset += 2;
+        if (offset + len > cp.size())
+            return false;
+        paramSets_.emplace_back(cp.begin() + offset, cp.begin() + offset + len);
+        offset += len;
+        return true;
+    }
+
+    uint8_t nalLengthSize_ = 4; // 1/2/4
+    std::vector<std::vector<uint8_t>> paramSets_;
+};
+
+// Raw AAC access units -> ADTS header slice + payload slice
+class AdtsPacketizer final : public IMkvPacketizer {
+public:
+    explicit AdtsPacketizer(const MkvTrackInfo &track)
+    {
+        // CodecPrivate wins; otherwise the Matroska Audio element values
+        if (!ParseAacConfig(track.codec_private, config_)) {
+            uint8_t index = AacSampleRateIndex(track.sample_rate);
+            if (index != 0xFF) {
+                config_.sample_rate_index = index;
+            }
+            config_.channel_config = static_cast<uint8_t>(track.channels & 0xFF);
+        }
+    }
+
+    void Packetize(const MkvPayload &payload, bool keyframe, uint8_t *header, MkvSliceList &out) const override
+    {
+        (void)keyframe;
+        uint16_t frameLen = static_cast<uint16_t>(payload.Size() + kAdtsHeaderSize);
+        uint8_t profile = static_cast<uint8_t>(config_.object_type - 1);
+        // Byte 0-1: sync + flags
+        header[0] = 0xFF;
+        header[1] = 0xF1; // 1111 0001: MPEG-4, no CRC
+        // Byte 2: profile(2) + sampling_frequency_index(4) + private_bit(1) + channel_config high(1)
+        header[2] = static_cast<uint8_t>(((profile & 0x03) << 6) | ((config_.sample_rate_index & 0x0F) << 2) |
+                                         ((config_.channel_config >> 2) & 0x01));
+        // Byte 3: channel_config low(2) + original/copy(1) + home(1) + copyright bits(2) + frame length high(2)
+        header[3] = static_cast<uint8_t>(((config_.channel_config & 0x03) << 6) | ((frameLen >> 11) & 0x03));
+        // Byte 4: frame length mid 8 bits
+        header[4] = static_cast<uint8_t>((frameLen >> 3) & 0xFF);
+        // Byte 5: frame length low 3 bits + fullness high 5 bits
+        header[5] = static_cast<uint8_t>(((frameLen & 0x07) << 5) | 0x1F);
+        // Byte 6: fullness low 8 bits + num_raw_blocks(2)
+        header[6] = static_cast<uint8_t>(0xFC); // 0x7FF fullness (VBR), num_blocks=0
+        out.emplace_back(header, kAdtsHeaderSize);
+        payload.AppendRange(0, payload.Size(), out);
+    }
+
+private:
+    AacConfig config_;
+};
+
+// Payload as is (Opus packets without Ogg framing, and any codec without a conversion)
+class RawPacketizer final : public IMkvPacketizer {
+public:
+    void Packetize(const MkvPayload &payload, bool keyframe, uint8_t *header, MkvSliceList &out) const override
+    {
+        (void)keyframe;
+        (void)header;
+        payload.AppendRange(0, payload.Size(), out);
+    }
+};
+
+} // namespace
+
+std::shared_ptr<IMkvPacketizer> CreateDefaultPacketizer(const MkvTrackInfo &track)
+{
+    if (StartsWith(track.codec_id, "V_MPEG4/ISO/AVC")) {
+        auto packetizer = std::make_shared<AnnexBPacketizer>();
+        packetizer->ParseAvcC(track.codec_private);
+        return packetizer;
+    }
+    if (StartsWith(track.codec_id, "V_MPEGH/ISO/HEVC")) {
+        auto packetizer = std::make_shared<AnnexBPacketizer>();
+        packetizer->ParseHvcC(track.codec_private);
+        return packetizer;
+    }
+    if (StartsWith(track.codec_id, "A_AAC")) {
+        return std::make_shared<AdtsPacketizer>(track);
+    }
+    return std::make_shared<RawPacketizer>();
+}
+
+} // namespace lmshao::lmmkv
@@ -0,0 +1,246 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "lmmkv/mkv_read_ahead.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "internal_logger.h"
+
+namespace lmshao::lmmkv {
+
+using Clock = std::chrono::steady_clock;
+
+static inline uint64_t ElapsedNs(Clock::time_point since)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - since).count());
+}
+
+class MkvReadAhead::Impl {
+public:
+    Impl(std::shared_ptr<IByteSource> source, const MkvReadAheadOptions &options)
+        : source_(std::move(source)), depth_(std::max<size_t>(options.depth, 2))
+    {
+        alignment_ = options.alignment;
+        if (alignment_ < alignof(std::max_align_t) || (alignment_ & (alignment_ - 1)) != 0) {
+            LMMKV_LOGW("Read-ahead alignment %zu is not a power of two >= %zu; using the default", options.alignment,
+                       alignof(std::max_align_t));
+            alignment_ = MkvReadAheadOptions().alignment;
+        }
+        size_t size = std::max(options.buffer_size, alignment_);
+        bufferSize_ = (size + alignment_ - 1) & ~(alignment_ - 1);
+        slots_.resize(depth_);
+        for (auto &slot : slots_) {
+            slot.data = static_cast<uint8_t *>(::operator new(bufferSize_, std::align_val_t(alignment_)));
+        }
+    }
+
+    ~Impl()
+    {
+        Stop();
+        for (auto &slot : slots_) {
+            ::operator delete(slot.data, std::align_val_t(alignment_));
+        }
+    }
+
+    bool Start(uint64_t offset, uint64_t end)
+    {
+        Stop();
+        if (!source_) {
+            LMMKV_LOGE("Read-ahead has no byte source");
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        pos_ = offset;
+        end_ = std::min(end, source_->Size());
+        head_ = tail_ = 0;
+        filled_ = 0;
+        held_ = false;
+        done_ = false;
+        stop_ = false;
+        current_ = offset;
+        stats_ = MkvReadAheadStats();
+        reader_ = std::thread(&Impl::ReaderMain, this);
+        return true;
+    }
+
+    void Stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        if (reader_.joinable()) {
+            reader_.join();
+        }
+        filled_ = 0;
+        held_ = false;
+    }
+
+    bool Next(const uint8_t *&data, size_t &size)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (held_) {
+            // The caller is done with the previous buffer; hand it back to the reader
+            head_ = (head_ + 1) % depth_;
+            --filled_;
+            held_ = false;
+            cv_.notify_all();
+        }
+        if (filled_ == 0 && !done_ && !stop_) {
+            auto start = Clock::now();
+            cv_.wait(lock, [this] { return filled_ > 0 || done_ || stop_; });
+            if (filled_ > 0) {
+                // Waiting for the end of the range is not a stall
+                stats_.stall_ns += ElapsedNs(start);
+                ++stats_.stalls;
+            }
+        }
+        if (filled_ == 0) {
+            return false;
+        }
+        const Slot &slot = slots_[head_];
+        data = slot.data;
+        size = slot.size;
+        current_ = slot.offset;
+        held_ = true;
+        return true;
+    }
+
+    uint64_t Offset() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current_;
+    }
+
+    MkvReadAheadStats Stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    struct Slot {
+        uint8_t *data = nullptr;
+        size_t size = 0;
+        uint64_t offset = 0;
+    };
+
+    void ReaderMain()
+    {
+        while (true) {
+            Slot *slot = nullptr;
+            uint64_t pos = 0;
+            size_t want = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                if (filled_ == depth_ && !stop_) {
+                    // Every buffer is queued or being parsed
+                    auto start = Clock::now();
+                    cv_.wait(lock, [this] { return filled_ < depth_ || stop_; });
+                    stats_.reader_idle_ns += ElapsedNs(start);
+                }
+                if (stop_) {
+                    return;
+                }
+                if (pos_ >= end_) {
+                    done_ = true;
+                    cv_.notify_all();
+                    return;
+                }
+                slot = &slots_[tail_];
+                pos = pos_;
+                want = static_cast<size_t>(std::min<uint64_t>(bufferSize_, end_ - pos_));
+            }
+
+            auto start = Clock::now();
+            size_t n = source_->ReadAt(pos, slot->data, want);
+            uint64_t read_ns = ElapsedNs(start);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stats_.read_ns += read_ns;
+                if (n == 0) {
+                    LMMKV_LOGE("Read-ahead: read failed at offset %llu", (unsigned long long)pos);
+                    done_ = true;
+                    cv_.notify_all();
+                    return;
+                }
+                slot->size = n;
+                slot->offset = pos;
+                pos_ = pos + n; // a short read continues where it stopped
+                tail_ = (tail_ + 1) % depth_;
+                ++filled_;
+                stats_.bytes_read += n;
+                ++stats_.buffers;
+            }
+            cv_.notify_all();
+        }
+    }
+
+    std::shared_ptr<IByteSource> source_;
+    size_t depth_;
+    size_t alignment_;
+    size_t bufferSize_;
+    std::vector<Slot> slots_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread reader_;
+    uint64_t pos_ = 0; // next offset the reader fills
+    uint64_t end_ = 0;
+    size_t head_ = 0;   // oldest filled slot, handed out by Next()
+    size_t tail_ = 0;   // slot the reader fills next
+    size_t filled_ = 0; // slots queued for or held by the caller
+    bool held_ = false; // slots_[head_] was returned by the last Next()
+    bool done_ = false; // reader finished the range (or failed)
+    bool stop_ = false;
+    uint64_t current_ = 0;
+    MkvReadAheadStats stats_;
+};
+
+MkvReadAhead::MkvReadAhead(std::shared_ptr<IByteSource> source, const MkvReadAheadOptions &options)
+    : impl_(new Impl(std::move(source), options))
+{
+}
+
+MkvReadAhead::~MkvReadAhead() = default;
+
+bool MkvReadAhead::Start(uint64_t offset, uint64_t end)
+{
+    return impl_->Start(offset, end);
+}
+
+void MkvReadAhead::Stop()
+{
+    impl_->Stop();
+}
+
+bool MkvReadAhead::Next(const uint8_t *&data, size_t &size)
+{
+    return impl_->Next(data, size);
+}
+
+uint64_t MkvReadAhead::Offset() const
+{
+    return impl_->Offset();
+}
+
+MkvReadAheadStats MkvReadAhead::Stats() const
+{
+    return impl_->Stats();
+}
+
+} // namespace lmshao::lmmkv
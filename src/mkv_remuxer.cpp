@@ -0,0 +1,561 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "lmmkv/mkv_remuxer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "ebml_reader.h"
+#include "internal_logger.h"
+#include "lmmkv/mkv_demuxer.h"
+#include "mkv_schema.h"
+#include "mkv_seek_index.h"
+
+namespace lmshao::lmmkv {
+
+// Bytes after a SimpleBlock header holding its track vint (up to 8), timecode (2) and flags (1)
+static constexpr size_t kBlockProbeLength = 11;
+
+// Bytes handed to the demuxer per Consume() when a Cluster is re-serialised
+static constexpr size_t kReadChunk = 1024 * 1024;
+
+// Demuxer listener keeping the header elements of an input and passing frames on
+class RemuxListener final : public IMkvDemuxListener {
+public:
+    void OnInfo(const MkvInfo &info) override { info_ = info; }
+    void OnTrack(const MkvTrackInfo &track) override { tracks_.push_back(track); }
+    void OnEndOfStream() override {}
+
+    void OnFrame(const MkvFrame &frame) override
+    {
+        if (onFrame_) {
+            onFrame_(frame);
+        }
+    }
+
+    void OnError(int code, const std::string &msg) override
+    {
+        LMMKV_LOGW("Remux input error %d: %s", code, msg.c_str());
+    }
+
+    void SetFrameHandler(std::function<void(const MkvFrame &)> handler) { onFrame_ = std::move(handler); }
+    const MkvInfo &Info() const { return info_; }
+    const std::vector<MkvTrackInfo> &Tracks() const { return tracks_; }
+
+private:
+    MkvInfo info_;
+    std::vector<MkvTrackInfo> tracks_;
+    std::function<void(const MkvFrame &)> onFrame_;
+};
+
+// End of the Segment following the EBML header; the input size when the Segment size is unknown
+static bool FindSegmentEnd(IByteSource &src, uint64_t &end)
+{
+    EbmlElementHeader hdr{};
+    size_t header_len = 0;
+    uint64_t pos = 0;
+    while (ReadHeaderAt(src, pos, hdr, header_len) && hdr.id != kSegmentId) {
+        if (hdr.size == kEbmlUnknownSize) {
+            return false;
+        }
+        pos += header_len + hdr.size;
+    }
+    if (hdr.id != kSegmentId) {
+        return false;
+    }
+    uint64_t data = pos + header_len;
+    end = hdr.size == kEbmlUnknownSize ? src.Size() : std::min(src.Size(), data + hdr.size);
+    return true;
+}
+
+static bool SameTracks(const std::vector<MkvTrackInfo> &a, const std::vector<MkvTrackInfo> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].track_number != b[i].track_number || a[i].codec_id != b[i].codec_id ||
+            a[i].codec_private != b[i].codec_private) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct MkvRemuxer::Impl {
+    struct Input {
+        std::shared_ptr<IByteSource> source;
+        int64_t start_ns = 0;
+        int64_t end_ns = -1;
+    };
+
+    // Cluster of an input, found by a header walk
+    struct ClusterSpan {
+        uint64_t pos = 0;         // Cluster ID
+        uint64_t end = 0;         // end of the Cluster; the next Cluster for unknown sizes
+        uint64_t blocks = 0;      // first block child; 0 when the Cluster cannot be copied as stored
+        int64_t timecode_ns = -1; // -1 if the Timecode was not found
+        uint64_t keyframe_track = 0;
+        int64_t keyframe_ns = 0;
+    };
+
+    // An opened input: header elements and Cluster table
+    struct Source {
+        MkvInfo info;
+        std::vector<MkvTrackInfo> tracks;
+        std::vector<ClusterSpan> clusters;
+        uint64_t video_track = 0; // cuts snap to its keyframes (0 = no video)
+        int64_t duration_ns = 0;
+    };
+
+    MkvMuxerOptions opts_;
+    IMkvMuxListener *listener_ = nullptr;
+    std::vector<Input> inputs_;
+
+    // Run state
+    std::unique_ptr<MkvMuxer> muxer_;
+    std::vector<MkvTrackInfo> tracks_; // of the first input
+    std::vector<uint8_t> chunk_;
+    MkvFrame frame_;               // shifted copy of a demuxed frame
+    int64_t offsetNs_ = 0;         // output time where the current input starts
+    int64_t outEndNs_ = 0;         // end of the latest output frame or Cluster
+    bool frameOk_ = true;          // cleared when the muxer rejects a frame
+    uint64_t copiedClusters_ = 0;
+    uint64_t copiedBytes_ = 0;
+    uint64_t rewrittenClusters_ = 0;
+
+    // Frame filter of the current input, in input time
+    const Source *src_ = nullptr;
+    int64_t baseNs_ = 0;           // input time mapped to offsetNs_
+    int64_t endNs_ = 0;            // frames at or after this are dropped
+    bool videoStarted_ = true;     // video frames are dropped until the cut keyframe
+    int64_t keyframeNs_ = -1;      // cut keyframe search result
+
+    explicit Impl(const MkvMuxerOptions &o) : opts_(o) {}
+
+    bool OpenSource(const std::shared_ptr<IByteSource> &source, Source &src)
+    {
+        auto listener = std::make_shared<RemuxListener>();
+        MkvDemuxer demuxer;
+        demuxer.SetListener(listener);
+        demuxer.Start();
+        int64_t first = demuxer.Open(source);
+        demuxer.Stop();
+        uint64_t segment_end = 0;
+        if (first < 0 || listener->Tracks().empty() || !FindSegmentEnd(*source, segment_end)) {
+            LMMKV_LOGE("Remux input has no Segment with Tracks");
+            return false;
+        }
+        src.info = listener->Info();
+        src.tracks = listener->Tracks();
+        src.duration_ns = static_cast<int64_t>(src.info.duration_seconds * 1e9);
+        src.video_track = 0;
+        for (const auto &t : src.tracks) {
+            if (t.metadata.count("content_compression") != 0) {
+                // The muxer writes no ContentEncodings, so compressed blocks cannot be carried over
+                LMMKV_LOGE("Track %llu: content-compressed tracks cannot be stream-copied",
+                           (unsigned long long)t.track_number);
+                return false;
+            }
+            auto type = t.metadata.find("type");
+            if (src.video_track == 0 && type != t.metadata.end() && type->second == "video") {
+                src.video_track = t.track_number;
+            }
+        }
+
+        std::vector<uint64_t> starts;
+        ListClusterStarts(*source, static_cast<uint64_t>(first), segment_end, starts);
+        src.clusters.assign(starts.size(), ClusterSpan{});
+        for (size_t i = 0; i < starts.size(); ++i) {
+            ClusterSpan &span = src.clusters[i];
+            span.pos = starts[i];
+            uint64_t next = i + 1 < starts.size() ? starts[i + 1] : segment_end;
+            ProbeCluster(*source, next, src.info.timecode_scale_ns, span);
+        }
+        return true;
+    }
+
+    // Timecode and first block of the Cluster at span.pos, reading only the leading
+    // child headers; next is where the following Cluster starts. CRC-32, Void, Position
+    // and PrevSize before the first block are left out of span.blocks (the CRC and sizes
+    // would not match the copy).
+    static void ProbeCluster(IByteSource &src, uint64_t next, uint64_t scale, ClusterSpan &span)
+    {
+        EbmlElementHeader hdr{};
+        size_t header_len = 0;
+        span.end = next;
+        if (!ReadHeaderAt(src, span.pos, hdr, header_len)) {
+            return;
+        }
+        if (hdr.size != kEbmlUnknownSize) {
+            span.end = span.pos + header_len + hdr.size;
+        }
+        uint64_t pos = span.pos + header_len;
+        while (pos < span.end) {
+            if (!ReadHeaderAt(src, pos, hdr, header_len) || hdr.size == kEbmlUnknownSize) {
+                return;
+            }
+            if (hdr.id == kSimpleBlockId || hdr.id == kBlockGroupId) {
+                break;
+            }
+            if (hdr.id == kClusterTimecodeId) {
+                uint8_t buf[8];
+                if (hdr.size > sizeof(buf) || src.ReadAt(pos + header_len, buf, hdr.size) != hdr.size) {
+                    return;
+                }
+                BufferCursor cur(buf, static_cast<size_t>(hdr.size));
+                span.timecode_ns = static_cast<int64_t>(ReadUnsignedBE(cur, static_cast<size_t>(hdr.size)) * scale);
+            }
+            pos += header_len + hdr.size;
+        }
+        if (span.timecode_ns < 0 || pos >= span.end || span.end > src.Size()) {
+            return;
+        }
+        span.blocks = pos;
+
+        uint8_t buf[kBlockProbeLength];
+        size_t n = hdr.id == kSimpleBlockId ? src.ReadAt(pos + header_len, buf, sizeof(buf)) : 0;
+        uint64_t track = 0;
+        size_t width = DecodeVint(buf, n, false, track);
+        if (width > 0 && n >= width + 3 && (buf[width + 2] & 0x80) != 0) {
+            auto relative = static_cast<int16_t>((buf[width] << 8) | buf[width + 1]);
+            span.keyframe_track = track;
+            span.keyframe_ns = span.timecode_ns + relative * static_cast<int64_t>(scale);
+        }
+    }
+
+    // End of the last frame of cluster from its block headers: relative timecode plus
+    // BlockDuration, else DefaultDuration per laced frame. -1 if a header is unreadable.
+    int64_t ScanClusterEnd(IByteSource &src, const ClusterSpan &cluster) const
+    {
+        auto scale = static_cast<int64_t>(opts_.timecode_scale_ns);
+        int64_t end_ns = cluster.timecode_ns;
+        EbmlElementHeader hdr{};
+        size_t header_len = 0;
+        for (uint64_t pos = cluster.blocks; pos < cluster.end; pos += header_len + hdr.size) {
+            if (!ReadHeaderAt(src, pos, hdr, header_len) || hdr.size == kEbmlUnknownSize) {
+                return -1;
+            }
+            uint64_t block = 0; // SimpleBlock or Block payload
+            int64_t duration_ns = -1;
+            if (hdr.id == kSimpleBlockId) {
+                block = pos + header_len;
+            } else if (hdr.id == kBlockGroupId) {
+                EbmlElementHeader child{};
+                size_t child_len = 0;
+                uint64_t group_end = pos + header_len + hdr.size;
+                for (uint64_t at = pos + header_len; at < group_end; at += child_len + child.size) {
+                    if (!ReadHeaderAt(src, at, child, child_len) || child.size == kEbmlUnknownSize) {
+                        return -1;
+                    }
+                    if (child.id == kBlockId) {
+                        block = at + child_len;
+                    } else if (child.id == kBlockDurationId && child.size <= 8) {
+                        uint8_t buf[8];
+                        if (src.ReadAt(at + child_len, buf, child.size) != child.size) {
+                            return -1;
+                        }
+                        auto size = static_cast<size_t>(child.size);
+                        BufferCursor cur(buf, size);
+                        duration_ns = static_cast<int64_t>(ReadUnsignedBE(cur, size)) * scale;
+                    }
+                }
+            }
+            if (block == 0) {
+                continue;
+            }
+            uint8_t buf[kBlockProbeLength + 1]; // and the lace frame count
+            size_t n = src.ReadAt(block, buf, sizeof(buf));
+            uint64_t track = 0;
+            size_t width = DecodeVint(buf, n, false, track);
+            if (width == 0 || n < width + 3) {
+                return -1;
+            }
+            auto relative = static_cast<int16_t>((buf[width] << 8) | buf[width + 1]);
+            if (duration_ns < 0) {
+                bool laced = (buf[width + 2] & 0x06) != 0 && n > width + 3;
+                duration_ns = LaceStep(track) * (laced ? buf[width + 3] + 1 : 1);
+            }
+            end_ns = std::max(end_ns, cluster.timecode_ns + relative * scale + duration_ns);
+        }
+        return end_ns;
+    }
+
+    // Feed [begin, end) of source to demuxer in bounded chunks. Ranges are not
+    // contiguous (skipped or repeated Clusters), so the demuxer is repositioned first.
+    bool ConsumeRange(MkvDemuxer &demuxer, IByteSource &source, uint64_t begin, uint64_t end)
+    {
+        if (!demuxer.SeekToOffset(begin)) {
+            return false;
+        }
+        chunk_.resize(kReadChunk);
+        while (begin < end) {
+            size_t n = source.ReadAt(begin, chunk_.data(), static_cast<size_t>(std::min<uint64_t>(end - begin,
+                                                                                                     kReadChunk)));
+            if (n == 0) {
+                LMMKV_LOGE("Remux input ends at %llu", (unsigned long long)begin);
+                return false;
+            }
+            demuxer.Consume(chunk_.data(), n);
+            begin += n;
+        }
+        return true;
+    }
+
+    // Latest video keyframe at or before target_ns in cluster, -1 if there is none
+    int64_t FindKeyframe(MkvDemuxer &demuxer, RemuxListener &listener, IByteSource &source,
+                         const ClusterSpan &cluster, int64_t target_ns)
+    {
+        keyframeNs_ = -1;
+        listener.SetFrameHandler([this, target_ns](const MkvFrame &f) {
+            if (f.keyframe && f.timecode_ns <= target_ns) {
+                keyframeNs_ = std::max(keyframeNs_, f.timecode_ns);
+            }
+        });
+        demuxer.SetTrackFilter({src_->video_track});
+        demuxer.SetKeyframesOnly(true);
+        ConsumeRange(demuxer, source, cluster.pos, cluster.end);
+        demuxer.SetTrackFilter({});
+        demuxer.SetKeyframesOnly(false);
+        return keyframeNs_;
+    }
+
+    // Shift a demuxed frame to output time and write it; laced blocks (one passthrough
+    // frame) are split into their frames, DefaultDuration apart
+    void Forward(const MkvFrame &f)
+    {
+        if (!frameOk_) {
+            return;
+        }
+        if (f.track_number == src_->video_track && !videoStarted_) {
+            if (!f.keyframe || f.timecode_ns < baseNs_) {
+                return;
+            }
+            videoStarted_ = true;
+        }
+        if (f.timecode_ns < baseNs_ || f.timecode_ns >= endNs_) {
+            return;
+        }
+        size_t count = std::max<size_t>(f.slices.size(), 1);
+        int64_t step = LaceStep(f.track_number);
+        if (step == 0) {
+            step = f.duration_ns / static_cast<int64_t>(count);
+        }
+        frame_.track_number = f.track_number;
+        frame_.keyframe = f.keyframe;
+        frame_.references_ns = f.references_ns;
+        frame_.duration_ns = count > 1 ? step : f.duration_ns;
+        for (size_t i = 0; i < count && frameOk_; ++i) {
+            frame_.data = count > 1 ? f.slices[i].first : f.data;
+            frame_.size = count > 1 ? f.slices[i].second : f.size;
+            frame_.timecode_ns = f.timecode_ns - baseNs_ + offsetNs_ + static_cast<int64_t>(i) * step;
+            frameOk_ = muxer_->WriteFrame(frame_);
+            outEndNs_ = std::max(outEndNs_, frame_.timecode_ns + std::max<int64_t>(frame_.duration_ns, 0));
+        }
+    }
+
+    int64_t LaceStep(uint64_t track_number) const
+    {
+        for (const auto &t : src_->tracks) {
+            if (t.track_number == track_number) {
+                auto it = t.metadata.find("default_duration_ns");
+                return it != t.metadata.end() ? std::strtoll(it->second.c_str(), nullptr, 10) : 0;
+            }
+        }
+        return 0;
+    }
+
+    bool RemuxInput(const Input &in, const Source &src)
+    {
+        const std::vector<ClusterSpan> &clusters = src.clusters;
+        int64_t scale = static_cast<int64_t>(opts_.timecode_scale_ns);
+        // Block timecodes of copied Clusters stay in the input's scale
+        bool copy = src.info.timecode_scale_ns == opts_.timecode_scale_ns;
+        if (!copy) {
+            LMMKV_LOGW("Input timecode scale %llu differs from the output's; re-serialising every Cluster",
+                       (unsigned long long)src.info.timecode_scale_ns);
+        }
+
+        auto listener = std::make_shared<RemuxListener>();
+        MkvDemuxer demuxer;
+        demuxer.SetListener(listener);
+        demuxer.SetOutputMode(MkvOutputMode::kPassthrough);
+        demuxer.Start();
+        if (demuxer.Open(in.source) < 0) {
+            return false;
+        }
+        src_ = &src;
+        endNs_ = in.end_ns < 0 ? std::numeric_limits<int64_t>::max() : in.end_ns;
+
+        // The cut starts at the video keyframe at or before start_ns, which may lie in an
+        // earlier Cluster than the one holding start_ns
+        size_t first = 0;
+        bool cut = in.start_ns > 0;
+        baseNs_ = 0;
+        videoStarted_ = true;
+        if (cut) {
+            while (first + 1 < clusters.size() && clusters[first + 1].timecode_ns <= in.start_ns) {
+                ++first;
+            }
+            baseNs_ = in.start_ns / scale * scale;
+            if (src.video_track != 0) {
+                videoStarted_ = false;
+                for (size_t i = first + 1; i-- > 0;) {
+                    int64_t key = FindKeyframe(demuxer, *listener, *in.source, clusters[i], in.start_ns);
+                    if (key >= 0) {
+                        baseNs_ = key;
+                        first = i;
+                        break;
+                    }
+                }
+            }
+        }
+
+        listener->SetFrameHandler([this](const MkvFrame &f) { Forward(f); });
+        for (size_t i = first; i < clusters.size() && clusters[i].timecode_ns < endNs_; ++i) {
+            const ClusterSpan &c = clusters[i];
+            int64_t shift = offsetNs_ - baseNs_;
+            int64_t next_ns = i + 1 < clusters.size() ? clusters[i + 1].timecode_ns : -1;
+            if (next_ns < 0 && in.end_ns < 0 && copy && c.blocks != 0) {
+                // The last Cluster ends with the input: at its Duration, else at its last frame
+                next_ns = src.duration_ns > c.timecode_ns ? src.duration_ns : ScanClusterEnd(*in.source, c);
+            }
+            // Copied as stored when every block lies inside the kept range: past the cut
+            // keyframe's Cluster and ending by end_ns (Clusters hold blocks in timestamp
+            // order). A last Cluster whose end is not known is re-serialised.
+            bool whole = copy && c.blocks != 0 && (i > first || !cut) && c.timecode_ns + shift >= 0 &&
+                         next_ns >= c.timecode_ns && next_ns <= endNs_;
+            if (!whole) {
+                frameOk_ = true;
+                if (!ConsumeRange(demuxer, *in.source, c.pos, c.end) || !frameOk_) {
+                    return false;
+                }
+                ++rewrittenClusters_;
+                continue;
+            }
+
+            MkvRawCluster raw;
+            raw.timecode_ns = c.timecode_ns + shift;
+            raw.end_ns = next_ns + shift;
+            raw.offset = c.blocks;
+            raw.size = c.end - c.blocks;
+            raw.keyframe_track = c.keyframe_track;
+            raw.keyframe_ns = c.keyframe_ns + shift;
+            if (!muxer_->WriteRawCluster(raw, *in.source)) {
+                return false;
+            }
+            // The copied video continues the GOP, so a following re-serialised Cluster may start mid-GOP
+            videoStarted_ = true;
+            outEndNs_ = std::max(outEndNs_, raw.end_ns);
+            ++copiedClusters_;
+            copiedBytes_ += raw.size;
+        }
+        demuxer.Stop();
+
+        // The next input starts where this one's kept range ends (Duration, else the last frame)
+        int64_t end_ns = src.duration_ns > 0 ? src.duration_ns : -1;
+        if (in.end_ns >= 0) {
+            end_ns = end_ns < 0 ? in.end_ns : std::min(end_ns, in.end_ns);
+        }
+        int64_t next = end_ns > baseNs_ ? offsetNs_ + (end_ns - baseNs_) : 0;
+        next = std::max(next, outEndNs_);
+        offsetNs_ = (next + scale - 1) / scale * scale;
+        return true;
+    }
+
+    bool Run(IMkvWriter *writer)
+    {
+        if (writer == nullptr || inputs_.empty()) {
+            LMMKV_LOGE("Remux needs a writer and at least one input");
+            return false;
+        }
+        Source src;
+        if (!OpenSource(inputs_.front().source, src)) {
+            return false;
+        }
+        tracks_ = src.tracks;
+        opts_.timecode_scale_ns = src.info.timecode_scale_ns;
+        muxer_.reset(new MkvMuxer(opts_));
+        muxer_->SetWriter(writer);
+        muxer_->SetListener(listener_);
+        for (auto t : tracks_) {
+            // Copied Clusters keep the input's blocks, laced or not
+            t.metadata["flag_lacing"] = "1";
+            if (!muxer_->AddTrack(t)) {
+                return false;
+            }
+        }
+        // Duration comes from the frames and Clusters written
+        MkvInfo info = src.info;
+        info.duration_seconds = 0.0;
+        if (!muxer_->BeginSegment(info)) {
+            return false;
+        }
+
+        offsetNs_ = 0;
+        outEndNs_ = 0;
+        copiedClusters_ = copiedBytes_ = rewrittenClusters_ = 0;
+        for (size_t i = 0; i < inputs_.size(); ++i) {
+            if (i > 0 && !OpenSource(inputs_[i].source, src)) {
+                return false;
+            }
+            if (!SameTracks(tracks_, src.tracks)) {
+                LMMKV_LOGE("Remux input %zu has different Tracks from the first input", i);
+                return false;
+            }
+            if (!RemuxInput(inputs_[i], src)) {
+                return false;
+            }
+        }
+        src_ = nullptr;
+        LMMKV_LOGI("Remuxed %zu inputs: %llu Clusters copied (%llu bytes), %llu re-serialised", inputs_.size(),
+                   (unsigned long long)copiedClusters_, (unsigned long long)copiedBytes_,
+                   (unsigned long long)rewrittenClusters_);
+        return muxer_->EndSegment();
+    }
+};
+
+MkvRemuxer::MkvRemuxer(const MkvMuxerOptions &opts) : impl_(new Impl(opts)) {}
+MkvRemuxer::~MkvRemuxer() = default;
+
+void MkvRemuxer::SetListener(IMkvMuxListener *listener)
+{
+    impl_->listener_ = listener;
+}
+
+bool MkvRemuxer::AddInput(const std::shared_ptr<IByteSource> &source, int64_t start_ns, int64_t end_ns)
+{
+    if (!source) {
+        LMMKV_LOGE("Remux input is null");
+        return false;
+    }
+    if (end_ns >= 0 && end_ns <= start_ns) {
+        LMMKV_LOGE("Empty remux range [%lld, %lld)", (long long)start_ns, (long long)end_ns);
+        return false;
+    }
+    impl_->inputs_.push_back({source, start_ns, end_ns});
+    return true;
+}
+
+bool MkvRemuxer::Run(IMkvWriter *writer)
+{
+    return impl_->Run(writer);
+}
+
+void MkvRemuxer::Reset()
+{
+    impl_->inputs_.clear();
+    impl_->muxer_.reset();
+}
+
+} // namespace lmshao::lmmkv
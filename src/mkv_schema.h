@@ -0,0 +1,269 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_MKV_SCHEMA_H
+#define LMSHAO_LMMKV_MKV_SCHEMA_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "ebml_reader.h"
+
+namespace lmshao::lmmkv {
+
+// EBML payload types
+enum class EbmlType : uint8_t {
+    kMaster,
+    kUnsigned,
+    kSigned,
+    kFloat,
+    kString,
+    kUtf8,
+    kDate,
+    kBinary,
+};
+
+// Parent of elements allowed anywhere (Void, CRC-32)
+static constexpr uint64_t kEbmlAnyParent = ~0ULL;
+// No payload size limit
+static constexpr uint64_t kEbmlAnySize = ~0ULL;
+
+// Matroska element table: name, ID, type, parent ID (0 = top level) and largest
+// valid payload. Each row defines k<Name>Id and MkvElement::k<Name>, and is found
+// by FindElement() in constant time. Adding an element means adding a row here.
+#define LMMKV_MKV_ELEMENTS(X)                                                     \
+    X(EbmlHeader, 0x1A45DFA3, kMaster, 0, kEbmlAnySize)                           \
+    X(EbmlVersion, 0x4286, kUnsigned, kEbmlHeaderId, 8)                           \
+    X(EbmlReadVersion, 0x42F7, kUnsigned, kEbmlHeaderId, 8)                       \
+    X(EbmlMaxIdLength, 0x42F2, kUnsigned, kEbmlHeaderId, 8)                       \
+    X(EbmlMaxSizeLength, 0x42F3, kUnsigned, kEbmlHeaderId, 8)                     \
+    X(DocType, 0x4282, kString, kEbmlHeaderId, kEbmlAnySize)                      \
+    X(DocTypeVersion, 0x4287, kUnsigned, kEbmlHeaderId, 8)                        \
+    X(DocTypeReadVersion, 0x4285, kUnsigned, kEbmlHeaderId, 8)                    \
+    X(Void, 0xEC, kBinary, kEbmlAnyParent, kEbmlAnySize)                          \
+    X(Crc32, 0xBF, kBinary, kEbmlAnyParent, 4)                                    \
+    X(Segment, 0x18538067, kMaster, 0, kEbmlAnySize)                              \
+    X(SeekHead, 0x114D9B74, kMaster, kSegmentId, kEbmlAnySize)                    \
+    X(Seek, 0x4DBB, kMaster, kSeekHeadId, kEbmlAnySize)                           \
+    X(SeekId, 0x53AB, kBinary, kSeekId, kEbmlMaxIdLength)                         \
+    X(SeekPosition, 0x53AC, kUnsigned, kSeekId, 8)                                \
+    X(Info, 0x1549A966, kMaster, kSegmentId, kEbmlAnySize)                        \
+    X(SegmentUid, 0x73A4, kBinary, kInfoId, 16)                                   \
+    X(TimecodeScale, 0x2AD7B1, kUnsigned, kInfoId, 8)                             \
+    X(Duration, 0x4489, kFloat, kInfoId, 8)                                       \
+    X(DateUtc, 0x4461, kDate, kInfoId, 8)                                         \
+    X(Title, 0x7BA9, kUtf8, kInfoId, kEbmlAnySize)                                \
+    X(MuxingApp, 0x4D80, kUtf8, kInfoId, kEbmlAnySize)                            \
+    X(WritingApp, 0x5741, kUtf8, kInfoId, kEbmlAnySize)                           \
+    X(Cluster, 0x1F43B675, kMaster, kSegmentId, kEbmlAnySize)                     \
+    X(ClusterTimecode, 0xE7, kUnsigned, kClusterId, 8)                            \
+    X(ClusterPosition, 0xA7, kUnsigned, kClusterId, 8)                            \
+    X(PrevSize, 0xAB, kUnsigned, kClusterId, 8)                                   \
+    X(SimpleBlock, 0xA3, kBinary, kClusterId, kEbmlAnySize)                       \
+    X(BlockGroup, 0xA0, kMaster, kClusterId, kEbmlAnySize)                        \
+    X(Block, 0xA1, kBinary, kBlockGroupId, kEbmlAnySize)                          \
+    X(BlockDuration, 0x9B, kUnsigned, kBlockGroupId, 8)                           \
+    X(ReferenceBlock, 0xFB, kSigned, kBlockGroupId, 8)                            \
+    X(DiscardPadding, 0x75A2, kSigned, kBlockGroupId, 8)                          \
+    X(Tracks, 0x1654AE6B, kMaster, kSegmentId, kEbmlAnySize)                      \
+    X(TrackEntry, 0xAE, kMaster, kTracksId, kEbmlAnySize)                         \
+    X(TrackNumber, 0xD7, kUnsigned, kTrackEntryId, 8)                             \
+    X(TrackUid, 0x73C5, kUnsigned, kTrackEntryId, 8)                              \
+    X(TrackType, 0x83, kUnsigned, kTrackEntryId, 1)                               \
+    X(FlagEnabled, 0xB9, kUnsigned, kTrackEntryId, 1)                             \
+    X(FlagDefault, 0x88, kUnsigned, kTrackEntryId, 1)                             \
+    X(FlagForced, 0x55AA, kUnsigned, kTrackEntryId, 1)                            \
+    X(FlagLacing, 0x9C, kUnsigned, kTrackEntryId, 1)                              \
+    X(DefaultDuration, 0x23E383, kUnsigned, kTrackEntryId, 8)                     \
+    X(CodecDelay, 0x56AA, kUnsigned, kTrackEntryId, 8)                            \
+    X(SeekPreRoll, 0x56BB, kUnsigned, kTrackEntryId, 8)                           \
+    X(Name, 0x536E, kUtf8, kTrackEntryId, kEbmlAnySize)                           \
+    X(Language, 0x22B59C, kString, kTrackEntryId, kEbmlAnySize)                   \
+    X(Codec, 0x86, kString, kTrackEntryId, kEbmlAnySize)                          \
+    X(CodecPrivate, 0x63A2, kBinary, kTrackEntryId, kEbmlAnySize)                 \
+    X(CodecName, 0x258688, kUtf8, kTrackEntryId, kEbmlAnySize)                    \
+    X(Video, 0xE0, kMaster, kTrackEntryId, kEbmlAnySize)                          \
+    X(PixelWidth, 0xB0, kUnsigned, kVideoId, 8)                                   \
+    X(PixelHeight, 0xBA, kUnsigned, kVideoId, 8)                                  \
+    X(DisplayWidth, 0x54B0, kUnsigned, kVideoId, 8)                               \
+    X(DisplayHeight, 0x54BA, kUnsigned, kVideoId, 8)                              \
+    X(Audio, 0xE1, kMaster, kTrackEntryId, kEbmlAnySize)                          \
+    X(SamplingFreq, 0xB5, kFloat, kAudioId, 8)                                    \
+    X(OutputSamplingFreq, 0x78B5, kFloat, kAudioId, 8)                            \
+    X(Channels, 0x9F, kUnsigned, kAudioId, 8)                                     \
+    X(BitDepth, 0x6264, kUnsigned, kAudioId, 8)                                   \
+    X(ContentEncodings, 0x6D80, kMaster, kTrackEntryId, kEbmlAnySize)             \
+    X(ContentEncoding, 0x6240, kMaster, kContentEncodingsId, kEbmlAnySize)        \
+    X(ContentEncodingOrder, 0x5031, kUnsigned, kContentEncodingId, 8)             \
+    X(ContentEncodingScope, 0x5032, kUnsigned, kContentEncodingId, 8)             \
+    X(ContentEncodingType, 0x5033, kUnsigned, kContentEncodingId, 8)              \
+    X(ContentCompression, 0x5034, kMaster, kContentEncodingId, kEbmlAnySize)      \
+    X(ContentCompAlgo, 0x4254, kUnsigned, kContentCompressionId, 8)               \
+    X(ContentCompSettings, 0x4255, kBinary, kContentCompressionId, kEbmlAnySize)  \
+    X(Cues, 0x1C53BB6B, kMaster, kSegmentId, kEbmlAnySize)                        \
+    X(CuePoint, 0xBB, kMaster, kCuesId, kEbmlAnySize)                             \
+    X(CueTime, 0xB3, kUnsigned, kCuePointId, 8)                                   \
+    X(CueTrackPositions, 0xB7, kMaster, kCuePointId, kEbmlAnySize)                \
+    X(CueTrack, 0xF7, kUnsigned, kCueTrackPositionsId, 8)                         \
+    X(CueClusterPosition, 0xF1, kUnsigned, kCueTrackPositionsId, 8)               \
+    X(CueRelativePosition, 0xF0, kUnsigned, kCueTrackPositionsId, 8)              \
+    X(Chapters, 0x1043A770, kMaster, kSegmentId, kEbmlAnySize)                    \
+    X(Tags, 0x1254C367, kMaster, kSegmentId, kEbmlAnySize)                        \
+    X(Tag, 0x7373, kMaster, kTagsId, kEbmlAnySize)                                \
+    X(Targets, 0x63C0, kMaster, kTagId, kEbmlAnySize)                             \
+    X(TagTrackUid, 0x63C5, kUnsigned, kTargetsId, 8)                              \
+    X(SimpleTag, 0x67C8, kMaster, kTagId, kEbmlAnySize)                           \
+    X(TagName, 0x45A3, kUtf8, kSimpleTagId, kEbmlAnySize)                         \
+    X(TagString, 0x4487, kUtf8, kSimpleTagId, kEbmlAnySize)                       \
+    X(Attachments, 0x1941A469, kMaster, kSegmentId, kEbmlAnySize)
+
+#define LMMKV_MKV_ELEMENT_ID(name, id, type, parent, max_size) static constexpr uint64_t k##name##Id = id##ULL;
+LMMKV_MKV_ELEMENTS(LMMKV_MKV_ELEMENT_ID)
+#undef LMMKV_MKV_ELEMENT_ID
+
+// Dense element index, for switch dispatch that compiles to a jump table
+enum class MkvElement : uint8_t {
+#define LMMKV_MKV_ELEMENT_ENUM(name, id, type, parent, max_size) k##name,
+    LMMKV_MKV_ELEMENTS(LMMKV_MKV_ELEMENT_ENUM)
+#undef LMMKV_MKV_ELEMENT_ENUM
+        kUnknown,
+};
+
+struct ElementSpec {
+    uint64_t id;
+    uint64_t parent;   // 0 at top level, kEbmlAnyParent for global elements
+    uint64_t max_size; // largest valid payload in bytes
+    EbmlType type;
+    const char *name;
+};
+
+static constexpr ElementSpec kMkvSchema[] = {
+#define LMMKV_MKV_ELEMENT_SPEC(name, id, type, parent, max_size) {k##name##Id, parent, max_size, EbmlType::type, #name},
+    LMMKV_MKV_ELEMENTS(LMMKV_MKV_ELEMENT_SPEC)
+#undef LMMKV_MKV_ELEMENT_SPEC
+};
+
+static constexpr size_t kMkvSchemaSize = sizeof(kMkvSchema) / sizeof(kMkvSchema[0]);
+static_assert(kMkvSchemaSize < 0xFF, "schema index must fit the hash slots");
+
+namespace schema_detail {
+
+// Multiplicative hash into 2^kHashBits slots. The multiplier is searched at
+// compile time so that every schema ID lands in its own slot.
+static constexpr unsigned kHashBits = 10;
+static constexpr size_t kHashSlots = size_t{1} << kHashBits;
+static constexpr uint8_t kEmptySlot = 0xFF;
+
+constexpr size_t Slot(uint64_t id, uint64_t mul)
+{
+    return static_cast<size_t>((id * mul) >> (64 - kHashBits));
+}
+
+struct SlotTable {
+    uint8_t index[kHashSlots];
+};
+
+constexpr bool Fill(uint64_t mul, SlotTable &table)
+{
+    for (size_t i = 0; i < kHashSlots; ++i) {
+        table.index[i] = kEmptySlot;
+    }
+    for (size_t i = 0; i < kMkvSchemaSize; ++i) {
+        size_t slot = Slot(kMkvSchema[i].id, mul);
+        if (table.index[slot] != kEmptySlot) {
+            return false;
+        }
+        table.index[slot] = static_cast<uint8_t>(i);
+    }
+    return true;
+}
+
+constexpr uint64_t FindMultiplier()
+{
+    uint64_t mul = 0x9E3779B97F4A7C15ULL;
+    for (int attempt = 0; attempt < 4096; ++attempt) {
+        SlotTable table{};
+        if (Fill(mul, table)) {
+            return mul;
+        }
+        mul = (mul * 6364136223846793005ULL + 1442695040888963407ULL) | 1;
+    }
+    return 0;
+}
+
+static constexpr uint64_t kHashMul = FindMultiplier();
+static_assert(kHashMul != 0, "no collision-free hash for the element schema; raise kHashBits");
+
+constexpr SlotTable BuildSlots()
+{
+    SlotTable table{};
+    Fill(kHashMul, table);
+    return table;
+}
+
+static constexpr SlotTable kSlots = BuildSlots();
+
+} // namespace schema_detail
+
+// Schema index of id, or MkvElement::kUnknown
+inline MkvElement ElementOf(uint64_t id)
+{
+    uint8_t index = schema_detail::kSlots.index[schema_detail::Slot(id, schema_detail::kHashMul)];
+    if (index == schema_detail::kEmptySlot || kMkvSchema[index].id != id) {
+        return MkvElement::kUnknown;
+    }
+    return static_cast<MkvElement>(index);
+}
+
+inline const ElementSpec &SpecOf(MkvElement element)
+{
+    return kMkvSchema[static_cast<size_t>(element)];
+}
+
+// Schema entry for id, or null for elements outside the table
+inline const ElementSpec *FindElement(uint64_t id)
+{
+    MkvElement element = ElementOf(id);
+    return element == MkvElement::kUnknown ? nullptr : &SpecOf(element);
+}
+
+// Whether a payload of size bytes is valid for the element
+inline bool IsValidSize(const ElementSpec &spec, uint64_t size)
+{
+    if (spec.type == EbmlType::kFloat) {
+        return size == 0 || size == 4 || size == 8;
+    }
+    if (spec.type == EbmlType::kDate) {
+        return size == 0 || size == 8;
+    }
+    return size <= spec.max_size;
+}
+
+// Level-1 elements of the Segment (the children a Cluster of unknown size ends at)
+inline bool IsSegmentLevelId(uint64_t id)
+{
+    const ElementSpec *spec = FindElement(id);
+    return spec != nullptr && spec->parent == kSegmentId;
+}
+
+// EBML header and Segment
+inline bool IsTopLevelId(uint64_t id)
+{
+    const ElementSpec *spec = FindElement(id);
+    return spec != nullptr && spec->parent == 0;
+}
+
+// Bytes taken by the encoded form of an element ID (writer side)
+constexpr size_t EbmlIdLength(uint64_t id)
+{
+    return id > 0xFFFFFF ? 4 : id > 0xFFFF ? 3 : id > 0xFF ? 2 : 1;
+}
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_MKV_SCHEMA_H
@@ -0,0 +1,356 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "mkv_seek_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LMMKV_SCAN_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LMMKV_SCAN_NEON 1
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "internal_logger.h"
+#include "mkv_schema.h"
+
+namespace lmshao::lmmkv {
+
+// Bytes read per window while scanning for a Cluster
+static constexpr size_t kScanWindow = 64 * 1024;
+// Bisection stops once the candidate range is this small and walks it linearly
+static constexpr uint64_t kBisectStopRange = 256 * 1024;
+
+void CueIndex::Add(int64_t time_ns, uint64_t cluster_pos)
+{
+    if (!points_.empty() && time_ns < points_.back().time_ns) {
+        sorted_ = false;
+    }
+    points_.push_back({time_ns, cluster_pos});
+}
+
+void CueIndex::Finalize()
+{
+    if (!sorted_) {
+        std::stable_sort(points_.begin(), points_.end(),
+                         [](const CuePoint &a, const CuePoint &b) { return a.time_ns < b.time_ns; });
+        sorted_ = true;
+    }
+    // Several tracks often cue the same Cluster; keep the earliest time only
+    auto last = std::unique(points_.begin(), points_.end(),
+                            [](const CuePoint &a, const CuePoint &b) { return a.cluster_pos == b.cluster_pos; });
+    points_.erase(last, points_.end());
+    points_.shrink_to_fit();
+}
+
+const CuePoint *CueIndex::Find(int64_t target_ns) const
+{
+    if (points_.empty()) {
+        return nullptr;
+    }
+    auto it = std::upper_bound(points_.begin(), points_.end(), target_ns,
+                               [](int64_t t, const CuePoint &p) { return t < p.time_ns; });
+    if (it == points_.begin()) {
+        return &points_.front();
+    }
+    return &*(it - 1);
+}
+
+void ParseSeekHead(BufferCursor &cur, size_t size, std::vector<SeekEntry> &out)
+{
+    size_t end = cur.Tell() + size;
+    EbmlElementHeader hdr{};
+    while (cur.Tell() < end) {
+        if (!NextElement(cur, hdr) || hdr.size > end - cur.Tell())
+            break;
+        size_t payload_end = cur.Tell() + static_cast<size_t>(hdr.size);
+        if (hdr.id == kSeekId) {
+            SeekEntry entry{0, 0};
+            EbmlElementHeader sub{};
+            while (cur.Tell() < payload_end) {
+                if (!NextElement(cur, sub) || sub.size > payload_end - cur.Tell())
+                    break;
+                if (sub.id == kSeekIdId) {
+                    // SeekID holds the raw ID bytes, marker bits included
+                    entry.id = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                } else if (sub.id == kSeekPositionId) {
+                    entry.pos = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                } else {
+                    cur.Seek(cur.Tell() + static_cast<size_t>(sub.size));
+                }
+            }
+            if (entry.id != 0) {
+                out.push_back(entry);
+            }
+        }
+        cur.Seek(payload_end);
+    }
+}
+
+void ParseCues(BufferCursor &cur, size_t size, uint64_t timecode_scale_ns, CueIndex &index)
+{
+    size_t end = cur.Tell() + size;
+    EbmlElementHeader hdr{};
+    while (cur.Tell() < end) {
+        if (!NextElement(cur, hdr) || hdr.size > end - cur.Tell())
+            break;
+        size_t point_end = cur.Tell() + static_cast<size_t>(hdr.size);
+        if (hdr.id == kCuePointId) {
+            uint64_t cue_time = 0;
+            EbmlElementHeader sub{};
+            while (cur.Tell() < point_end) {
+                if (!NextElement(cur, sub) || sub.size > point_end - cur.Tell())
+                    break;
+                size_t sub_end = cur.Tell() + static_cast<size_t>(sub.size);
+                if (sub.id == kCueTimeId) {
+                    cue_time = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+                } else if (sub.id == kCueTrackPositionsId) {
+                    EbmlElementHeader pos{};
+                    while (cur.Tell() < sub_end) {
+                        if (!NextElement(cur, pos) || pos.size > sub_end - cur.Tell())
+                            break;
+                        if (pos.id == kCueClusterPositionId) {
+                            uint64_t cluster_pos = ReadUnsignedBE(cur, static_cast<size_t>(pos.size));
+                            index.Add(static_cast<int64_t>(cue_time * timecode_scale_ns), cluster_pos);
+                        } else {
+                            cur.Seek(cur.Tell() + static_cast<size_t>(pos.size));
+                        }
+                    }
+                }
+                cur.Seek(sub_end);
+            }
+        }
+        cur.Seek(point_end);
+    }
+}
+
+bool ReadHeaderAt(IByteSource &src, uint64_t offset, EbmlElementHeader &hdr, size_t &header_len)
+{
+    uint8_t buf[kEbmlMaxHeaderLength];
+    size_t n = src.ReadAt(offset, buf, sizeof(buf));
+    return ProbeElementHeader(buf, n, hdr, header_len) == EbmlProbeResult::kOk;
+}
+
+static const uint8_t kClusterIdBytes[4] = {0x1F, 0x43, 0xB6, 0x75};
+
+static inline unsigned CountTrailingZeros(uint64_t v)
+{
+#if defined(_MSC_VER)
+    unsigned long index = 0;
+    _BitScanForward64(&index, v);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(v));
+#endif
+}
+
+const uint8_t *FindClusterId(const uint8_t *begin, const uint8_t *end)
+{
+    const uint8_t *p = begin;
+#if defined(LMMKV_SCAN_SSE2)
+    // Compare 16 positions at once: each of the four ID bytes against a shifted load
+    const __m128i b0 = _mm_set1_epi8(static_cast<char>(kClusterIdBytes[0]));
+    const __m128i b1 = _mm_set1_epi8(static_cast<char>(kClusterIdBytes[1]));
+    const __m128i b2 = _mm_set1_epi8(static_cast<char>(kClusterIdBytes[2]));
+    const __m128i b3 = _mm_set1_epi8(static_cast<char>(kClusterIdBytes[3]));
+    while (end - p >= 16 + 3) {
+        __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), b0);
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1)), b1));
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 2)), b2));
+        eq = _mm_and_si128(eq, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 3)), b3));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(eq));
+        if (mask != 0) {
+            return p + CountTrailingZeros(mask);
+        }
+        p += 16;
+    }
+#elif defined(LMMKV_SCAN_NEON)
+    const uint8x16_t b0 = vdupq_n_u8(kClusterIdBytes[0]);
+    const uint8x16_t b1 = vdupq_n_u8(kClusterIdBytes[1]);
+    const uint8x16_t b2 = vdupq_n_u8(kClusterIdBytes[2]);
+    const uint8x16_t b3 = vdupq_n_u8(kClusterIdBytes[3]);
+    while (end - p >= 16 + 3) {
+        uint8x16_t eq = vceqq_u8(vld1q_u8(p), b0);
+        eq = vandq_u8(eq, vceqq_u8(vld1q_u8(p + 1), b1));
+        eq = vandq_u8(eq, vceqq_u8(vld1q_u8(p + 2), b2));
+        eq = vandq_u8(eq, vceqq_u8(vld1q_u8(p + 3), b3));
+        // Narrow to one nibble per lane so the mask fits a 64-bit register
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+        if (mask != 0) {
+            return p + CountTrailingZeros(mask) / 4;
+        }
+        p += 16;
+    }
+#endif
+    while (end - p >= 4) {
+        p = static_cast<const uint8_t *>(std::memchr(p, kClusterIdBytes[0], static_cast<size_t>(end - p - 3)));
+        if (p == nullptr) {
+            return nullptr;
+        }
+        if (std::memcmp(p, kClusterIdBytes, sizeof(kClusterIdBytes)) == 0) {
+            return p;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+EbmlProbeResult ProbeClusterStart(const uint8_t *data, size_t size, uint64_t &timecode)
+{
+    EbmlElementHeader hdr{};
+    size_t off = 0;
+    EbmlProbeResult res = ProbeElementHeader(data, size, hdr, off);
+    if (res != EbmlProbeResult::kOk) {
+        return res;
+    }
+    if (hdr.id != kClusterId) {
+        return EbmlProbeResult::kInvalid;
+    }
+    for (int i = 0; i < 3; ++i) {
+        EbmlElementHeader sub{};
+        size_t sub_len = 0;
+        res = ProbeElementHeader(data + off, size - off, sub, sub_len);
+        if (res != EbmlProbeResult::kOk) {
+            return res;
+        }
+        if (sub.size == kEbmlUnknownSize) {
+            return EbmlProbeResult::kInvalid;
+        }
+        if (sub.id == kClusterTimecodeId) {
+            if (sub.size == 0 || sub.size > 8) {
+                return EbmlProbeResult::kInvalid;
+            }
+            if (sub.size > size - off - sub_len) {
+                return EbmlProbeResult::kNeedMore;
+            }
+            BufferCursor cur(data + off + sub_len, static_cast<size_t>(sub.size));
+            timecode = ReadUnsignedBE(cur, static_cast<size_t>(sub.size));
+            return EbmlProbeResult::kOk;
+        }
+        if (sub.id != kCrc32Id && sub.id != kVoidId) {
+            return EbmlProbeResult::kInvalid;
+        }
+        if (sub.size > size - off - sub_len) {
+            return EbmlProbeResult::kNeedMore;
+        }
+        off += sub_len + static_cast<size_t>(sub.size);
+    }
+    return EbmlProbeResult::kInvalid;
+}
+
+// Validate a Cluster candidate read through the byte source
+static bool ReadClusterTimecode(IByteSource &src, uint64_t pos, uint64_t limit, uint64_t &timecode)
+{
+    uint8_t buf[kClusterProbeLength];
+    size_t n = src.ReadAt(pos, buf, sizeof(buf));
+    EbmlElementHeader hdr{};
+    size_t header_len = 0;
+    if (ProbeElementHeader(buf, n, hdr, header_len) != EbmlProbeResult::kOk ||
+        (hdr.size != kEbmlUnknownSize && hdr.size > limit - pos - header_len)) {
+        return false;
+    }
+    return ProbeClusterStart(buf, n, timecode) == EbmlProbeResult::kOk;
+}
+
+bool FindClusterAt(IByteSource &src, uint64_t from, uint64_t to, uint64_t &pos, uint64_t &timecode)
+{
+    uint64_t limit = std::min<uint64_t>(src.Size(), to == kEbmlUnknownSize ? src.Size() : to);
+    std::vector<uint8_t> window(kScanWindow);
+    uint64_t base = from;
+    while (base < limit) {
+        size_t n = src.ReadAt(base, window.data(), window.size());
+        if (n < sizeof(kClusterIdBytes)) {
+            return false;
+        }
+        const uint8_t *p = window.data();
+        const uint8_t *end = window.data() + n;
+        while ((p = FindClusterId(p, end)) != nullptr) {
+            uint64_t candidate = base + static_cast<uint64_t>(p - window.data());
+            if (candidate >= limit) {
+                return false;
+            }
+            if (ReadClusterTimecode(src, candidate, src.Size(), timecode)) {
+                pos = candidate;
+                return true;
+            }
+            ++p;
+        }
+        // Overlap windows so an ID straddling the boundary is not missed
+        base += n - (sizeof(kClusterIdBytes) - 1);
+    }
+    return false;
+}
+
+bool BisectClusters(IByteSource &src, uint64_t begin, uint64_t end, uint64_t target, uint64_t &pos)
+{
+    uint64_t found = 0;
+    uint64_t timecode = 0;
+    if (!FindClusterAt(src, begin, end, found, timecode)) {
+        return false;
+    }
+    uint64_t best = found;
+    if (timecode <= target) {
+        uint64_t lo = found;
+        uint64_t hi = std::min<uint64_t>(end, src.Size());
+        while (hi - lo > kBisectStopRange) {
+            uint64_t mid = lo + (hi - lo) / 2;
+            if (FindClusterAt(src, mid, hi, found, timecode) && timecode <= target) {
+                best = found;
+                lo = found;
+            } else {
+                hi = mid;
+            }
+        }
+        // Walk the remaining range cluster by cluster, hopping over known-size payloads
+        while (true) {
+            uint64_t next = best + 1;
+            EbmlElementHeader hdr{};
+            size_t header_len = 0;
+            if (ReadHeaderAt(src, best, hdr, header_len) && hdr.size != kEbmlUnknownSize) {
+                next = best + header_len + hdr.size;
+            }
+            if (!FindClusterAt(src, next, hi, found, timecode) || timecode > target) {
+                break;
+            }
+            best = found;
+        }
+    }
+    LMMKV_LOGD("Bisect target=%llu -> cluster at %llu", (unsigned long long)target, (unsigned long long)best);
+    pos = best;
+    return true;
+}
+
+void ListClusterStarts(IByteSource &src, uint64_t first, uint64_t end, std::vector<uint64_t> &out)
+{
+    uint64_t limit = std::min<uint64_t>(src.Size(), end == kEbmlUnknownSize ? src.Size() : end);
+    uint64_t pos = first;
+    uint64_t timecode = 0;
+    while (pos < limit) {
+        EbmlElementHeader hdr{};
+        size_t header_len = 0;
+        if (!ReadHeaderAt(src, pos, hdr, header_len)) {
+            break;
+        }
+        if (hdr.id == kClusterId) {
+            out.push_back(pos);
+        }
+        if (hdr.size != kEbmlUnknownSize) {
+            pos += header_len + hdr.size;
+        } else if (!FindClusterAt(src, pos + header_len, limit, pos, timecode)) {
+            break;
+        }
+    }
+}
+
+} // namespace lmshao::lmmkv
@@ -0,0 +1,96 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_MKV_SEEK_INDEX_H
+#define LMSHAO_LMMKV_MKV_SEEK_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ebml_reader.h"
+#include "lmmkv/mkv_byte_source.h"
+
+namespace lmshao::lmmkv {
+
+// One seekable position: a Cluster and the earliest keyframe time it holds.
+struct CuePoint {
+    int64_t time_ns;
+    uint64_t cluster_pos; // relative to the Segment payload start
+};
+
+// Compact time -> cluster table. 16 bytes per point in one flat array, so
+// hundreds of thousands of cue points are a few MB and a lookup is a binary search.
+class CueIndex {
+public:
+    void Clear()
+    {
+        points_.clear();
+        sorted_ = true;
+    }
+
+    // Append a point; out-of-order input is sorted lazily by Finalize()
+    void Add(int64_t time_ns, uint64_t cluster_pos);
+
+    // Sort by time and drop points that repeat the previous point's cluster
+    void Finalize();
+
+    bool Empty() const { return points_.empty(); }
+    size_t Size() const { return points_.size(); }
+    const std::vector<CuePoint> &Points() const { return points_; }
+
+    // Latest point at or before target_ns; the first point when target precedes all
+    const CuePoint *Find(int64_t target_ns) const;
+
+private:
+    std::vector<CuePoint> points_;
+    bool sorted_ = true;
+};
+
+// SeekHead entry: level-1 element ID and its position relative to the Segment payload
+struct SeekEntry {
+    uint64_t id;
+    uint64_t pos;
+};
+
+// Parse a SeekHead payload
+void ParseSeekHead(BufferCursor &cur, size_t size, std::vector<SeekEntry> &out);
+
+// Parse a Cues payload into index (CueTime scaled to ns); caller calls Finalize()
+void ParseCues(BufferCursor &cur, size_t size, uint64_t timecode_scale_ns, CueIndex &index);
+
+// Bytes after a candidate Cluster ID that ProbeClusterStart() may need: the Cluster
+// header, a CRC-32 or short Void, and the Timecode element
+static constexpr size_t kClusterProbeLength = 64;
+
+// First occurrence of the Cluster ID bytes 1F 43 B6 75 in [begin, end), or null.
+// Vectorized with SSE2/NEON where available.
+const uint8_t *FindClusterId(const uint8_t *begin, const uint8_t *end);
+
+// Validate a Cluster start at data by decoding its header and Timecode child,
+// allowing a leading CRC-32 or Void. kNeedMore when data ends first.
+EbmlProbeResult ProbeClusterStart(const uint8_t *data, size_t size, uint64_t &timecode);
+
+// Read and decode the element header at offset
+bool ReadHeaderAt(IByteSource &src, uint64_t offset, EbmlElementHeader &hdr, size_t &header_len);
+
+// Find the first Cluster starting in [from, to) whose first children decode as a
+// Timecode; returns its absolute offset and raw timecode.
+bool FindClusterAt(IByteSource &src, uint64_t from, uint64_t to, uint64_t &pos, uint64_t &timecode);
+
+// Bisect Cluster timecodes in [begin, end) for the last Cluster whose timecode is
+// at or before target (raw timecode units). Used when a file has no Cues.
+bool BisectClusters(IByteSource &src, uint64_t begin, uint64_t end, uint64_t target, uint64_t &pos);
+
+// Collect absolute Cluster offsets in [first, end) by hopping over element headers;
+// unknown-size Clusters are ended by scanning for the next one.
+void ListClusterStarts(IByteSource &src, uint64_t first, uint64_t end, std::vector<uint64_t> &out);
+
+} // namespace lmshao::lmmkv
+
+#endif // LMSHAO_LMMKV_MKV_SEEK_INDEX_H
@@ -0,0 +1,226 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "lmmkv/mkv_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#include "internal_logger.h"
+
+namespace lmshao::lmmkv {
+
+// Bounce buffer of the default WriteFrom()
+static constexpr size_t kCopyChunk = 1024 * 1024;
+
+bool IMkvWriter::WriteFrom(IByteSource &source, uint64_t offset, uint64_t size)
+{
+    std::vector<uint8_t> buf(static_cast<size_t>(std::min<uint64_t>(size, kCopyChunk)));
+    while (size > 0) {
+        size_t n = source.ReadAt(offset, buf.data(), static_cast<size_t>(std::min<uint64_t>(size, buf.size())));
+        if (n == 0) {
+            LMMKV_LOGE("Copy source ends at %llu", (unsigned long long)offset);
+            return false;
+        }
+        MkvSlice slice(buf.data(), n);
+        if (!Write(&slice, 1)) {
+            return false;
+        }
+        offset += n;
+        size -= n;
+    }
+    return true;
+}
+
+#ifndef _WIN32
+
+// iovecs handed to one writev() call
+static constexpr size_t kMaxIovecs = 64;
+
+// Bytes per copy_file_range() / sendfile() call
+static constexpr size_t kMaxKernelCopy = 1U << 30;
+
+std::shared_ptr<MkvFileWriter> MkvFileWriter::Open(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LMMKV_LOGE("Cannot create %s: %s", path.c_str(), std::strerror(errno));
+        return nullptr;
+    }
+    return std::shared_ptr<MkvFileWriter>(new MkvFileWriter(fd));
+}
+
+MkvFileWriter::~MkvFileWriter()
+{
+    ::close(fd_);
+}
+
+bool MkvFileWriter::Write(const MkvSlice *slices, size_t count)
+{
+    struct iovec iov[kMaxIovecs];
+    size_t next = 0; // first slice not yet in iov
+    size_t skip = 0; // bytes of slices[next] already written
+    while (next < count) {
+        size_t n = 0;
+        for (size_t i = next; i < count && n < kMaxIovecs; ++i) {
+            size_t off = i == next ? skip : 0;
+            if (slices[i].second > off) {
+                iov[n].iov_base = const_cast<uint8_t *>(slices[i].first + off);
+                iov[n].iov_len = slices[i].second - off;
+                ++n;
+            }
+        }
+        if (n == 0) {
+            break;
+        }
+        ssize_t r = ::writev(fd_, iov, static_cast<int>(n));
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            LMMKV_LOGE("writev failed: %s", std::strerror(errno));
+            return false;
+        }
+        pos_ += static_cast<uint64_t>(r);
+        // Partial writes resume inside the slice where the kernel stopped
+        size_t done = static_cast<size_t>(r);
+        while (next < count && done >= slices[next].second - skip) {
+            done -= slices[next].second - skip;
+            skip = 0;
+            ++next;
+        }
+        skip += done;
+    }
+    return true;
+}
+
+bool MkvFileWriter::WriteAt(uint64_t offset, const uint8_t *data, size_t size)
+{
+    size_t done = 0;
+    while (done < size) {
+        ssize_t r = ::pwrite(fd_, data + done, size - done, static_cast<off_t>(offset + done));
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            // ESPIPE for pipes and sockets: the caller keeps unknown sizes
+            return false;
+        }
+        done += static_cast<size_t>(r);
+    }
+    return true;
+}
+
+bool MkvFileWriter::WriteFrom(IByteSource &source, uint64_t offset, uint64_t size)
+{
+#ifdef __linux__
+    // copy_file_range() lets the file system share extents (reflinks) or copy without a
+    // round trip through user space; sendfile() covers kernels and file system pairs it
+    // refuses. What neither handles goes through the buffered default.
+    int in = source.FileDescriptor();
+    bool copy_range = true;
+    while (in >= 0 && size > 0) {
+        size_t len = static_cast<size_t>(std::min<uint64_t>(size, kMaxKernelCopy));
+        ssize_t r = 0;
+        if (copy_range) {
+            loff_t off_in = static_cast<loff_t>(offset);
+            r = ::copy_file_range(in, &off_in, fd_, nullptr, len, 0);
+            if (r < 0 && (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+                copy_range = false;
+                continue;
+            }
+        } else {
+            off_t off_in = static_cast<off_t>(offset);
+            r = ::sendfile(fd_, in, &off_in, len);
+            if (r < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                break;
+            }
+        }
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0) {
+            LMMKV_LOGE("%s failed: %s", copy_range ? "copy_file_range" : "sendfile", std::strerror(errno));
+            return false;
+        }
+        if (r == 0) {
+            break; // source shorter than expected; the buffered path reports it
+        }
+        offset += static_cast<uint64_t>(r);
+        size -= static_cast<uint64_t>(r);
+        pos_ += static_cast<uint64_t>(r);
+    }
+#endif
+    return size == 0 || IMkvWriter::WriteFrom(source, offset, size);
+}
+
+#else // _WIN32
+
+std::shared_ptr<MkvFileWriter> MkvFileWriter::Open(const std::string &path)
+{
+    (void)path;
+    LMMKV_LOGE("MkvFileWriter is not available on this platform");
+    return nullptr;
+}
+
+MkvFileWriter::~MkvFileWriter() = default;
+
+bool MkvFileWriter::Write(const MkvSlice *slices, size_t count)
+{
+    (void)slices;
+    (void)count;
+    return false;
+}
+
+bool MkvFileWriter::WriteAt(uint64_t offset, const uint8_t *data, size_t size)
+{
+    (void)offset;
+    (void)data;
+    (void)size;
+    return false;
+}
+
+bool MkvFileWriter::WriteFrom(IByteSource &source, uint64_t offset, uint64_t size)
+{
+    (void)source;
+    (void)offset;
+    (void)size;
+    return false;
+}
+
+#endif // _WIN32
+
+bool MkvMemoryWriter::Write(const MkvSlice *slices, size_t count)
+{
+    for (size_t i = 0; i < count; ++i) {
+        data_.insert(data_.end(), slices[i].first, slices[i].first + slices[i].second);
+    }
+    return true;
+}
+
+bool MkvMemoryWriter::WriteAt(uint64_t offset, const uint8_t *data, size_t size)
+{
+    if (offset > data_.size() || size > data_.size() - offset) {
+        return false;
+    }
+    std::memcpy(data_.data() + offset, data, size);
+    return true;
+}
+
+} // namespace lmshao::lmmkv
@@ -0,0 +1,116 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// BlockGroup frames carry BlockDuration and ReferenceBlock offsets; keyframe-only mode
+// keeps just the keyframes and, in pull mode, skips the payload of the others unread.
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+// Per Cluster: a video keyframe, a BlockGroup referencing it, a BlockGroup with no
+// reference (a keyframe), audio, and a large non-key SimpleBlock
+std::vector<uint8_t> BuildFile()
+{
+    FixtureBuilder fb;
+    for (int c = 0; c < 3; ++c) {
+        fb.BeginCluster(static_cast<uint64_t>(c * 200));
+        fb.SimpleBlock(1, 0, true, Pattern(60, static_cast<uint8_t>(c)));
+        fb.BlockGroup(1, 40, 40, -40, Pattern(30, static_cast<uint8_t>(c + 10)));
+        fb.BlockGroup(1, 80, 40, 0, Pattern(25, static_cast<uint8_t>(c + 20)));
+        fb.SimpleBlock(2, 60, true, Pattern(5, static_cast<uint8_t>(c + 30)));
+        fb.SimpleBlock(1, 120, false, Pattern(20000, static_cast<uint8_t>(c + 40)));
+        fb.EndCluster();
+    }
+    return fb.Finish();
+}
+
+// Byte source counting the bytes read
+class CountingSource final : public IByteSource {
+public:
+    explicit CountingSource(const std::vector<uint8_t> &data) : source_(data.data(), data.size()) {}
+
+    size_t ReadAt(uint64_t offset, uint8_t *dst, size_t size) override
+    {
+        size_t n = source_.ReadAt(offset, dst, size);
+        read += n;
+        return n;
+    }
+
+    uint64_t Size() const override { return source_.Size(); }
+
+    uint64_t read = 0;
+
+private:
+    MemoryByteSource source_;
+};
+
+} // namespace
+
+int main()
+{
+    auto file = BuildFile();
+
+    auto all = DemuxPieces(file, {});
+    CHECK_EQ(all->errors, 0);
+    CHECK_EQ(all->frames.size(), 15u);
+    if (all->frames.size() == 15) {
+        const auto &referencing = all->frames[1];
+        CHECK_EQ(referencing.timecode_ns, 40000000);
+        CHECK_EQ(referencing.duration_ns, 40000000);
+        CHECK(referencing.references_ns == std::vector<int64_t>({-40000000}));
+        CHECK(!referencing.keyframe);
+        CHECK(all->frames[2].references_ns.empty());
+        CHECK(all->frames[2].keyframe);
+        // SimpleBlock of a track with a DefaultDuration
+        CHECK_EQ(all->frames[3].duration_ns, 20000000);
+        CHECK_EQ(all->frames[4].duration_ns, 0);
+    }
+    for (size_t cut = 1; cut < file.size(); cut += 7) {
+        CHECK(DemuxPieces(file, {cut})->frames == all->frames);
+    }
+
+    std::vector<RecordedFrame> keyframes;
+    for (const auto &f : all->frames) {
+        if (f.keyframe) {
+            keyframes.push_back(f);
+        }
+    }
+    CHECK_EQ(keyframes.size(), 9u);
+
+    auto recorder = std::make_shared<FrameRecorder>();
+    MkvDemuxer demuxer;
+    demuxer.SetListener(recorder);
+    demuxer.SetOutputMode(MkvOutputMode::kPassthrough);
+    demuxer.SetKeyframesOnly(true);
+    demuxer.Start();
+    demuxer.Consume(file.data(), file.size());
+    demuxer.Stop();
+    CHECK(recorder->frames == keyframes);
+
+    // Pull mode leaves the large non-key payloads unread
+    auto source = std::make_shared<CountingSource>(file);
+    MkvDemuxer puller;
+    puller.SetListener(std::make_shared<FrameRecorder>());
+    puller.SetOutputMode(MkvOutputMode::kPassthrough);
+    puller.SetKeyframesOnly(true);
+    puller.Start();
+    CHECK(puller.Open(source) > 0);
+    std::vector<RecordedFrame> pulled;
+    MkvPacket packet;
+    while (puller.ReadPacket(packet) == 1) {
+        pulled.push_back(Record(packet));
+    }
+    puller.Stop();
+    CHECK(pulled == keyframes);
+    CHECK(source->read < file.size() - 40000);
+    return Result("test_block_group");
+}
@@ -0,0 +1,152 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// File byte sources: mmap, pread and io_uring reads (across blocks, past the end,
+// mixed with prefetch hints and from several threads) return the file's bytes, and
+// pull-mode demuxing over each matches memory input.
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <thread>
+
+#include "lmmkv/mkv_file_source.h"
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+constexpr size_t kBlock = 4096;
+
+std::string WriteTempFile(const std::vector<uint8_t> &data)
+{
+    char path[] = "/tmp/lmmkv_test_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return {};
+    }
+    bool ok = write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+    close(fd);
+    return ok ? path : "";
+}
+
+bool ReadMatches(IByteSource &source, const std::vector<uint8_t> &data, uint64_t offset, size_t size)
+{
+    std::vector<uint8_t> buf(size + 1, 0xEE);
+    size_t n = source.ReadAt(offset, buf.data(), size);
+    size_t expected = offset >= data.size() ? 0 : std::min<size_t>(size, data.size() - offset);
+    return n == expected && std::equal(buf.begin(), buf.begin() + n, data.begin() + offset) && buf[size] == 0xEE;
+}
+
+void CheckReads(const char *name, IByteSource &source, const std::vector<uint8_t> &data)
+{
+    std::fprintf(stderr, "%s\n", name);
+    CHECK_EQ(source.Size(), data.size());
+    const uint64_t offsets[] = {0, 1, kBlock - 1, kBlock, 3 * kBlock + 5, data.size() - 10, data.size(),
+                                data.size() + 100};
+    const size_t sizes[] = {0, 1, 10, kBlock, kBlock + 1, 5 * kBlock + 3, data.size()};
+    for (uint64_t offset : offsets) {
+        for (size_t size : sizes) {
+            CHECK(ReadMatches(source, data, offset, size));
+        }
+    }
+    // Prefetch hints between and beyond reads never disturb them
+    uint32_t seed = 1;
+    for (int i = 0; i < 500; ++i) {
+        seed = seed * 1103515245 + 12345;
+        uint64_t offset = seed % data.size();
+        size_t size = (seed >> 8) % (3 * kBlock);
+        source.Prefetch(offset + kBlock, 2 * kBlock);
+        source.Prefetch(data.size() + kBlock, kBlock);
+        CHECK(ReadMatches(source, data, offset, size));
+    }
+
+    // Concurrent readers (DemuxParallel() workers)
+    std::vector<int> bad(4, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t] {
+            uint32_t s = static_cast<uint32_t>(t + 7);
+            for (int i = 0; i < 300; ++i) {
+                s = s * 1103515245 + 12345;
+                uint64_t offset = s % data.size();
+                if (i % 5 == 0) {
+                    source.Prefetch(offset, 4 * kBlock);
+                }
+                bad[t] += ReadMatches(source, data, offset, (s >> 8) % (4 * kBlock)) ? 0 : 1;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int b : bad) {
+        CHECK_EQ(b, 0);
+    }
+}
+
+// Cluster-rich file, so that pull mode issues many small reads
+std::vector<uint8_t> BuildFile()
+{
+    FixtureBuilder fb;
+    for (int c = 0; c < 40; ++c) {
+        fb.BeginCluster(static_cast<uint64_t>(c * 200));
+        for (int i = 0; i < 5; ++i) {
+            fb.SimpleBlock(1, static_cast<int16_t>(i * 40), i == 0, Pattern(300 + 97 * i, static_cast<uint8_t>(c + i)));
+            fb.SimpleBlock(2, static_cast<int16_t>(i * 40 + 20), true, Pattern(40, static_cast<uint8_t>(c * i)));
+        }
+        fb.EndCluster();
+    }
+    return fb.Finish();
+}
+
+} // namespace
+
+int main()
+{
+    auto file = BuildFile();
+    CHECK(file.size() % kBlock != 0);
+    std::string path = WriteTempFile(file);
+    CHECK(!path.empty());
+    if (path.empty()) {
+        return Result("test_byte_source");
+    }
+    CHECK(MmapByteSource::Open(path + ".missing") == nullptr);
+    CHECK(PreadByteSource::Open(path + ".missing") == nullptr);
+    CHECK(IoUringByteSource::Open(path + ".missing") == nullptr);
+
+    auto ref = DemuxPull(std::make_shared<MemoryByteSource>(file.data(), file.size()));
+    CHECK_EQ(ref->frames.size(), 400u);
+
+    std::vector<std::pair<const char *, std::shared_ptr<IByteSource>>> sources;
+    MmapOptions mmap_options;
+    mmap_options.will_need = true;
+    sources.emplace_back("mmap", MmapByteSource::Open(path));
+    sources.emplace_back("mmap (willneed)", MmapByteSource::Open(path, mmap_options));
+    sources.emplace_back("pread", PreadByteSource::Open(path, kBlock));
+    auto uring = IoUringByteSource::Open(path, 4, kBlock);
+    if (uring) {
+        sources.emplace_back("io_uring", uring);
+    } else {
+        std::printf("io_uring unavailable, not tested\n");
+    }
+    for (auto &[name, source] : sources) {
+        CHECK(source != nullptr);
+        if (source) {
+            CheckReads(name, *source, file);
+            CHECK(DemuxPull(source)->frames == ref->frames);
+        }
+    }
+    CHECK_EQ(sources[0].second->FileDescriptor(), -1);
+    CHECK(sources[2].second->FileDescriptor() >= 0);
+
+    unlink(path.c_str());
+    return Result("test_byte_source");
+}
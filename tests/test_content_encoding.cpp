@@ -0,0 +1,118 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// ContentEncoding: header-stripped and zlib-compressed frames come back whole in the
+// converted and sliced modes, and as stored (with content_compression metadata) in
+// passthrough, for every input split.
+
+#ifdef LMMKV_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+// ContentEncodings payload: one encoding of the frames, compressed with algo
+std::vector<uint8_t> Encodings(uint64_t algo, const std::vector<uint8_t> &settings)
+{
+    EbmlBuffer buf;
+    size_t encoding = buf.OpenMaster(kContentEncodingId);
+    buf.PutUInt(kContentEncodingOrderId, 0);
+    buf.PutUInt(kContentEncodingScopeId, 1);
+    buf.PutUInt(kContentEncodingTypeId, 0);
+    size_t compression = buf.OpenMaster(kContentCompressionId);
+    buf.PutUInt(kContentCompAlgoId, algo);
+    if (!settings.empty()) {
+        buf.PutBinary(kContentCompSettingsId, settings.data(), settings.size());
+    }
+    buf.CloseMaster(compression);
+    buf.CloseMaster(encoding);
+    return buf.Bytes();
+}
+
+// Video frames (whole and as stored) in two Clusters, with audio in between
+std::vector<uint8_t> BuildFile(const std::vector<uint8_t> &encodings, const std::vector<std::vector<uint8_t>> &stored)
+{
+    FixtureBuilder fb(encodings);
+    for (size_t i = 0; i < stored.size(); ++i) {
+        if (i % 3 == 0) {
+            if (i != 0) {
+                fb.EndCluster();
+            }
+            fb.BeginCluster(i * 40);
+        }
+        fb.SimpleBlock(1, static_cast<int16_t>(i % 3 * 40), i % 3 == 0, stored[i]);
+        fb.SimpleBlock(2, static_cast<int16_t>(i % 3 * 40 + 20), true, Pattern(4, static_cast<uint8_t>(i)));
+    }
+    fb.EndCluster();
+    return fb.Finish();
+}
+
+std::vector<std::vector<uint8_t>> VideoBytes(const FrameRecorder &recorder)
+{
+    std::vector<std::vector<uint8_t>> out;
+    for (const auto &f : recorder.frames) {
+        if (f.track == 1) {
+            out.push_back(f.bytes);
+        }
+    }
+    return out;
+}
+
+// Whole frames in the converted and sliced modes for every split, stored ones in passthrough
+void CheckDecoded(const std::vector<uint8_t> &file, const std::vector<std::vector<uint8_t>> &whole,
+                  const std::vector<std::vector<uint8_t>> &stored, const char *compression)
+{
+    auto passthrough = DemuxPieces(file, {});
+    CHECK_EQ(passthrough->errors, 0);
+    CHECK(VideoBytes(*passthrough) == stored);
+    CHECK(!passthrough->tracks.empty() && passthrough->tracks[0].metadata["content_compression"] == compression);
+    for (MkvOutputMode mode : {MkvOutputMode::kConverted, MkvOutputMode::kSliced}) {
+        for (size_t cut = 1; cut < file.size(); ++cut) {
+            CHECK(VideoBytes(*DemuxPieces(file, {cut}, mode)) == whole);
+        }
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const std::vector<uint8_t> header = {0x82, 0x49, 0x83, 0x42, 0x00};
+    std::vector<std::vector<uint8_t>> whole;
+    for (size_t i = 0; i < 6; ++i) {
+        auto frame = header;
+        auto body = Pattern(30 + i * 50, static_cast<uint8_t>(i));
+        frame.insert(frame.end(), body.begin(), body.end());
+        whole.push_back(frame);
+    }
+
+    // Header stripping: the shared header is restored ahead of every frame
+    std::vector<std::vector<uint8_t>> stripped;
+    for (const auto &frame : whole) {
+        stripped.emplace_back(frame.begin() + static_cast<std::ptrdiff_t>(header.size()), frame.end());
+    }
+    CheckDecoded(BuildFile(Encodings(3, header), stripped), whole, stripped, "header_stripping");
+
+#ifdef LMMKV_HAVE_ZLIB
+    std::vector<std::vector<uint8_t>> deflated;
+    for (const auto &frame : whole) {
+        uLongf size = compressBound(frame.size());
+        std::vector<uint8_t> out(size);
+        CHECK_EQ(compress(out.data(), &size, frame.data(), frame.size()), Z_OK);
+        out.resize(size);
+        deflated.push_back(out);
+    }
+    CheckDecoded(BuildFile(Encodings(0, {}), deflated), whole, deflated, "zlib");
+#endif
+    return Result("test_content_encoding");
+}
@@ -0,0 +1,89 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Consume() with the input split at every byte delivers the same Info, Tracks and
+// frames as one Consume() of the whole file, in every output mode and batched; pull
+// mode over short reads matches too.
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+// Three Clusters of SimpleBlocks and a laced block, one lace larger than 255 bytes so
+// its Xiph size takes two bytes
+std::vector<uint8_t> BuildFile()
+{
+    FixtureBuilder fb;
+    for (int c = 0; c < 3; ++c) {
+        fb.BeginCluster(static_cast<uint64_t>(c * 200));
+        fb.SimpleBlock(1, 0, true, Pattern(60, static_cast<uint8_t>(c)));
+        fb.XiphLacedBlock(2, 0, {Pattern(12, 1), Pattern(300, 2), Pattern(7, 3)});
+        fb.SimpleBlock(1, 40, false, Pattern(30, static_cast<uint8_t>(c + 10)));
+        fb.SimpleBlock(2, 60, true, Pattern(5, static_cast<uint8_t>(c + 30)));
+        fb.SimpleBlock(1, 120, false, Pattern(45, static_cast<uint8_t>(c + 40)));
+        fb.EndCluster();
+    }
+    return fb.Finish();
+}
+
+bool Same(const FrameRecorder &a, const FrameRecorder &b)
+{
+    return a.frames == b.frames && a.tracks.size() == b.tracks.size() &&
+           a.info.timecode_scale_ns == b.info.timecode_scale_ns && a.errors == b.errors && a.resyncs == b.resyncs &&
+           a.ended == b.ended;
+}
+
+} // namespace
+
+int main()
+{
+    auto file = BuildFile();
+
+    auto ref = DemuxPieces(file, {});
+    CHECK_EQ(ref->errors, 0);
+    CHECK_EQ(ref->resyncs, 0);
+    CHECK_EQ(ref->tracks.size(), 2u);
+    CHECK_EQ(ref->frames.size(), 15u);
+    if (ref->frames.size() == 15) {
+        // Laced block: one passthrough frame with a slice per lace
+        CHECK(ref->frames[1].laces == std::vector<size_t>({12, 300, 7}));
+        CHECK_EQ(ref->frames[14].timecode_ns, 520000000);
+    }
+
+    // Batches hold at most 3 frames and end at each Cluster (5 frames each)
+    auto batched = DemuxPieces(file, {}, MkvOutputMode::kPassthrough, 3);
+    CHECK(batched->frames == ref->frames);
+    CHECK(batched->batches == std::vector<size_t>({3, 2, 3, 2, 3, 2}));
+    CHECK(ref->batches.empty());
+
+    const MkvOutputMode modes[] = {MkvOutputMode::kPassthrough, MkvOutputMode::kConverted, MkvOutputMode::kSliced};
+    for (MkvOutputMode mode : modes) {
+        auto whole = DemuxPieces(file, {}, mode);
+        for (size_t cut = 1; cut < file.size(); ++cut) {
+            CHECK(Same(*DemuxPieces(file, {cut}, mode), *whole));
+            CHECK(Same(*DemuxPieces(file, {cut}, mode, 3), *whole));
+        }
+    }
+    for (size_t chunk = 1; chunk <= 64; ++chunk) {
+        CHECK(Same(*DemuxChunked(file, chunk), *ref));
+        CHECK(Same(*DemuxChunked(file, chunk, 3), *ref));
+    }
+
+    auto pulled = DemuxPull(std::make_shared<MemoryByteSource>(file.data(), file.size()));
+    CHECK(pulled->frames == ref->frames);
+    for (size_t boundary = 1; boundary < file.size(); ++boundary) {
+        CHECK(DemuxPull(std::make_shared<ShortReadSource>(file, file.size(), boundary))->frames == ref->frames);
+    }
+    for (size_t max_read = 1; max_read <= 64; ++max_read) {
+        CHECK(DemuxPull(std::make_shared<ShortReadSource>(file, max_read, 0))->frames == ref->frames);
+    }
+    return Result("test_demuxer_split");
+}
@@ -0,0 +1,212 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Muxer interleaving: tracks arriving in bursts are written in timestamp order, and a
+// stalled track holds the others back only up to max_interleave_delta_ms or
+// interleave_buffer_bytes, each stall reported once through OnInterleaveFlush().
+
+#include <algorithm>
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+struct Flush {
+    MkvFlushReason reason;
+    uint64_t track;
+    int64_t timecode_ns;
+};
+
+class FlushRecorder : public IMkvMuxListener {
+public:
+    void OnSegmentStart() override {}
+    void OnTrackWritten(const MkvTrackInfo &track) override { (void)track; }
+    void OnClusterStart(int64_t cluster_timecode_ns) override { (void)cluster_timecode_ns; }
+    void OnClusterEnd(int64_t last_timecode_ns) override { (void)last_timecode_ns; }
+    void OnError(int code, const std::string &msg) override
+    {
+        (void)code;
+        (void)msg;
+        ++errors;
+    }
+    void OnInterleaveFlush(MkvFlushReason reason, uint64_t stalled_track, int64_t timecode_ns) override
+    {
+        flushes.push_back({reason, stalled_track, timecode_ns});
+    }
+
+    std::vector<Flush> flushes;
+    int errors = 0;
+};
+
+RecordedFrame Frame(uint64_t track, int64_t ms)
+{
+    RecordedFrame r;
+    r.track = track;
+    r.timecode_ns = ms * 1000000;
+    r.keyframe = track == 2 || ms % 400 == 0;
+    r.bytes = Pattern(track == 1 ? 300 : 30, static_cast<uint8_t>(ms / 20 + track));
+    return r;
+}
+
+// Video every 40 ms and audio every 20 ms over [0, duration_ms), in arrival order:
+// each track in bursts of burst_ms, video first. Audio is missing in the gaps
+// ([from, to) ms) and arrives on time again after each.
+std::vector<RecordedFrame> Arrivals(int64_t duration_ms, int64_t burst_ms,
+                                    const std::vector<std::pair<int64_t, int64_t>> &gaps = {})
+{
+    std::vector<RecordedFrame> frames;
+    for (int64_t from = 0; from < duration_ms; from += burst_ms) {
+        for (int64_t ms = from; ms < from + burst_ms; ms += 40) {
+            frames.push_back(Frame(1, ms));
+        }
+        for (int64_t ms = from; ms < from + burst_ms; ms += 20) {
+            bool missing = std::any_of(gaps.begin(), gaps.end(), [ms](const std::pair<int64_t, int64_t> &gap) {
+                return ms >= gap.first && ms < gap.second;
+            });
+            if (!missing) {
+                frames.push_back(Frame(2, ms));
+            }
+        }
+    }
+    return frames;
+}
+
+// Write arrivals, overwriting each payload buffer once WriteFrame() returns (queued
+// frames are copies); progress receives the writer position after each frame
+std::vector<uint8_t> Mux(const MkvMuxerOptions &opts, std::vector<RecordedFrame> arrivals, FlushRecorder &recorder,
+                         std::vector<uint64_t> *progress = nullptr)
+{
+    MkvMemoryWriter writer;
+    MkvMuxer muxer(opts);
+    muxer.SetWriter(&writer);
+    muxer.SetListener(&recorder);
+    for (const auto &track : AvTracks()) {
+        CHECK(muxer.AddTrack(track));
+    }
+    CHECK(muxer.BeginSegment(MkvInfo()));
+    for (auto &r : arrivals) {
+        std::vector<uint8_t> payload = r.bytes;
+        MkvFrame frame;
+        frame.track_number = r.track;
+        frame.timecode_ns = r.timecode_ns;
+        frame.keyframe = r.keyframe;
+        frame.data = payload.data();
+        frame.size = payload.size();
+        CHECK(muxer.WriteFrame(frame));
+        std::fill(payload.begin(), payload.end(), 0xEE);
+        if (progress) {
+            progress->push_back(writer.Position());
+        }
+    }
+    CHECK(muxer.EndSegment());
+    return writer.Data();
+}
+
+std::vector<RecordedFrame> ByTime(std::vector<RecordedFrame> frames)
+{
+    std::stable_sort(frames.begin(), frames.end(), [](const RecordedFrame &a, const RecordedFrame &b) {
+        return a.timecode_ns != b.timecode_ns ? a.timecode_ns < b.timecode_ns : a.track < b.track;
+    });
+    return frames;
+}
+
+bool InTimeOrder(const std::vector<RecordedFrame> &frames)
+{
+    return std::is_sorted(frames.begin(), frames.end(), [](const RecordedFrame &a, const RecordedFrame &b) {
+        return a.timecode_ns < b.timecode_ns;
+    });
+}
+
+} // namespace
+
+int main()
+{
+    // 200 ms bursts per track: written in timestamp order, never forced
+    {
+        MkvMuxerOptions opts;
+        opts.max_interleave_delta_ms = 1000;
+        FlushRecorder recorder;
+        auto arrivals = Arrivals(2000, 200);
+        auto out = DemuxPieces(Mux(opts, arrivals, recorder), {});
+        CHECK_EQ(recorder.errors, 0);
+        CHECK(recorder.flushes.empty());
+        CHECK(InTimeOrder(out->frames));
+        CHECK(SameContent(ByTime(out->frames), ByTime(arrivals)));
+
+        // Without the interleaver the bursts reach the file as they arrived
+        opts.max_interleave_delta_ms = 0;
+        out = DemuxPieces(Mux(opts, arrivals, recorder), {});
+        CHECK(!InTimeOrder(out->frames));
+        CHECK(SameContent(out->frames, arrivals));
+    }
+
+    // Audio stalls twice for 600 ms: video is held back at most 200 ms, each stall is
+    // reported once, and output stays in timestamp order as audio resumes on time
+    {
+        MkvMuxerOptions opts;
+        opts.max_interleave_delta_ms = 200;
+        FlushRecorder recorder;
+        auto arrivals = Arrivals(2400, 40, {{400, 1000}, {1400, 2000}});
+        std::vector<uint64_t> progress;
+        auto out = DemuxPieces(Mux(opts, arrivals, recorder, &progress), {});
+        CHECK_EQ(recorder.errors, 0);
+        CHECK_EQ(recorder.flushes.size(), 2u);
+        for (const auto &flush : recorder.flushes) {
+            CHECK(flush.reason == MkvFlushReason::kMaxDelta);
+            CHECK_EQ(flush.track, 2u);
+        }
+        CHECK(recorder.flushes.size() == 2 && recorder.flushes[0].timecode_ns >= 400000000 &&
+              recorder.flushes[0].timecode_ns < 1000000000 && recorder.flushes[1].timecode_ns >= 1400000000);
+        CHECK(InTimeOrder(out->frames));
+        CHECK(SameContent(ByTime(out->frames), ByTime(arrivals)));
+
+        // The output grows during the stall: frames are not held until audio returns
+        size_t stall_begin = 0;
+        size_t stall_end = 0;
+        for (size_t i = 0; i < arrivals.size(); ++i) {
+            if (arrivals[i].timecode_ns == 480000000 && arrivals[i].track == 1) {
+                stall_begin = i;
+            }
+            if (arrivals[i].timecode_ns == 960000000 && arrivals[i].track == 1) {
+                stall_end = i;
+            }
+        }
+        CHECK(stall_begin > 0 && stall_begin < stall_end && progress[stall_begin] < progress[stall_end]);
+    }
+
+    // A byte budget of a few video frames forces the flush before the delta does
+    {
+        MkvMuxerOptions opts;
+        opts.max_interleave_delta_ms = 10000;
+        opts.interleave_buffer_bytes = 1500;
+        FlushRecorder recorder;
+        auto arrivals = Arrivals(2000, 40, {{400, 1000}});
+        auto out = DemuxPieces(Mux(opts, arrivals, recorder), {});
+        CHECK_EQ(recorder.errors, 0);
+        CHECK_EQ(recorder.flushes.size(), 1u);
+        CHECK(!recorder.flushes.empty() && recorder.flushes[0].reason == MkvFlushReason::kBufferFull &&
+              recorder.flushes[0].track == 2u);
+        CHECK(InTimeOrder(out->frames));
+        CHECK(SameContent(ByTime(out->frames), ByTime(arrivals)));
+    }
+
+    // A track that stops for good is drained by EndSegment() without a flush report
+    {
+        MkvMuxerOptions opts;
+        opts.max_interleave_delta_ms = 10000;
+        FlushRecorder recorder;
+        auto arrivals = Arrivals(1000, 40, {{600, 1000}});
+        auto out = DemuxPieces(Mux(opts, arrivals, recorder), {});
+        CHECK(recorder.flushes.empty());
+        CHECK(SameContent(out->frames, ByTime(arrivals)));
+    }
+    return Result("test_interleave");
+}
@@ -0,0 +1,169 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Live muxer output: unknown-size Segment and Clusters, an init section, every block
+// reaching the writer from WriteFrame() and reported as a chunk, and Clusters cut at
+// video keyframes so a subscriber can join at any Cluster after the init section.
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+class ChunkRecorder : public IMkvMuxListener {
+public:
+    void OnSegmentStart() override {}
+    void OnTrackWritten(const MkvTrackInfo &track) override { (void)track; }
+    void OnClusterStart(int64_t cluster_timecode_ns) override { (void)cluster_timecode_ns; }
+    void OnClusterEnd(int64_t last_timecode_ns) override { (void)last_timecode_ns; }
+    void OnError(int code, const std::string &msg) override
+    {
+        (void)code;
+        (void)msg;
+        ++errors;
+    }
+    void OnChunk(const MkvChunk &chunk) override { chunks.push_back(chunk); }
+
+    std::vector<MkvChunk> chunks;
+    int errors = 0;
+};
+
+// An unknown EBML size of the patchable width (8 bytes) at data
+bool UnknownSizeAt(const uint8_t *data)
+{
+    static const uint8_t kUnknown[8] = {0x01, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    return std::memcmp(data, kUnknown, sizeof(kUnknown)) == 0;
+}
+
+bool Contains(const std::vector<uint8_t> &data, const std::string &text)
+{
+    return std::search(data.begin(), data.end(), text.begin(), text.end()) != data.end();
+}
+
+} // namespace
+
+int main()
+{
+    MkvMuxerOptions opts;
+    opts.live = true;
+    opts.doc_type = "webm";
+    opts.enable_lacing = true; // ignored in live output
+    MkvMemoryWriter writer;
+    ChunkRecorder recorder;
+    MkvMuxer muxer(opts);
+    muxer.SetWriter(&writer);
+    muxer.SetListener(&recorder);
+    for (const auto &track : AvTracks()) {
+        CHECK(muxer.AddTrack(track));
+    }
+    CHECK(muxer.BeginSegment(MkvInfo()));
+
+    // Each frame is on the writer, as a reported chunk, when WriteFrame() returns
+    std::vector<RecordedFrame> input;
+    for (int64_t ms = 0; ms < 3000; ms += 20) {
+        RecordedFrame r;
+        r.track = ms % 40 == 0 ? 1 : 2;
+        r.timecode_ns = ms * 1000000;
+        r.keyframe = r.track == 2 || ms % 400 == 0;
+        r.bytes = Pattern(r.track == 1 ? 300 : 30, static_cast<uint8_t>(ms / 20));
+        input.push_back(r);
+
+        MkvFrame frame;
+        frame.track_number = r.track;
+        frame.timecode_ns = r.timecode_ns;
+        frame.keyframe = r.keyframe;
+        frame.data = input.back().bytes.data();
+        frame.size = input.back().bytes.size();
+        CHECK(muxer.WriteFrame(frame));
+        CHECK(!recorder.chunks.empty());
+        const MkvChunk &last = recorder.chunks.back();
+        CHECK(last.type == MkvChunkType::kBlock);
+        CHECK_EQ(last.track_number, r.track);
+        CHECK_EQ(last.timecode_ns, r.timecode_ns);
+        CHECK_EQ(last.keyframe, r.keyframe);
+        CHECK_EQ(last.offset + last.size, writer.Position());
+    }
+    CHECK(muxer.EndSegment());
+    const std::vector<uint8_t> &out = writer.Data();
+    CHECK_EQ(recorder.errors, 0);
+
+    // The init section comes first, is what InitSection() returns and is a WebM header
+    // with an unknown-size Segment
+    const auto &init = muxer.InitSection();
+    CHECK(recorder.chunks.front().type == MkvChunkType::kInitSection);
+    CHECK_EQ(recorder.chunks.front().offset, 0u);
+    CHECK_EQ(recorder.chunks.front().size, init.size());
+    CHECK(init.size() <= out.size() && std::equal(init.begin(), init.end(), out.begin()));
+    CHECK(Contains(init, "webm"));
+    auto segment = ElementsOf(out, kSegmentId);
+    CHECK_EQ(segment.size(), 1u);
+    CHECK(UnknownSizeAt(out.data() + segment[0].offset + 4));
+
+    // Chunks tile the output and start with the element they name; nothing is patched
+    // afterwards, so no SeekHead, Cues or Duration
+    uint64_t end = 0;
+    size_t clusters = 0;
+    for (const auto &chunk : recorder.chunks) {
+        CHECK_EQ(chunk.offset, end);
+        end = chunk.offset + chunk.size;
+        const uint8_t *p = out.data() + chunk.offset;
+        if (chunk.type == MkvChunkType::kClusterStart) {
+            ++clusters;
+            CHECK(p[0] == 0x1F && p[1] == 0x43 && p[2] == 0xB6 && p[3] == 0x75);
+            CHECK(UnknownSizeAt(p + 4));
+        } else if (chunk.type == MkvChunkType::kBlock) {
+            CHECK_EQ(p[0], 0xA3);
+        }
+    }
+    CHECK_EQ(end, out.size());
+    CHECK(ElementsOf(out, kCuesId).empty());
+    CHECK(ElementsOf(out, kSeekHeadId).empty());
+    CHECK(ElementsOf(out, kDurationId).empty());
+
+    // One Cluster per video keyframe, opened by it; no block is laced
+    CHECK_EQ(clusters, 8u);
+    for (size_t i = 0; i + 1 < recorder.chunks.size(); ++i) {
+        const MkvChunk &chunk = recorder.chunks[i];
+        if (chunk.type == MkvChunkType::kClusterStart) {
+            const MkvChunk &first = recorder.chunks[i + 1];
+            CHECK(chunk.keyframe);
+            CHECK(first.type == MkvChunkType::kBlock && first.track_number == 1 && first.keyframe);
+            CHECK_EQ(first.timecode_ns, chunk.timecode_ns);
+        }
+    }
+    for (const auto &b : ElementsOf(out, kSimpleBlockId)) {
+        CHECK_EQ(out[b.data + 3] & 0x06, 0);
+    }
+
+    // The stream demuxes as written, and from any Cluster after the init section
+    CHECK(SameContent(DemuxPieces(out, {init.size() + 7, out.size() / 2})->frames, input));
+    size_t joins = 0;
+    for (const auto &chunk : recorder.chunks) {
+        if (chunk.type != MkvChunkType::kClusterStart || chunk.timecode_ns != 2000000000) {
+            continue;
+        }
+        std::vector<uint8_t> joined = init;
+        joined.insert(joined.end(), out.begin() + static_cast<std::ptrdiff_t>(chunk.offset), out.end());
+        std::vector<RecordedFrame> tail;
+        std::copy_if(input.begin(), input.end(), std::back_inserter(tail),
+                     [](const RecordedFrame &r) { return r.timecode_ns >= 2000000000; });
+        auto joined_out = DemuxPieces(joined, {});
+        CHECK_EQ(joined_out->errors, 0);
+        CHECK(SameContent(joined_out->frames, tail));
+        ++joins;
+    }
+    CHECK_EQ(joins, 1u);
+    return Result("test_live");
+}
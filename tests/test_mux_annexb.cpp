@@ -0,0 +1,175 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Annex B muxer input: H.264 access units with in-band parameter sets and AUDs are
+// stored as length-prefixed NAL units with avcC built from the SPS/PPS, and demux back;
+// access units left with no NAL unit to store are not written.
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+// Annex B H.264 with in-band parameter sets and AUDs is stored as 4-byte length-prefixed
+// NAL units with avcC built from the SPS/PPS, and converts back to Annex B
+void TestAnnexB()
+{
+    const std::vector<uint8_t> sps = {0x67, 0x42, 0xC0, 0x1E, 0xDA, 0x02, 0x80, 0xBF, 0xE5};
+    const std::vector<uint8_t> pps = {0x68, 0xCE, 0x3C, 0x80};
+    const std::vector<uint8_t> idr = {0x65, 0x88, 0x84, 0x00, 0x33, 0xFF, 0x12};
+    const std::vector<uint8_t> slice = {0x41, 0x9A, 0x02, 0x04, 0x55};
+    const std::vector<uint8_t> aud = {0x09, 0xF0};
+    auto annexb = [](std::initializer_list<const std::vector<uint8_t> *> nals) {
+        std::vector<uint8_t> out;
+        for (const auto *nal : nals) {
+            out.insert(out.end(), {0x00, 0x00, 0x00, 0x01});
+            out.insert(out.end(), nal->begin(), nal->end());
+        }
+        return out;
+    };
+    auto length_prefixed = [](const std::vector<uint8_t> &nal) {
+        std::vector<uint8_t> out = {0x00, 0x00, 0x00, static_cast<uint8_t>(nal.size())};
+        out.insert(out.end(), nal.begin(), nal.end());
+        return out;
+    };
+
+    MkvTrackInfo track;
+    track.track_number = 1;
+    track.codec_id = "V_MPEG4/ISO/AVC";
+    track.metadata["stream_format"] = "annexb";
+    MkvMemoryWriter writer;
+    MkvMuxer muxer(MkvMuxerOptions{});
+    muxer.SetWriter(&writer);
+    CHECK(muxer.AddTrack(track));
+    CHECK(muxer.BeginSegment(MkvInfo()));
+    const std::vector<std::vector<uint8_t>> frames = {annexb({&aud, &sps, &pps, &idr}), annexb({&aud, &slice}),
+                                                      annexb({&sps, &pps, &idr})};
+    for (size_t i = 0; i < frames.size(); ++i) {
+        MkvFrame frame;
+        frame.track_number = 1;
+        frame.timecode_ns = static_cast<int64_t>(i) * 40000000;
+        frame.keyframe = i != 1;
+        frame.data = frames[i].data();
+        frame.size = frames[i].size();
+        CHECK(muxer.WriteFrame(frame));
+    }
+    // Gathered input, split inside a start code and inside a NAL unit
+    const auto gathered = annexb({&slice, &slice});
+    MkvFrame sliced;
+    sliced.track_number = 1;
+    sliced.timecode_ns = 120000000;
+    sliced.size = gathered.size();
+    sliced.slices = {{gathered.data(), 2}, {gathered.data() + 2, 6}, {gathered.data() + 8, gathered.size() - 8}};
+    CHECK(muxer.WriteFrame(sliced));
+    CHECK(muxer.EndSegment());
+    const auto &out = writer.Data();
+
+    auto stored = DemuxPieces(out, {});
+    CHECK_EQ(stored->errors, 0);
+    CHECK_EQ(stored->tracks.size(), 1u);
+    if (stored->tracks.size() == 1) {
+        std::vector<uint8_t> avcc = {0x01, 0x42, 0xC0, 0x1E, 0xFF, 0xE1, 0x00, static_cast<uint8_t>(sps.size())};
+        avcc.insert(avcc.end(), sps.begin(), sps.end());
+        avcc.insert(avcc.end(), {0x01, 0x00, static_cast<uint8_t>(pps.size())});
+        avcc.insert(avcc.end(), pps.begin(), pps.end());
+        CHECK(stored->tracks[0].codec_private == avcc);
+    }
+    CHECK_EQ(stored->frames.size(), 4u);
+    if (stored->frames.size() == 4) {
+        CHECK(stored->frames[0].bytes == length_prefixed(idr));
+        CHECK(stored->frames[1].bytes == length_prefixed(slice));
+        CHECK(stored->frames[2].bytes == length_prefixed(idr));
+        auto one = length_prefixed(slice);
+        auto two = one;
+        two.insert(two.end(), one.begin(), one.end());
+        CHECK(stored->frames[3].bytes == two);
+        CHECK(stored->frames[0].keyframe && !stored->frames[1].keyframe && stored->frames[2].keyframe);
+    }
+
+    // Converted output is Annex B again, parameter sets ahead of keyframes
+    auto converted = DemuxPieces(out, {}, MkvOutputMode::kConverted);
+    CHECK_EQ(converted->frames.size(), 4u);
+    auto contains = [](const std::vector<uint8_t> &bytes, const std::vector<uint8_t> &nal) {
+        std::vector<uint8_t> needle = {0x00, 0x00, 0x01};
+        needle.insert(needle.end(), nal.begin(), nal.end());
+        return std::search(bytes.begin(), bytes.end(), needle.begin(), needle.end()) != bytes.end();
+    };
+    if (converted->frames.size() == 4) {
+        CHECK(contains(converted->frames[0].bytes, sps));
+        CHECK(contains(converted->frames[0].bytes, pps));
+        CHECK(contains(converted->frames[0].bytes, idr));
+        CHECK(contains(converted->frames[1].bytes, slice));
+        CHECK(!contains(converted->frames[1].bytes, aud));
+    }
+}
+
+// An access unit with only an AUD and the parameter sets already in avcC writes no
+// block, opens no Cluster and adds no cue point
+void TestParameterSetsOnly()
+{
+    const std::vector<uint8_t> au_full = {0, 0, 0, 1, 0x09, 0xF0, 0, 0, 0, 1, 0x67, 0x42, 0xC0, 0x1E, 0xDA,
+                                          0, 0, 1, 0x68, 0xCE, 0x3C, 0x80, 0, 0, 1, 0x65, 0x88, 0x84, 0x21};
+    const std::vector<uint8_t> au_sets = {0, 0, 0, 1, 0x09, 0xF0, 0, 0, 0, 1, 0x67, 0x42, 0xC0,
+                                          0x1E, 0xDA, 0, 0, 1, 0x68, 0xCE, 0x3C, 0x80};
+    const std::vector<uint8_t> au_slice = {0, 0, 0, 1, 0x41, 0x9A, 0x02, 0x04};
+
+    MkvTrackInfo track;
+    track.track_number = 1;
+    track.codec_id = "V_MPEG4/ISO/AVC";
+    track.metadata["stream_format"] = "annexb";
+    MkvMuxerOptions opts;
+    opts.write_cues = true;
+    opts.cluster_duration_ms = 30;
+    MkvMemoryWriter writer;
+    MkvMuxer muxer(opts);
+    muxer.SetWriter(&writer);
+    CHECK(muxer.AddTrack(track));
+    CHECK(muxer.BeginSegment(MkvInfo()));
+    const std::vector<const std::vector<uint8_t> *> units = {&au_full, &au_sets, &au_slice};
+    for (size_t i = 0; i < units.size(); ++i) {
+        MkvFrame frame;
+        frame.track_number = 1;
+        frame.timecode_ns = static_cast<int64_t>(i) * 40000000;
+        frame.keyframe = i != 2;
+        frame.data = units[i]->data();
+        frame.size = units[i]->size();
+        CHECK(muxer.WriteFrame(frame));
+    }
+    CHECK(muxer.EndSegment());
+    const auto &out = writer.Data();
+
+    CHECK_EQ(ElementsOf(out, kSimpleBlockId).size(), 2u);
+    CHECK_EQ(ElementsOf(out, kClusterId).size(), 2u);
+    auto cues = ElementsOf(out, kCuesId);
+    CHECK_EQ(cues.size(), 1u);
+    if (cues.size() == 1) {
+        // One CuePoint: ID byte 0xBB directly inside the Cues
+        size_t points = 0;
+        for (uint64_t pos = cues[0].data; pos < cues[0].data + cues[0].size; pos += 2 + out[pos + 1] - 0x80) {
+            points += out[pos] == 0xBB ? 1 : 0;
+        }
+        CHECK_EQ(points, 1u);
+    }
+    auto back = DemuxPieces(out, {});
+    CHECK_EQ(back->errors, 0);
+    CHECK_EQ(back->frames.size(), 2u);
+    if (back->frames.size() == 2) {
+        CHECK_EQ(back->frames[1].timecode_ns, 80000000);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    TestAnnexB();
+    TestParameterSetsOnly();
+    return Result("test_mux_annexb");
+}
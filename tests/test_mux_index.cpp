@@ -0,0 +1,85 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Cues, SeekHead and Duration written by EndSegment(): Open() finds the Duration and
+// Seek() lands on the keyframe Cluster through the Cues, whether they fit the space
+// reserved after Tracks or are appended after the Clusters.
+
+#include <cmath>
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+void CheckIndexed(uint32_t cues_reserve_bytes, bool cues_first)
+{
+    MkvMuxerOptions opts;
+    opts.write_cues = true;
+    opts.write_seek_head = true;
+    opts.cues_reserve_bytes = cues_reserve_bytes;
+    opts.cluster_duration_ms = 400;
+    std::vector<RecordedFrame> input;
+    auto out = MuxAvFile(opts, 3000, input);
+
+    auto segments = ElementsOf(out, kSegmentId);
+    CHECK_EQ(segments.size(), 1u);
+    if (segments.size() == 1) {
+        CHECK_EQ(segments[0].data + segments[0].size, out.size());
+    }
+    auto seek_heads = ElementsOf(out, kSeekHeadId);
+    auto cues = ElementsOf(out, kCuesId);
+    auto clusters = ElementsOf(out, kClusterId);
+    CHECK_EQ(seek_heads.size(), 1u);
+    CHECK_EQ(cues.size(), 1u);
+    CHECK_EQ(ElementsOf(out, kSeekId).size(), 3u); // Info, Tracks, Cues
+    CHECK(!clusters.empty());
+    if (!cues.empty() && !clusters.empty()) {
+        CHECK_EQ(cues[0].offset < clusters[0].offset, cues_first);
+    }
+
+    auto recorder = std::make_shared<FrameRecorder>();
+    MkvDemuxer demuxer;
+    demuxer.SetListener(recorder);
+    demuxer.SetOutputMode(MkvOutputMode::kPassthrough);
+    demuxer.Start();
+    auto source = std::make_shared<MemoryByteSource>(out.data(), out.size());
+    CHECK(demuxer.Open(source) > 0);
+    CHECK(std::fabs(recorder->info.duration_seconds - 3.0) < 1e-6);
+    CHECK_EQ(recorder->tracks.size(), 2u);
+
+    // Keyframes every 400 ms: 1.0 s seeks to the Cluster of the one at 0.8 s
+    int64_t pos = demuxer.Seek(1000000000);
+    bool at_cluster = false;
+    for (const auto &c : clusters) {
+        at_cluster = at_cluster || c.offset == static_cast<uint64_t>(pos);
+    }
+    CHECK(at_cluster);
+    MkvPacket packet;
+    CHECK_EQ(demuxer.ReadPacket(packet), 1);
+    CHECK_EQ(packet.track_number, 1u);
+    CHECK_EQ(packet.timecode_ns, 800000000);
+    CHECK(packet.keyframe);
+    demuxer.Stop();
+
+    auto back = DemuxPieces(out, {});
+    CHECK_EQ(back->errors, 0);
+    CHECK(SameContent(back->frames, input));
+}
+
+} // namespace
+
+int main()
+{
+    CheckIndexed(256, true);
+    CheckIndexed(0, false);
+    CheckIndexed(16, false); // too small: the reserved Void stays and the Cues are appended
+    return Result("test_mux_index");
+}
@@ -0,0 +1,136 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Muxer lacing: audio frames DefaultDuration apart share a SimpleBlock, laced fixed
+// (equal sizes), Xiph (small sizes) or EBML (large sizes of small differences), within
+// the frame and duration caps, and de-lace to the frames written.
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+std::vector<RecordedFrame> AudioFrames(const std::vector<size_t> &sizes, const std::vector<int64_t> &times_ms)
+{
+    std::vector<RecordedFrame> frames;
+    for (size_t i = 0; i < sizes.size(); ++i) {
+        RecordedFrame r;
+        r.track = 2;
+        r.timecode_ns = times_ms[i] * 1000000;
+        r.keyframe = true;
+        r.bytes = Pattern(sizes[i], static_cast<uint8_t>(i));
+        frames.push_back(r);
+    }
+    return frames;
+}
+
+std::vector<uint8_t> MuxAudio(const MkvMuxerOptions &opts, const std::vector<RecordedFrame> &input)
+{
+    MkvMemoryWriter writer;
+    MkvMuxer muxer(opts);
+    muxer.SetWriter(&writer);
+    CHECK(muxer.AddTrack(AvTracks()[1]));
+    CHECK(muxer.BeginSegment(MkvInfo()));
+    for (const auto &r : input) {
+        MkvFrame frame;
+        frame.track_number = r.track;
+        frame.timecode_ns = r.timecode_ns;
+        frame.keyframe = true;
+        frame.data = r.bytes.data();
+        frame.size = r.bytes.size();
+        CHECK(muxer.WriteFrame(frame));
+    }
+    CHECK(muxer.EndSegment());
+    return writer.Data();
+}
+
+// Lacing flags and frame counts of the SimpleBlocks in file
+std::vector<std::pair<uint8_t, size_t>> Laces(const std::vector<uint8_t> &file)
+{
+    std::vector<std::pair<uint8_t, size_t>> out;
+    for (const auto &b : ElementsOf(file, kSimpleBlockId)) {
+        uint8_t lacing = file[b.data + 3] & 0x06;
+        out.emplace_back(lacing, lacing == 0 ? 1 : file[b.data + 4] + 1u);
+    }
+    return out;
+}
+
+} // namespace
+
+int main()
+{
+    MkvMuxerOptions opts;
+    opts.enable_lacing = true;
+    opts.max_lace_frames = 4;
+
+    // One lace of each kind
+    auto input = AudioFrames({100, 100, 100, 100, 10, 20, 30, 40, 1000, 1001, 1002, 1003},
+                             {0, 20, 40, 60, 80, 100, 120, 140, 160, 180, 200, 220});
+    auto out = MuxAudio(opts, input);
+    CHECK((Laces(out) == std::vector<std::pair<uint8_t, size_t>>{{0x04, 4}, {0x02, 4}, {0x06, 4}}));
+    for (size_t cut = 1; cut < out.size(); cut += 5) {
+        CHECK(SameContent(DemuxPieces(out, {cut}, MkvOutputMode::kConverted)->frames, input));
+    }
+
+    // A gap in the timing ends the lace; so does the duration cap
+    input = AudioFrames({50, 50, 50, 50, 50, 50}, {0, 20, 40, 100, 120, 140});
+    out = MuxAudio(opts, input);
+    CHECK((Laces(out) == std::vector<std::pair<uint8_t, size_t>>{{0x04, 3}, {0x04, 3}}));
+    CHECK(SameContent(DemuxPieces(out, {}, MkvOutputMode::kConverted)->frames, input));
+    opts.max_lace_duration_ms = 40;
+    out = MuxAudio(opts, input);
+    CHECK((Laces(out) == std::vector<std::pair<uint8_t, size_t>>{{0x04, 2}, {0x00, 1}, {0x04, 2}, {0x00, 1}}));
+    CHECK(SameContent(DemuxPieces(out, {}, MkvOutputMode::kConverted)->frames, input));
+
+    // Laced audio among video blocks: 20 ms audio frames, 40 ms video frames
+    opts.max_lace_duration_ms = 100;
+    std::vector<RecordedFrame> av;
+    for (int64_t ms = 0; ms < 2000; ms += 20) {
+        if (ms % 40 == 0) {
+            RecordedFrame video;
+            video.track = 1;
+            video.timecode_ns = ms * 1000000;
+            video.keyframe = ms % 400 == 0;
+            video.bytes = Pattern(200, static_cast<uint8_t>(ms / 40));
+            av.push_back(video);
+        }
+        auto audio = AudioFrames({30 + static_cast<size_t>(ms / 20 % 3)}, {ms});
+        av.push_back(audio[0]);
+    }
+    MkvMemoryWriter writer;
+    MkvMuxer muxer(opts);
+    muxer.SetWriter(&writer);
+    for (const auto &track : AvTracks()) {
+        CHECK(muxer.AddTrack(track));
+    }
+    CHECK(muxer.BeginSegment(MkvInfo()));
+    for (const auto &r : av) {
+        MkvFrame frame;
+        frame.track_number = r.track;
+        frame.timecode_ns = r.timecode_ns;
+        frame.keyframe = r.keyframe;
+        frame.data = r.bytes.data();
+        frame.size = r.bytes.size();
+        CHECK(muxer.WriteFrame(frame));
+    }
+    CHECK(muxer.EndSegment());
+    out = writer.Data();
+    CHECK(ElementsOf(out, kSimpleBlockId).size() <= 50 + 100 / 4 + 5);
+    auto back = DemuxPieces(out, {}, MkvOutputMode::kConverted);
+    CHECK_EQ(back->errors, 0);
+    auto by_time = [](std::vector<RecordedFrame> frames) {
+        std::stable_sort(frames.begin(), frames.end(), [](const RecordedFrame &a, const RecordedFrame &b) {
+            return a.timecode_ns != b.timecode_ns ? a.timecode_ns < b.timecode_ns : a.track < b.track;
+        });
+        return frames;
+    };
+    CHECK(SameContent(by_time(back->frames), by_time(av)));
+    return Result("test_mux_lacing");
+}
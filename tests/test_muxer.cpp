@@ -0,0 +1,183 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// MkvMuxer Clusters and SimpleBlocks: output demuxes to the frames written, Clusters are
+// cut by duration and size, sizes are back-patched (unknown on outputs that cannot
+// seek), and payloads reach the writer without being copied.
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+// Memory output that cannot seek and remembers where every slice pointed
+class RecordingWriter final : public IMkvWriter {
+public:
+    bool Write(const MkvSlice *slices, size_t count) override
+    {
+        for (size_t i = 0; i < count; ++i) {
+            pointers.push_back(slices[i].first);
+            data.insert(data.end(), slices[i].first, slices[i].first + slices[i].second);
+        }
+        return true;
+    }
+
+    uint64_t Position() const override { return data.size(); }
+
+    std::vector<uint8_t> data;
+    std::vector<const uint8_t *> pointers;
+};
+
+std::vector<uint64_t> ClusterTimecodes(const std::vector<uint8_t> &file)
+{
+    std::vector<uint64_t> out;
+    for (const auto &e : ElementsOf(file, kClusterTimecodeId)) {
+        out.push_back(LoadBE(file.data() + e.data, static_cast<size_t>(e.size), static_cast<size_t>(e.size)));
+    }
+    return out;
+}
+
+// Write frames (tracks from a demuxed file) into a new file
+std::vector<uint8_t> Remux(const FrameRecorder &demuxed)
+{
+    MkvMemoryWriter writer;
+    MkvMuxer muxer(MkvMuxerOptions{});
+    muxer.SetWriter(&writer);
+    for (const auto &track : demuxed.tracks) {
+        CHECK(muxer.AddTrack(track));
+    }
+    CHECK(muxer.BeginSegment(demuxed.info));
+    for (const auto &r : demuxed.frames) {
+        MkvFrame frame;
+        frame.track_number = r.track;
+        frame.timecode_ns = r.timecode_ns;
+        frame.duration_ns = r.duration_ns;
+        frame.keyframe = r.keyframe;
+        frame.references_ns = r.references_ns;
+        frame.data = r.bytes.data();
+        frame.size = r.bytes.size();
+        CHECK(muxer.WriteFrame(frame));
+    }
+    CHECK(muxer.EndSegment());
+    return writer.Data();
+}
+
+void TestRoundTrip()
+{
+    MkvMuxerOptions opts;
+    opts.cluster_duration_ms = 400;
+    std::vector<RecordedFrame> input;
+    auto out = MuxAvFile(opts, 3000, input);
+
+    auto segments = ElementsOf(out, kSegmentId);
+    CHECK_EQ(segments.size(), 1u);
+    if (segments.size() == 1) {
+        CHECK_EQ(segments[0].data + segments[0].size, out.size());
+    }
+    CHECK(ClusterTimecodes(out) == std::vector<uint64_t>({0, 400, 800, 1200, 1600, 2000, 2400, 2800}));
+    CHECK_EQ(ElementsOf(out, kSimpleBlockId).size(), input.size());
+
+    auto back = DemuxPieces(out, {});
+    CHECK_EQ(back->errors, 0);
+    CHECK(SameContent(back->frames, input));
+    CHECK_EQ(back->tracks.size(), 2u);
+    if (back->tracks.size() == 2) {
+        CHECK_EQ(back->tracks[0].codec_id, "V_VP9");
+        CHECK_EQ(back->tracks[0].width, 320u);
+        CHECK_EQ(back->tracks[1].sample_rate, 48000u);
+        CHECK_EQ(back->tracks[1].metadata["default_duration_ns"], "20000000");
+    }
+
+    // Size limit: a Cluster is closed once it holds cluster_size_bytes
+    opts.cluster_size_bytes = 1000;
+    input.clear();
+    out = MuxAvFile(opts, 3000, input);
+    auto clusters = ElementsOf(out, kClusterId);
+    CHECK(clusters.size() > 10);
+    for (const auto &c : clusters) {
+        CHECK(c.size < 1000 + 200);
+    }
+    CHECK(SameContent(DemuxPieces(out, {})->frames, input));
+}
+
+// BlockGroup frames are written as SimpleBlocks with the same timing and flags
+void TestBlockGroups()
+{
+    FixtureBuilder fb;
+    fb.BeginCluster(0);
+    fb.SimpleBlock(1, 0, true, Pattern(50, 1));
+    fb.BlockGroup(1, 40, 40, -40, Pattern(30, 2));
+    fb.SimpleBlock(2, 50, true, Pattern(8, 3));
+    fb.BlockGroup(1, 80, 40, 0, Pattern(20, 4));
+    fb.EndCluster();
+    auto source = DemuxPieces(fb.Finish(), {});
+    CHECK_EQ(source->frames.size(), 4u);
+
+    auto out = Remux(*source);
+    CHECK(ElementsOf(out, kBlockGroupId).empty());
+    CHECK_EQ(ElementsOf(out, kSimpleBlockId).size(), 4u);
+    auto back = DemuxPieces(out, {});
+    CHECK_EQ(back->errors, 0);
+    CHECK(SameContent(back->frames, source->frames));
+}
+
+// A writer without WriteAt() keeps unknown sizes; payload slices are the caller's buffers
+void TestUnseekable()
+{
+    RecordingWriter writer;
+    MkvMuxer muxer(MkvMuxerOptions{});
+    muxer.SetWriter(&writer);
+    for (const auto &track : AvTracks()) {
+        CHECK(muxer.AddTrack(track));
+    }
+    CHECK(muxer.BeginSegment(MkvInfo()));
+    std::vector<std::vector<uint8_t>> payloads;
+    for (int i = 0; i < 100; ++i) {
+        payloads.push_back(Pattern(64 + static_cast<size_t>(i), static_cast<uint8_t>(i)));
+    }
+    std::vector<RecordedFrame> input;
+    for (int i = 0; i < 100; ++i) {
+        MkvFrame frame;
+        frame.track_number = i % 2 == 0 ? 1 : 2;
+        frame.timecode_ns = i * 20000000LL;
+        frame.keyframe = frame.track_number == 2 || i % 20 == 0;
+        frame.data = payloads[i].data();
+        frame.size = payloads[i].size();
+        CHECK(muxer.WriteFrame(frame));
+        input.push_back(Record(frame));
+    }
+    CHECK(muxer.EndSegment());
+
+    for (const auto &payload : payloads) {
+        CHECK(std::find(writer.pointers.begin(), writer.pointers.end(), payload.data()) != writer.pointers.end());
+    }
+    // Segment and Cluster sizes stay the 8-byte unknown size
+    auto segments = ElementsOf(writer.data, kSegmentId);
+    auto clusters = ElementsOf(writer.data, kClusterId);
+    CHECK_EQ(segments.size(), 1u);
+    CHECK(!clusters.empty());
+    for (const auto &e : {segments.front(), clusters.front()}) {
+        CHECK_EQ(e.data - e.offset, 4u + 8u);
+        CHECK_EQ(e.size, (1ULL << 56) - 1);
+    }
+    auto back = DemuxPieces(writer.data, {});
+    CHECK_EQ(back->errors, 0);
+    CHECK(SameContent(back->frames, input));
+}
+
+} // namespace
+
+int main()
+{
+    TestRoundTrip();
+    TestBlockGroups();
+    TestUnseekable();
+    return Result("test_muxer");
+}
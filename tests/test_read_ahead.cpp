@@ -0,0 +1,181 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// MkvReadAhead: buffers cover the range in order at their offsets, the reader stays
+// at most depth buffers ahead, and the stats tell a slow source (stalls) from a slow
+// parser (reader idle).
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "lmmkv/mkv_read_ahead.h"
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+// Memory source counting reads, optionally slow or capped per read
+class SlowSource final : public IByteSource {
+public:
+    SlowSource(const std::vector<uint8_t> &data, int delay_ms, size_t max_read = SIZE_MAX)
+        : data_(data), delayMs_(delay_ms), maxRead_(max_read)
+    {
+    }
+
+    size_t ReadAt(uint64_t offset, uint8_t *dst, size_t size) override
+    {
+        if (delayMs_ > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(delayMs_));
+        }
+        ++reads;
+        if (offset >= data_.size() || offset >= fail_at) {
+            return 0;
+        }
+        size_t n = std::min({size, maxRead_, static_cast<size_t>(data_.size() - offset)});
+        std::copy(data_.begin() + offset, data_.begin() + offset + n, dst);
+        return n;
+    }
+
+    uint64_t Size() const override { return data_.size(); }
+
+    std::atomic<int> reads{0};
+    uint64_t fail_at = UINT64_MAX;
+
+private:
+    const std::vector<uint8_t> &data_;
+    int delayMs_;
+    size_t maxRead_;
+};
+
+// Drain reader from Start(offset, end), checking that buffers are contiguous and placed
+// at Offset(); returns the bytes read
+std::vector<uint8_t> Drain(MkvReadAhead &reader, uint64_t offset, uint64_t end, size_t max_buffer,
+                           int parse_ms = 0, const std::function<void(int)> &on_buffer = nullptr)
+{
+    std::vector<uint8_t> out;
+    CHECK(reader.Start(offset, end));
+    const uint8_t *data = nullptr;
+    size_t size = 0;
+    int buffers = 0;
+    while (reader.Next(data, size)) {
+        ++buffers;
+        CHECK_EQ(reader.Offset(), offset + out.size());
+        CHECK(size > 0 && size <= max_buffer);
+        CHECK_EQ(reinterpret_cast<uintptr_t>(data) % 4096, 0u);
+        out.insert(out.end(), data, data + size);
+        if (on_buffer) {
+            on_buffer(buffers);
+        }
+        if (parse_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(parse_ms));
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+int main()
+{
+    auto data = Pattern(100000, 3);
+    auto slice = [&data](uint64_t from, uint64_t to) {
+        return std::vector<uint8_t>(data.begin() + from, data.begin() + std::min<uint64_t>(to, data.size()));
+    };
+
+    // Buffer size rounded up to the alignment; ranges, restarts and short reads
+    MkvReadAheadOptions options;
+    options.buffer_size = 5000;
+    options.depth = 3;
+    {
+        auto source = std::make_shared<SlowSource>(data, 0);
+        MkvReadAhead reader(source, options);
+        CHECK(Drain(reader, 0, UINT64_MAX, 8192) == data);
+        auto stats = reader.Stats();
+        CHECK_EQ(stats.bytes_read, data.size());
+        CHECK_EQ(stats.buffers, (data.size() + 8191) / 8192);
+        CHECK(Drain(reader, 12345, 54321, 8192) == slice(12345, 54321));
+        CHECK(Drain(reader, 99000, 200000, 8192) == slice(99000, 200000));
+        CHECK(Drain(reader, data.size(), UINT64_MAX, 8192).empty());
+    }
+    {
+        auto source = std::make_shared<SlowSource>(data, 0, 1000);
+        MkvReadAhead reader(source, options);
+        CHECK(Drain(reader, 777, UINT64_MAX, 1000) == slice(777, data.size()));
+    }
+
+    // A failed read ends the range early
+    {
+        auto source = std::make_shared<SlowSource>(data, 0);
+        source->fail_at = 40000;
+        MkvReadAhead reader(source, options);
+        auto out = Drain(reader, 0, UINT64_MAX, 8192);
+        CHECK(out.size() < 40000 + 8192 && out == slice(0, out.size()));
+    }
+
+    // Slow parser: the reader fills every buffer but the one being parsed, never more,
+    // and then waits; Next() does not stall once it is ahead
+    for (size_t depth : {2, 4}) {
+        options.depth = depth;
+        auto source = std::make_shared<SlowSource>(data, 0);
+        MkvReadAhead reader(source, options);
+        int max_ahead = 0;
+        auto on_buffer = [&](int buffers) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            max_ahead = std::max(max_ahead, source->reads.load() - (buffers - 1));
+        };
+        CHECK(Drain(reader, 0, 60000, 8192, 1, on_buffer) == slice(0, 60000));
+        CHECK_EQ(max_ahead, static_cast<int>(depth));
+        auto stats = reader.Stats();
+        CHECK(stats.stalls <= 1);
+        CHECK(stats.reader_idle_ns > 0);
+    }
+
+    // Slow source: the parser waits for every buffer and the stall time shows it
+    {
+        options.depth = 2;
+        auto source = std::make_shared<SlowSource>(data, 3);
+        MkvReadAhead reader(source, options);
+        CHECK(Drain(reader, 0, 40000, 8192) == slice(0, 40000));
+        auto stats = reader.Stats();
+        CHECK(stats.stalls >= 4);
+        CHECK(stats.stall_ns >= 4 * 2000000);
+        CHECK(stats.read_ns >= 5 * 3000000);
+    }
+
+    // Demuxing through the read-ahead matches one Consume()
+    FixtureBuilder fb;
+    for (int c = 0; c < 30; ++c) {
+        fb.BeginCluster(static_cast<uint64_t>(c * 200));
+        for (int i = 0; i < 5; ++i) {
+            fb.SimpleBlock(1, static_cast<int16_t>(i * 40), i == 0, Pattern(700 + 31 * i, static_cast<uint8_t>(c)));
+        }
+        fb.EndCluster();
+    }
+    auto file = fb.Finish();
+    auto ref = DemuxPieces(file, {});
+    auto recorder = std::make_shared<FrameRecorder>();
+    MkvDemuxer demuxer;
+    demuxer.SetListener(recorder);
+    demuxer.SetOutputMode(MkvOutputMode::kPassthrough);
+    demuxer.Start();
+    options.depth = 3;
+    MkvReadAhead reader(std::make_shared<SlowSource>(file, 0), options);
+    reader.Start(0);
+    const uint8_t *chunk = nullptr;
+    size_t size = 0;
+    while (reader.Next(chunk, size)) {
+        demuxer.Consume(chunk, size);
+    }
+    demuxer.Stop();
+    CHECK(recorder->frames == ref->frames);
+    return Result("test_read_ahead");
+}
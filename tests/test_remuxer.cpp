@@ -0,0 +1,241 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// MkvRemuxer trim and concatenation: the kept frames, shifted so the output starts at
+// zero and each input continues where the previous one ended.
+
+#include <algorithm>
+#include <cmath>
+
+#include "lmmkv/mkv_remuxer.h"
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+// Frames of input in [from_ns, to_ns), shifted by shift_ns
+std::vector<RecordedFrame> Shifted(const std::vector<RecordedFrame> &input, int64_t from_ns, int64_t to_ns,
+                                   int64_t shift_ns)
+{
+    std::vector<RecordedFrame> out;
+    for (auto r : input) {
+        if (r.timecode_ns >= from_ns && r.timecode_ns < to_ns) {
+            r.timecode_ns += shift_ns;
+            out.push_back(r);
+        }
+    }
+    return out;
+}
+
+// Output frames in timestamp order (copied and re-serialised Clusters keep file order
+// within a track, but tracks may interleave differently at the cuts)
+std::vector<RecordedFrame> Sorted(std::vector<RecordedFrame> frames)
+{
+    std::stable_sort(frames.begin(), frames.end(), [](const RecordedFrame &a, const RecordedFrame &b) {
+        return a.timecode_ns != b.timecode_ns ? a.timecode_ns < b.timecode_ns : a.track < b.track;
+    });
+    return frames;
+}
+
+// Audio only, 20 ms frames laced by four into 200 ms Clusters
+std::vector<uint8_t> MuxLacedAudio(std::vector<RecordedFrame> &input)
+{
+    MkvMuxerOptions opts;
+    opts.enable_lacing = true;
+    opts.max_lace_frames = 4;
+    opts.cluster_duration_ms = 200;
+    MkvMemoryWriter writer;
+    MkvMuxer muxer(opts);
+    muxer.SetWriter(&writer);
+    muxer.AddTrack(AvTracks()[1]);
+    muxer.BeginSegment(MkvInfo());
+    for (int64_t ms = 0; ms < 1000; ms += 20) {
+        RecordedFrame r;
+        r.track = 2;
+        r.timecode_ns = ms * 1000000;
+        r.keyframe = true;
+        r.bytes = Pattern(40, static_cast<uint8_t>(ms / 20));
+        input.push_back(r);
+
+        MkvFrame frame;
+        frame.track_number = r.track;
+        frame.timecode_ns = r.timecode_ns;
+        frame.keyframe = true;
+        frame.data = input.back().bytes.data();
+        frame.size = input.back().bytes.size();
+        muxer.WriteFrame(frame);
+    }
+    muxer.EndSegment();
+    return writer.Data();
+}
+
+size_t LacedBlocks(const std::vector<uint8_t> &file)
+{
+    size_t laced = 0;
+    for (const auto &b : ElementsOf(file, kSimpleBlockId)) {
+        laced += (file[b.data + 3] & 0x06) != 0 ? 1 : 0;
+    }
+    return laced;
+}
+
+// Memory output recording the source ranges stream-copied into it
+class CopyWriter final : public IMkvWriter {
+public:
+    bool Write(const MkvSlice *slices, size_t count) override { return out.Write(slices, count); }
+    uint64_t Position() const override { return out.Position(); }
+    bool WriteAt(uint64_t offset, const uint8_t *data, size_t size) override
+    {
+        return out.WriteAt(offset, data, size);
+    }
+    bool WriteFrom(IByteSource &source, uint64_t offset, uint64_t size) override
+    {
+        copies.emplace_back(offset, offset + size);
+        return IMkvWriter::WriteFrom(source, offset, size);
+    }
+
+    MkvMemoryWriter out;
+    std::vector<std::pair<uint64_t, uint64_t>> copies;
+};
+
+bool CopiedUpTo(const CopyWriter &writer, uint64_t end)
+{
+    return std::any_of(writer.copies.begin(), writer.copies.end(),
+                       [end](const std::pair<uint64_t, uint64_t> &range) { return range.second == end; });
+}
+
+MkvMuxerOptions OutputOptions()
+{
+    MkvMuxerOptions opts;
+    opts.write_cues = true;
+    opts.write_seek_head = true;
+    return opts;
+}
+
+} // namespace
+
+int main()
+{
+    MkvMuxerOptions opts = OutputOptions();
+    opts.cluster_duration_ms = 400;
+    std::vector<RecordedFrame> input;
+    auto file = MuxAvFile(opts, 3000, input);
+    auto source = std::make_shared<MemoryByteSource>(file.data(), file.size());
+
+    // Trim [1.0 s, 2.0 s): starts at the keyframe at 0.8 s, audio before it is dropped
+    {
+        MkvRemuxer remuxer(OutputOptions());
+        CHECK(remuxer.AddInput(source, 1000000000, 2000000000));
+        MkvMemoryWriter writer;
+        CHECK(remuxer.Run(&writer));
+        auto out = DemuxPieces(writer.Data(), {});
+        CHECK_EQ(out->errors, 0);
+        CHECK(SameContent(Sorted(out->frames), Shifted(input, 800000000, 2000000000, -800000000)));
+        CHECK(std::fabs(out->info.duration_seconds - 1.2) < 1e-6);
+    }
+
+    // The trimmed range, then the whole file starting where the range ends (1.2 s)
+    {
+        MkvRemuxer remuxer(OutputOptions());
+        CHECK(remuxer.AddInput(source, 1000000000, 2000000000));
+        CHECK(remuxer.AddInput(source));
+        MkvMemoryWriter writer;
+        CHECK(remuxer.Run(&writer));
+        auto out = DemuxPieces(writer.Data(), {});
+        CHECK_EQ(out->errors, 0);
+        auto expected = Shifted(input, 800000000, 2000000000, -800000000);
+        auto second = Shifted(input, 0, 3000000000, 1200000000);
+        expected.insert(expected.end(), second.begin(), second.end());
+        CHECK(SameContent(Sorted(out->frames), Sorted(expected)));
+        CHECK(std::fabs(out->info.duration_seconds - 4.2) < 1e-6);
+    }
+
+    // A range that is not a keyframe Cluster boundary at either end, with its end past
+    // the file's
+    {
+        MkvRemuxer remuxer(OutputOptions());
+        CHECK(remuxer.AddInput(source, 1500000000, 5000000000));
+        MkvMemoryWriter writer;
+        CHECK(remuxer.Run(&writer));
+        auto out = DemuxPieces(writer.Data(), {});
+        CHECK(SameContent(Sorted(out->frames), Shifted(input, 1200000000, 3000000000, -1200000000)));
+    }
+
+    // No Cues and one GOP over several Clusters: the keyframe search walks back to the
+    // first Cluster, which is then demuxed again, so ranges reach the demuxer out of
+    // file order
+    MkvMuxerOptions plain;
+    plain.cluster_duration_ms = 1000;
+    std::vector<RecordedFrame> long_gop;
+    auto data = MuxAvFile(plain, 6000, long_gop, 6000);
+    CHECK(ElementsOf(data, kCuesId).empty());
+    for (int64_t start_ns : {4500000000LL, 5500000000LL}) {
+        MkvRemuxer remuxer(plain);
+        CHECK(remuxer.AddInput(std::make_shared<MemoryByteSource>(data.data(), data.size()), start_ns));
+        MkvMemoryWriter writer;
+        CHECK(remuxer.Run(&writer));
+        auto out = DemuxPieces(writer.Data(), {});
+        CHECK_EQ(out->errors, 0);
+        CHECK(SameContent(Sorted(out->frames), long_gop));
+    }
+
+    // Copied Clusters keep their laced blocks, so FlagLacing must not be written as 0
+    // even though the output options do not lace
+    std::vector<RecordedFrame> audio;
+    auto laced = MuxLacedAudio(audio);
+    CHECK(LacedBlocks(laced) > 0);
+    {
+        MkvRemuxer remuxer(OutputOptions());
+        CHECK(remuxer.AddInput(std::make_shared<MemoryByteSource>(laced.data(), laced.size())));
+        MkvMemoryWriter writer;
+        CHECK(remuxer.Run(&writer));
+        const auto &out = writer.Data();
+        CHECK(LacedBlocks(out) > 0);
+        for (const auto &flag : ElementsOf(out, kFlagLacingId)) {
+            CHECK(flag.size == 1 && out[flag.data] == 1);
+        }
+        auto demuxed = DemuxPieces(out, {}, MkvOutputMode::kConverted);
+        CHECK_EQ(demuxed->errors, 0);
+        CHECK(SameContent(demuxed->frames, audio));
+    }
+
+    // The last Cluster of an input kept to its end is copied too, ending at the input's
+    // Duration, or without one where its last lace ends
+    {
+        MkvRemuxer remuxer(OutputOptions());
+        CHECK(remuxer.AddInput(source));
+        CopyWriter writer;
+        CHECK(remuxer.Run(&writer));
+        auto last = ElementsOf(file, kClusterId).back();
+        CHECK(CopiedUpTo(writer, last.data + last.size));
+        auto out = DemuxPieces(writer.out.Data(), {});
+        CHECK(SameContent(out->frames, input));
+        CHECK(std::fabs(out->info.duration_seconds - 3.0) < 1e-6);
+    }
+    auto duration = ElementsOf(laced, kDurationId);
+    CHECK_EQ(duration.size(), 1u);
+    std::fill(laced.begin() + duration[0].data, laced.begin() + duration[0].data + duration[0].size, 0);
+    {
+        MkvRemuxer remuxer(OutputOptions());
+        auto laced_source = std::make_shared<MemoryByteSource>(laced.data(), laced.size());
+        CHECK(remuxer.AddInput(laced_source));
+        CHECK(remuxer.AddInput(laced_source));
+        CopyWriter writer;
+        CHECK(remuxer.Run(&writer));
+        auto last = ElementsOf(laced, kClusterId).back();
+        CHECK(CopiedUpTo(writer, last.data + last.size));
+        auto out = DemuxPieces(writer.out.Data(), {}, MkvOutputMode::kConverted);
+        auto expected = audio;
+        auto second = Shifted(audio, 0, 1000000000, 1000000000);
+        expected.insert(expected.end(), second.begin(), second.end());
+        CHECK(SameContent(out->frames, expected));
+        CHECK(std::fabs(out->info.duration_seconds - 2.0) < 1e-6);
+    }
+    return Result("test_remuxer");
+}
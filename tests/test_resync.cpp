@@ -0,0 +1,100 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+// Resync over corrupt bytes inside a Cluster: the same frames and one kMkvErrorResync
+// for every input split, in push (plain and batched) and pull mode.
+
+#include "test_util.h"
+
+using namespace lmshao::lmmkv;
+using namespace lmshao::lmmkv::test;
+
+namespace {
+
+struct Expected {
+    uint64_t track;
+    int64_t timecode_ns;
+    std::vector<uint8_t> bytes;
+};
+
+// Six 200 ms Clusters of video and 3-byte audio frames. Cluster 2 ends in bytes that
+// are no element, then a false Cluster ID whose Void never fits in the probe window;
+// the real Cluster 3 starts right after it, so a read that stops inside the false
+// candidate leaves Cluster 3's header and first block in the resync hold buffer.
+std::vector<uint8_t> BuildCorruptFile(std::vector<Expected> &expected)
+{
+    FixtureBuilder fb;
+    for (int c = 0; c < 6; ++c) {
+        int64_t base_ms = c * 200;
+        fb.BeginCluster(static_cast<uint64_t>(base_ms));
+        if (c == 3) {
+            // Small first block, so it lies wholly inside the held bytes
+            auto audio = Pattern(3, static_cast<uint8_t>(c * 16));
+            fb.SimpleBlock(2, 0, true, audio);
+            expected.push_back({2, base_ms * 1000000, audio});
+        }
+        for (int i = 0; i < 5; ++i) {
+            auto video = Pattern(40 + 10 * i, static_cast<uint8_t>(c * 16 + i));
+            fb.SimpleBlock(1, static_cast<int16_t>(i * 40), i == 0, video);
+            expected.push_back({1, (base_ms + i * 40) * 1000000, video});
+            auto audio = Pattern(3, static_cast<uint8_t>(c * 16 + i + 8));
+            fb.SimpleBlock(2, static_cast<int16_t>(i * 40 + 20), true, audio);
+            expected.push_back({2, (base_ms + i * 40 + 20) * 1000000, audio});
+            if (c == 2 && i == 2) {
+                fb.Raw({0x00, 0x00, 0x00, 0x55, 0x55});
+                fb.Raw({0x1F, 0x43, 0xB6, 0x75, 0x9F, 0xEC, 0xE4});
+                break;
+            }
+        }
+        fb.EndCluster();
+    }
+    return fb.Finish();
+}
+
+bool Same(const FrameRecorder &a, const FrameRecorder &b)
+{
+    return a.frames == b.frames && a.resyncs == b.resyncs && a.errors == b.errors;
+}
+
+} // namespace
+
+int main()
+{
+    std::vector<Expected> expected;
+    auto file = BuildCorruptFile(expected);
+
+    auto ref = DemuxPieces(file, {});
+    CHECK_EQ(ref->resyncs, 1);
+    CHECK_EQ(ref->errors, 0);
+    CHECK_EQ(ref->frames.size(), expected.size());
+    for (size_t i = 0; i < std::min(ref->frames.size(), expected.size()); ++i) {
+        CHECK_EQ(ref->frames[i].track, expected[i].track);
+        CHECK_EQ(ref->frames[i].timecode_ns, expected[i].timecode_ns);
+        CHECK(ref->frames[i].bytes == expected[i].bytes);
+    }
+
+    // Two pieces, split at every byte; batched frames outlive the block they were parsed in
+    for (size_t cut = 1; cut < file.size(); ++cut) {
+        CHECK(Same(*DemuxPieces(file, {cut}), *ref));
+        CHECK(Same(*DemuxPieces(file, {cut}, MkvOutputMode::kPassthrough, 4), *ref));
+    }
+    for (size_t chunk = 1; chunk <= 80; ++chunk) {
+        CHECK(Same(*DemuxChunked(file, chunk), *ref));
+        CHECK(Same(*DemuxChunked(file, chunk, 4), *ref));
+    }
+
+    // Pull mode with reads that stop at every byte, and with small reads
+    CHECK(Same(*DemuxPull(std::make_shared<MemoryByteSource>(file.data(), file.size())), *ref));
+    for (size_t boundary = 1; boundary < file.size(); ++boundary) {
+        CHECK(Same(*DemuxPull(std::make_shared<ShortReadSource>(file, file.size(), boundary)), *ref));
+    }
+    for (size_t max_read = 1; max_read <= 80; ++max_read) {
+        CHECK(Same(*DemuxPull(std::make_shared<ShortReadSource>(file, max_read, 0)), *ref));
+    }
+    return Result("test_resync");
+}
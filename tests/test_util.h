@@ -0,0 +1,459 @@
+/**
+ * @author SHAO Liming <lmshao@163.com>
+ * @copyright Copyright (c) 2025 SHAO Liming
+ * @license MIT
+ *
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef LMSHAO_LMMKV_TEST_UTIL_H
+#define LMSHAO_LMMKV_TEST_UTIL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ebml_writer.h"
+#include "lmmkv/mkv_byte_source.h"
+#include "lmmkv/mkv_demuxer.h"
+#include "lmmkv/mkv_listeners.h"
+#include "lmmkv/mkv_muxer.h"
+#include "lmmkv/mkv_writer.h"
+
+namespace lmshao::lmmkv::test {
+
+inline int &Failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(cond)                                                                                                    \
+    do {                                                                                                               \
+        if (!(cond)) {                                                                                                 \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond);                             \
+            ++lmshao::lmmkv::test::Failures();                                                                         \
+        }                                                                                                              \
+    } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+
+inline int Result(const char *name)
+{
+    if (Failures() != 0) {
+        std::fprintf(stderr, "%s: %d check(s) failed\n", name, Failures());
+        return 1;
+    }
+    std::printf("%s: passed\n", name);
+    return 0;
+}
+
+// Frame as seen by a listener, with the payload copied out of the demuxer's buffers
+struct RecordedFrame {
+    uint64_t track = 0;
+    int64_t timecode_ns = 0;
+    int64_t duration_ns = 0;
+    bool keyframe = false;
+    std::vector<int64_t> references_ns;
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> laces; // slice sizes (passthrough: one per lace)
+
+    bool operator==(const RecordedFrame &o) const
+    {
+        return track == o.track && timecode_ns == o.timecode_ns && duration_ns == o.duration_ns &&
+               keyframe == o.keyframe && references_ns == o.references_ns && bytes == o.bytes && laces == o.laces;
+    }
+};
+
+inline RecordedFrame Record(const MkvFrame &frame)
+{
+    RecordedFrame r;
+    r.track = frame.track_number;
+    r.timecode_ns = frame.timecode_ns;
+    r.duration_ns = frame.duration_ns;
+    r.keyframe = frame.keyframe;
+    r.references_ns = frame.references_ns;
+    if (frame.data != nullptr) {
+        r.bytes.assign(frame.data, frame.data + frame.size);
+    }
+    for (const auto &s : frame.slices) {
+        if (frame.data == nullptr) {
+            r.bytes.insert(r.bytes.end(), s.first, s.first + s.second);
+        }
+        r.laces.push_back(s.second);
+    }
+    return r;
+}
+
+class FrameRecorder : public IMkvDemuxListener {
+public:
+    void OnInfo(const MkvInfo &info) override { this->info = info; }
+    void OnTrack(const MkvTrackInfo &track) override { tracks.push_back(track); }
+    void OnFrame(const MkvFrame &frame) override { frames.push_back(Record(frame)); }
+    void OnFrames(const MkvFrame *frames, size_t count) override
+    {
+        batches.push_back(count);
+        IMkvDemuxListener::OnFrames(frames, count);
+    }
+    void OnEndOfStream() override { ended = true; }
+    void OnError(int code, const std::string &msg) override
+    {
+        (void)msg;
+        if (code == kMkvErrorResync) {
+            ++resyncs;
+        } else {
+            ++errors;
+        }
+    }
+
+    MkvInfo info;
+    std::vector<MkvTrackInfo> tracks;
+    std::vector<RecordedFrame> frames;
+    std::vector<size_t> batches; // OnFrames() counts
+    int resyncs = 0;
+    int errors = 0;
+    bool ended = false;
+};
+
+// Demux file fed to Consume() in pieces ending at cuts (ascending), then the rest
+inline std::shared_ptr<FrameRecorder> DemuxPieces(const std::vector<uint8_t> &file, const std::vector<size_t> &cuts,
+                                                  MkvOutputMode mode = MkvOutputMode::kPassthrough, size_t batch = 0)
+{
+    auto recorder = std::make_shared<FrameRecorder>();
+    MkvDemuxer demuxer;
+    demuxer.SetListener(recorder);
+    demuxer.SetOutputMode(mode);
+    demuxer.SetFrameBatchSize(batch);
+    demuxer.Start();
+    size_t pos = 0;
+    for (size_t cut : cuts) {
+        demuxer.Consume(file.data() + pos, cut - pos);
+        pos = cut;
+    }
+    demuxer.Consume(file.data() + pos, file.size() - pos);
+    demuxer.Stop();
+    return recorder;
+}
+
+// Demux file in chunks of chunk bytes (a fresh copy each, so nothing outlives its call)
+inline std::shared_ptr<FrameRecorder> DemuxChunked(const std::vector<uint8_t> &file, size_t chunk, size_t batch = 0)
+{
+    auto recorder = std::make_shared<FrameRecorder>();
+    MkvDemuxer demuxer;
+    demuxer.SetListener(recorder);
+    demuxer.SetOutputMode(MkvOutputMode::kPassthrough);
+    demuxer.SetFrameBatchSize(batch);
+    demuxer.Start();
+    for (size_t pos = 0; pos < file.size(); pos += chunk) {
+        std::vector<uint8_t> piece(file.begin() + pos, file.begin() + std::min(file.size(), pos + chunk));
+        demuxer.Consume(piece.data(), piece.size());
+    }
+    demuxer.Stop();
+    return recorder;
+}
+
+// Byte source whose reads return at most max_read bytes and stop short at boundary
+// once armed; DemuxPull() arms it after Open(), whose header reads are served whole
+class ShortReadSource final : public IByteSource {
+public:
+    ShortReadSource(const std::vector<uint8_t> &data, size_t max_read, uint64_t boundary)
+        : data_(data), maxRead_(max_read), boundary_(boundary)
+    {
+    }
+
+    void Arm() { armed_ = true; }
+
+    size_t ReadAt(uint64_t offset, uint8_t *dst, size_t size) override
+    {
+        if (offset >= data_.size()) {
+            return 0;
+        }
+        size_t n = std::min<size_t>(size, static_cast<size_t>(data_.size() - offset));
+        if (armed_) {
+            n = std::min(n, maxRead_);
+            if (offset < boundary_) {
+                n = std::min<size_t>(n, static_cast<size_t>(boundary_ - offset));
+            }
+        }
+        std::copy(data_.begin() + offset, data_.begin() + offset + n, dst);
+        return n;
+    }
+
+    uint64_t Size() const override { return data_.size(); }
+
+private:
+    const std::vector<uint8_t> &data_;
+    size_t maxRead_;
+    uint64_t boundary_;
+    bool armed_ = false;
+};
+
+// Open() the file and ReadPacket() every frame; frames go to the returned recorder
+inline std::shared_ptr<FrameRecorder> DemuxPull(const std::shared_ptr<IByteSource> &source)
+{
+    auto recorder = std::make_shared<FrameRecorder>();
+    MkvDemuxer demuxer;
+    demuxer.SetListener(recorder);
+    demuxer.SetOutputMode(MkvOutputMode::kPassthrough);
+    demuxer.Start();
+    if (demuxer.Open(source) < 0) {
+        ++recorder->errors;
+        return recorder;
+    }
+    if (auto short_reads = std::dynamic_pointer_cast<ShortReadSource>(source)) {
+        short_reads->Arm();
+    }
+    MkvPacket packet;
+    int res = 0;
+    while ((res = demuxer.ReadPacket(packet)) == 1) {
+        recorder->frames.push_back(Record(packet));
+    }
+    if (res < 0) {
+        ++recorder->errors;
+    }
+    demuxer.Stop();
+    return recorder;
+}
+
+// SimpleBlock or Block payload: track vint, relative timecode, flags, frame data
+inline std::vector<uint8_t> BlockBytes(uint64_t track, int16_t timecode, uint8_t flags,
+                                       const std::vector<uint8_t> &payload)
+{
+    std::vector<uint8_t> b = {static_cast<uint8_t>(0x80 | track), static_cast<uint8_t>(timecode >> 8),
+                              static_cast<uint8_t>(timecode), flags};
+    b.insert(b.end(), payload.begin(), payload.end());
+    return b;
+}
+
+inline std::vector<uint8_t> Pattern(size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> v(size);
+    for (size_t i = 0; i < size; ++i) {
+        v[i] = static_cast<uint8_t>(seed + i * 7);
+    }
+    return v;
+}
+
+// Element in a file, see ElementsOf()
+struct ElementSpan {
+    uint64_t offset = 0; // first byte of the header
+    uint64_t data = 0;   // first byte of the payload
+    uint64_t size = 0;
+};
+
+// Every element with the given ID, walking into Segment, SeekHead, Cluster and BlockGroup
+inline std::vector<ElementSpan> ElementsOf(const std::vector<uint8_t> &file, uint64_t id)
+{
+    std::vector<ElementSpan> found;
+    std::vector<uint64_t> ends = {file.size()};
+    size_t pos = 0;
+    while (!ends.empty()) {
+        if (pos >= ends.back()) {
+            pos = static_cast<size_t>(ends.back());
+            ends.pop_back();
+            continue;
+        }
+        uint64_t element_id = 0;
+        uint64_t size = 0;
+        size_t id_len = DecodeVint(file.data() + pos, file.size() - pos, true, element_id);
+        if (id_len == 0) {
+            break;
+        }
+        size_t size_len = DecodeVint(file.data() + pos + id_len, file.size() - pos - id_len, false, size);
+        if (size_len == 0) {
+            break;
+        }
+        ElementSpan span{pos, pos + id_len + size_len, size};
+        if (element_id == id) {
+            found.push_back(span);
+        }
+        if (element_id == kSegmentId || element_id == kSeekHeadId || element_id == kInfoId || element_id == kTracksId ||
+            element_id == kTrackEntryId || element_id == kClusterId || element_id == kBlockGroupId) {
+            ends.push_back(std::min<uint64_t>(span.data + size, ends.back()));
+            pos = static_cast<size_t>(span.data);
+        } else {
+            pos = static_cast<size_t>(span.data + size);
+        }
+    }
+    return found;
+}
+
+// Same frames by track, timecode, keyframe flag and payload bytes
+inline bool SameContent(const std::vector<RecordedFrame> &a, const std::vector<RecordedFrame> &b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].track != b[i].track || a[i].timecode_ns != b[i].timecode_ns || a[i].keyframe != b[i].keyframe ||
+            a[i].bytes != b[i].bytes) {
+            std::fprintf(stderr, "frame %zu differs: track %llu/%llu at %lld/%lld ns\n", i,
+                         (unsigned long long)a[i].track, (unsigned long long)b[i].track, (long long)a[i].timecode_ns,
+                         (long long)b[i].timecode_ns);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Tracks of MuxAvFile(): 1 video (V_VP9, 40 ms frames), 2 audio (A_OPUS, 20 ms frames)
+inline std::vector<MkvTrackInfo> AvTracks()
+{
+    MkvTrackInfo video;
+    video.track_number = 1;
+    video.codec_id = "V_VP9";
+    video.width = 320;
+    video.height = 240;
+    video.metadata["default_duration_ns"] = "40000000";
+    MkvTrackInfo audio;
+    audio.track_number = 2;
+    audio.codec_id = "A_OPUS";
+    audio.sample_rate = 48000;
+    audio.channels = 2;
+    audio.metadata["default_duration_ns"] = "20000000";
+    return {video, audio};
+}
+
+// Video and audio frames of duration_ms muxed with opts; video keyframes every gop_ms.
+// The frames written are returned in input, in write order.
+inline std::vector<uint8_t> MuxAvFile(const MkvMuxerOptions &opts, int64_t duration_ms,
+                                      std::vector<RecordedFrame> &input, int64_t gop_ms = 400)
+{
+    MkvMemoryWriter writer;
+    MkvMuxer muxer(opts);
+    muxer.SetWriter(&writer);
+    for (const auto &track : AvTracks()) {
+        muxer.AddTrack(track);
+    }
+    muxer.BeginSegment(MkvInfo());
+    for (int64_t ms = 0; ms < duration_ms; ms += 20) {
+        RecordedFrame r;
+        r.track = ms % 40 == 0 ? 1 : 2;
+        r.timecode_ns = ms * 1000000;
+        r.duration_ns = r.track == 1 ? 40000000 : 20000000;
+        r.keyframe = r.track == 2 || ms % gop_ms == 0;
+        r.bytes = Pattern(r.track == 1 ? 100 + static_cast<size_t>(ms / 40 % 50) : 20, static_cast<uint8_t>(ms / 20));
+        input.push_back(r);
+
+        MkvFrame frame;
+        frame.track_number = r.track;
+        frame.timecode_ns = r.timecode_ns;
+        frame.duration_ns = r.duration_ns;
+        frame.keyframe = r.keyframe;
+        frame.data = input.back().bytes.data();
+        frame.size = input.back().bytes.size();
+        muxer.WriteFrame(frame);
+    }
+    muxer.EndSegment();
+    return writer.Data();
+}
+
+// Hand-built Matroska file: track 1 video (V_VP9), track 2 audio (A_OPUS, 20 ms
+// DefaultDuration), 1 ms timecode scale, known element sizes and no SeekHead or Cues.
+// video_encodings, when given, is the payload of the video track's ContentEncodings.
+class FixtureBuilder {
+public:
+    explicit FixtureBuilder(const std::vector<uint8_t> &video_encodings = {})
+    {
+        size_t ebml = buf_.OpenMaster(kEbmlHeaderId);
+        buf_.PutUInt(kEbmlVersionId, 1);
+        buf_.PutUInt(kEbmlReadVersionId, 1);
+        buf_.PutUInt(kEbmlMaxIdLengthId, 4);
+        buf_.PutUInt(kEbmlMaxSizeLengthId, 8);
+        buf_.PutString(kDocTypeId, "matroska");
+        buf_.PutUInt(kDocTypeVersionId, 4);
+        buf_.PutUInt(kDocTypeReadVersionId, 2);
+        buf_.CloseMaster(ebml);
+
+        segment_ = buf_.OpenMaster(kSegmentId);
+        size_t info = buf_.OpenMaster(kInfoId);
+        buf_.PutUInt(kTimecodeScaleId, 1000000);
+        buf_.CloseMaster(info);
+
+        size_t tracks = buf_.OpenMaster(kTracksId);
+        size_t video = buf_.OpenMaster(kTrackEntryId);
+        buf_.PutUInt(kTrackNumberId, 1);
+        buf_.PutUInt(kTrackUidId, 1);
+        buf_.PutUInt(kTrackTypeId, 1);
+        buf_.PutString(kCodecId, "V_VP9");
+        if (!video_encodings.empty()) {
+            buf_.PutBinary(kContentEncodingsId, video_encodings.data(), video_encodings.size());
+        }
+        buf_.CloseMaster(video);
+        size_t audio = buf_.OpenMaster(kTrackEntryId);
+        buf_.PutUInt(kTrackNumberId, 2);
+        buf_.PutUInt(kTrackUidId, 2);
+        buf_.PutUInt(kTrackTypeId, 2);
+        buf_.PutString(kCodecId, "A_OPUS");
+        buf_.PutUInt(kDefaultDurationId, 20000000);
+        buf_.CloseMaster(audio);
+        buf_.CloseMaster(tracks);
+    }
+
+    void BeginCluster(uint64_t timecode_ms)
+    {
+        cluster_ = buf_.OpenMaster(kClusterId);
+        buf_.PutUInt(kClusterTimecodeId, timecode_ms);
+    }
+
+    void SimpleBlock(uint64_t track, int16_t timecode, bool keyframe, const std::vector<uint8_t> &payload)
+    {
+        auto b = BlockBytes(track, timecode, keyframe ? 0x80 : 0x00, payload);
+        buf_.PutBinary(kSimpleBlockId, b.data(), b.size());
+    }
+
+    // BlockGroup with a BlockDuration and, for reference != 0, a one-byte ReferenceBlock
+    void BlockGroup(uint64_t track, int16_t timecode, uint64_t duration, int8_t reference,
+                    const std::vector<uint8_t> &payload)
+    {
+        size_t group = buf_.OpenMaster(kBlockGroupId);
+        auto b = BlockBytes(track, timecode, 0x00, payload);
+        buf_.PutBinary(kBlockId, b.data(), b.size());
+        buf_.PutUInt(kBlockDurationId, duration);
+        if (reference != 0) {
+            uint8_t ref = static_cast<uint8_t>(reference);
+            buf_.PutBinary(kReferenceBlockId, &ref, 1);
+        }
+        buf_.CloseMaster(group);
+    }
+
+    // Keyframe SimpleBlock holding laces with Xiph lacing
+    void XiphLacedBlock(uint64_t track, int16_t timecode, const std::vector<std::vector<uint8_t>> &laces)
+    {
+        std::vector<uint8_t> payload = {static_cast<uint8_t>(laces.size() - 1)};
+        for (size_t i = 0; i + 1 < laces.size(); ++i) {
+            payload.insert(payload.end(), laces[i].size() / 255, 255);
+            payload.push_back(static_cast<uint8_t>(laces[i].size() % 255));
+        }
+        for (const auto &lace : laces) {
+            payload.insert(payload.end(), lace.begin(), lace.end());
+        }
+        auto b = BlockBytes(track, timecode, 0x80 | 0x02, payload);
+        buf_.PutBinary(kSimpleBlockId, b.data(), b.size());
+    }
+
+    // Bytes inside the current Cluster that are not an element (corruption)
+    void Raw(const std::vector<uint8_t> &bytes) { buf_.Bytes().insert(buf_.Bytes().end(), bytes.begin(), bytes.end()); }
+
+    void EndCluster() { buf_.CloseMaster(cluster_); }
+
+    size_t Size() const { return buf_.Size(); }
+
+    std::vector<uint8_t> Finish()
+    {
+        buf_.CloseMaster(segment_);
+        return buf_.Bytes();
+    }
+
+private:
+    EbmlBuffer buf_;
+    size_t segment_ = 0;
+    size_t cluster_ = 0;
+};
+
+} // namespace lmshao::lmmkv::test
+
+#endif // LMSHAO_LMMKV_TEST_UTIL_H